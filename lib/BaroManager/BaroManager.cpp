@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <BaroManager.h>
+#include <GPSClock.h>
 
 BaroManager::BaroManager(){
     _pressureRaw = 0;
@@ -9,7 +10,7 @@ BaroManager::BaroManager(){
     _temperature = 0;
     _pressureZero = 0;
     _pressureFiltered = 0;
-    _timestamp = 0;
+    _time = 0;
     _timerBaro = 0;
     difft = 0;
     off = 0;
@@ -21,6 +22,7 @@ BaroManager::BaroManager(){
   {
     if(micros()-_timerBaro>15000) {
       acquireBaroData();
+      _time = gpsClock.now();
       _pressureFiltered = _pressureZero+filter.compute(_pressure-_pressureZero);
       setTimer(micros());
     }
@@ -117,18 +119,13 @@ BaroManager::BaroManager(){
     setTimer(micros());
   }
 
-  void BaroManager::setTimer(int timer){
+  void BaroManager::setTimer(unsigned long timer){
     _timerBaro = timer;
   }
 
   BaroData_t BaroManager::getData(){
     BaroData_t data;
     data.pressureFiltered = _pressureFiltered;
-    data.timestamp = _timestamp;
+    data.time = _time;
     return data;
   }
-
-  void BaroManager::updateTimestamp()
-  {
-    _timestamp++;
-  }
@@ -12,7 +12,6 @@ public:
   BaroManager();
   void init();
   long process(); /* Acquire and filter baro data */
-  void updateTimestamp();
   BaroData_t getData();
 
 private:
@@ -22,10 +21,10 @@ private:
   volatile bool convert_pression;
   volatile long _temperatureRaw,_temperature,_pressureRaw,_pressure,_pressureZero,_pressureFiltered;
   int64_t difft,off,sens;
-  int _timestamp;
-  int _timerBaro;
+  uint64_t _time;
+  unsigned long _timerBaro;
   Butterworth filter;
-  void setTimer(int timer);
+  void setTimer(unsigned long timer);
   void acquirePressureZero();
   void acquireBaroData();
 };
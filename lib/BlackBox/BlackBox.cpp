@@ -0,0 +1,350 @@
+#include <BlackBox.h>
+#include <string.h>
+
+static const uint32_t PAGES_PER_SECTOR = BlackBoxStorage::SECTOR_SIZE / BlackBoxStorage::PAGE_SIZE;
+
+static void writeU32(uint8_t* p, uint32_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t readU32(const uint8_t* p)
+{
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t pageCount(BlackBoxStorage& storage)
+{
+  return storage.size() / BlackBoxStorage::SECTOR_SIZE * PAGES_PER_SECTOR;
+}
+
+BlackBox::BlackBox(BlackBoxStorage& storage) : _storage(storage){
+  _pageCount = 0;
+  _fill = 0;
+  _fillLen = 0;
+  _pending = -1;
+  _nextPage = 0;
+  _erasedUntil = 0;
+  _dropped = 0;
+  _ready = false;
+  _decimation = 0;
+  _lastPVT = 0;
+  _lastBaro = 0;
+}
+
+bool BlackBox::init()
+{
+  uint32_t first = 0;
+  uint32_t last = 0;
+
+  _pageCount = pageCount(_storage);
+  if (_pageCount == 0) {
+    return false;
+  }
+  // A fresh sector : what follows the last page may be a torn write
+  _nextPage = scan(_storage, &first, &last) ? (last / PAGES_PER_SECTOR + 1) * PAGES_PER_SECTOR : 0;
+  _erasedUntil = _nextPage;
+  _pending = -1;
+  _fill = 0;
+  startPage();
+  _ready = true;
+  return append(BLACKBOX_SESSION, NULL, 0);
+}
+
+bool BlackBox::append(uint8_t type, const void* data, uint8_t len)
+{
+  if (!_ready || len > BLACKBOX_MAX_RECORD) {
+    return false;
+  }
+  if (_fillLen + BLACKBOX_RECORD_HEADER_SIZE + len > BlackBoxStorage::PAGE_SIZE && !closePage()) {
+    // Both buffers full : process() is not called often enough
+    _dropped++;
+    return false;
+  }
+
+  uint8_t* record = (uint8_t*)_pages[_fill] + _fillLen;
+  uint16_t crc = crc16(0xFFFF, &type, 1);
+  crc = crc16(crc, &len, 1);
+  crc = crc16(crc, (const uint8_t*)data, len);
+  record[0] = BLACKBOX_RECORD_SYNC;
+  record[1] = type;
+  record[2] = len;
+  record[3] = crc & 0xFF;
+  record[4] = crc >> 8;
+  if (len > 0) {
+    memcpy(record + BLACKBOX_RECORD_HEADER_SIZE, data, len);
+  }
+  _fillLen += BLACKBOX_RECORD_HEADER_SIZE + len;
+  return true;
+}
+
+bool BlackBox::appendPVT(uint64_t time, const uint8_t* payload, uint8_t len)
+{
+  uint8_t data[BLACKBOX_MAX_RECORD];
+
+  if (len > BLACKBOX_MAX_RECORD - sizeof(time)) {
+    return false;
+  }
+  if (decimate(time, &_lastPVT, _decimation)) {
+    return true;
+  }
+  memcpy(data, &time, sizeof(time));
+  memcpy(data + sizeof(time), payload, len);
+  return append(BLACKBOX_PVT, data, sizeof(time) + len);
+}
+
+bool BlackBox::appendBaro(uint64_t time, int32_t pressure)
+{
+  uint8_t data[sizeof(time) + sizeof(pressure)];
+
+  if (decimate(time, &_lastBaro, _decimation)) {
+    return true;
+  }
+  memcpy(data, &time, sizeof(time));
+  memcpy(data + sizeof(time), &pressure, sizeof(pressure));
+  return append(BLACKBOX_BARO, data, sizeof(data));
+}
+
+void BlackBox::setDecimation(uint32_t interval)
+{
+  _decimation = interval;
+}
+
+bool BlackBox::decimate(uint64_t time, uint64_t* last, uint32_t interval)
+{
+  // A clock going back keeps the record
+  if (interval > 0 && *last != 0 && time >= *last && time - *last < interval) {
+    return true;
+  }
+  *last = time;
+  return false;
+}
+
+void BlackBox::process()
+{
+  if (!_ready) {
+    return;
+  }
+  // One flash operation per call, the sector after the current one is kept erased
+  if (_pending >= 0) {
+    writePending();
+  } else if (_erasedUntil <= _nextPage + PAGES_PER_SECTOR) {
+    eraseNext();
+  }
+}
+
+void BlackBox::flush()
+{
+  if (!_ready) {
+    return;
+  }
+  if (_pending >= 0) {
+    writePending();
+  }
+  if (_fillLen > (uint32_t)BLACKBOX_PAGE_HEADER_SIZE) {
+    closePage();
+    writePending();
+  }
+}
+
+uint32_t BlackBox::getDropped()
+{
+  return _dropped;
+}
+
+uint16_t BlackBox::crc16(uint16_t crc, const uint8_t* data, size_t len)
+{
+  // CRC-16/CCITT-FALSE
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int j = 0; j < 8; j++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+bool BlackBox::scan(BlackBoxStorage& storage, uint32_t* first, uint32_t* last)
+{
+  uint32_t count = pageCount(storage);
+  uint8_t header[BLACKBOX_PAGE_HEADER_SIZE];
+  bool found = false;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (!storage.read(i * BlackBoxStorage::PAGE_SIZE, header, sizeof(header))
+        || readU32(header) != BLACKBOX_PAGE_MAGIC) {
+      continue;
+    }
+    uint32_t page = readU32(header + 4);
+    if (page % count != i) {
+      continue;
+    }
+    if (!found || page > *last) {
+      *last = page;
+    }
+    found = true;
+  }
+  if (!found) {
+    return false;
+  }
+
+  // Oldest page still there, at most one full turn before the last one
+  *first = *last;
+  for (uint32_t i = 0; i < count; i++) {
+    if (!storage.read(i * BlackBoxStorage::PAGE_SIZE, header, sizeof(header))
+        || readU32(header) != BLACKBOX_PAGE_MAGIC) {
+      continue;
+    }
+    uint32_t page = readU32(header + 4);
+    if (page % count == i && page < *first && *last - page < count) {
+      *first = page;
+    }
+  }
+  return true;
+}
+
+void BlackBox::startPage()
+{
+  uint8_t* page = (uint8_t*)_pages[_fill];
+
+  memset(page, 0xFF, BlackBoxStorage::PAGE_SIZE);
+  writeU32(page, BLACKBOX_PAGE_MAGIC);
+  writeU32(page + 4, _nextPage);
+  _fillLen = BLACKBOX_PAGE_HEADER_SIZE;
+}
+
+bool BlackBox::closePage()
+{
+  if (_pending >= 0) {
+    return false;
+  }
+  _pending = _fill;
+  _fill ^= 1;
+  _nextPage++;
+  startPage();
+  return true;
+}
+
+bool BlackBox::writePending()
+{
+  const uint8_t* page = (const uint8_t*)_pages[_pending];
+  uint32_t number = readU32(page + 4);
+  bool res = true;
+
+  // process() did not keep up with the erases, catch up now
+  while (res && number >= _erasedUntil) {
+    res = eraseNext();
+  }
+  if (res) {
+    res = _storage.write((number % _pageCount) * BlackBoxStorage::PAGE_SIZE, page, BlackBoxStorage::PAGE_SIZE);
+  }
+  if (!res) {
+    _dropped++;
+  }
+  _pending = -1;
+  return res;
+}
+
+bool BlackBox::eraseNext()
+{
+  uint32_t sector = (_erasedUntil % _pageCount) / PAGES_PER_SECTOR;
+
+  _erasedUntil += PAGES_PER_SECTOR;
+  return _storage.erase(sector);
+}
+
+BlackBoxReader::BlackBoxReader(BlackBoxStorage& storage) : _storage(storage){
+  _first = 0;
+  _last = 0;
+  _empty = true;
+  _current = 0;
+  _offset = BlackBoxStorage::PAGE_SIZE;
+}
+
+bool BlackBoxReader::begin()
+{
+  _empty = !BlackBox::scan(_storage, &_first, &_last);
+  _current = _first;
+  _offset = BlackBoxStorage::PAGE_SIZE;
+  return !_empty;
+}
+
+bool BlackBoxReader::next(BlackBoxRecord_t* record)
+{
+  if (_empty) {
+    return false;
+  }
+  while (true) {
+    if (_offset + BLACKBOX_RECORD_HEADER_SIZE > BlackBoxStorage::PAGE_SIZE
+        || _page[_offset] != BLACKBOX_RECORD_SYNC) {
+      // End of page, on to the next one still in storage
+      bool loaded = false;
+      while (!loaded) {
+        if (_current - _first > _last - _first) {
+          return false;
+        }
+        loaded = loadPage(_current++);
+      }
+      continue;
+    }
+
+    const uint8_t* data = _page + _offset;
+    uint8_t len = data[2];
+    if (_offset + BLACKBOX_RECORD_HEADER_SIZE + len > BlackBoxStorage::PAGE_SIZE
+        || BlackBox::crc16(BlackBox::crc16(0xFFFF, data + 1, 2), data + BLACKBOX_RECORD_HEADER_SIZE, len)
+          != (data[3] | (data[4] << 8))) {
+      // Torn write, nothing after it in this page can be trusted
+      _offset = BlackBoxStorage::PAGE_SIZE;
+      continue;
+    }
+    record->page = _current - 1;
+    record->type = data[1];
+    record->len = len;
+    memcpy(record->data, data + BLACKBOX_RECORD_HEADER_SIZE, len);
+    _offset += BLACKBOX_RECORD_HEADER_SIZE + len;
+    return true;
+  }
+}
+
+uint32_t BlackBoxReader::getPageCount()
+{
+  return _empty ? 0 : _last - _first + 1;
+}
+
+uint32_t BlackBoxReader::getFirstPage()
+{
+  return _first;
+}
+
+bool BlackBoxReader::readPage(uint32_t index, uint8_t* page)
+{
+  uint32_t count = pageCount(_storage);
+  uint32_t number = _first + index;
+
+  if (index >= getPageCount()) {
+    return false;
+  }
+  if (!_storage.read((number % count) * BlackBoxStorage::PAGE_SIZE, page, BlackBoxStorage::PAGE_SIZE)) {
+    return false;
+  }
+  if (readU32(page) != BLACKBOX_PAGE_MAGIC || readU32(page + 4) != number) {
+    memset(page, 0xFF, BlackBoxStorage::PAGE_SIZE);
+  }
+  return true;
+}
+
+bool BlackBoxReader::loadPage(uint32_t page)
+{
+  uint32_t count = pageCount(_storage);
+
+  _offset = BlackBoxStorage::PAGE_SIZE;
+  if (!_storage.read((page % count) * BlackBoxStorage::PAGE_SIZE, _page, sizeof(_page))
+      || readU32(_page) != BLACKBOX_PAGE_MAGIC || readU32(_page + 4) != page) {
+    return false;
+  }
+  _offset = BLACKBOX_PAGE_HEADER_SIZE;
+  return true;
+}
@@ -0,0 +1,103 @@
+#ifndef BlackBox_h
+#define BlackBox_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <BlackBoxStorage.h>
+
+/* Append-only flight log on raw flash. Records are batched in RAM into 256
+ * bytes pages, process() writes at most one page or erases one sector per
+ * call, one sector ahead of the writes. Page n of the log goes to page
+ * n % pages of the storage, overwriting the oldest sector once it wraps.
+ *
+ * Page : magic (4), page number (4), records, 0xFF up to the end.
+ * Record : sync 0xA5, type, payload length, CRC-16 of type, length and
+ * payload (2, little endian), payload.
+ * A power loss costs the pages still in RAM, a torn page write is caught by
+ * the record CRCs. Each boot starts on a fresh sector.
+ *
+ * Retention : a 25 Hz epoch (PVT 105 bytes, baro 17 bytes with headers) fills
+ * half a page, and one to two sectors are kept erased ahead. The 128 KB region
+ * of platformio.ini holds 960 to 992 epochs : 38.4 s at full rate, 16 min
+ * decimated to 1 Hz. Each sector is then erased every 41 s at full rate, every
+ * 16 min at 1 Hz. */
+typedef enum {
+  BLACKBOX_SESSION = 1, /* Empty, written at boot */
+  BLACKBOX_PVT,         /* GPSClock time (8), raw UBX NAV-PVT payload */
+  BLACKBOX_BARO         /* GPSClock time (8), filtered pressure [Pa] (4) */
+} BlackBoxRecordType_t;
+
+const uint32_t BLACKBOX_PAGE_MAGIC = 0x31584242; /* "BBX1" */
+const uint8_t BLACKBOX_RECORD_SYNC = 0xA5;
+const int BLACKBOX_PAGE_HEADER_SIZE = 8;
+const int BLACKBOX_RECORD_HEADER_SIZE = 5;
+const int BLACKBOX_MAX_RECORD = BlackBoxStorage::PAGE_SIZE - BLACKBOX_PAGE_HEADER_SIZE - BLACKBOX_RECORD_HEADER_SIZE;
+
+typedef struct {
+  uint32_t page;  /* Log page number the record was read from */
+  uint8_t type;
+  uint8_t len;
+  uint8_t data[BLACKBOX_MAX_RECORD];
+} BlackBoxRecord_t;
+
+class BlackBox {
+public:
+  BlackBox(BlackBoxStorage& storage);
+  bool init(); /* Find the end of the log and start a session */
+  bool append(uint8_t type, const void* data, uint8_t len);
+  bool appendPVT(uint64_t time, const uint8_t* payload, uint8_t len);
+  bool appendBaro(uint64_t time, int32_t pressure);
+  /* Keep one PVT and one baro record per interval [us] of their time, 0 keeps
+   * every one. Skipped records are not dropped ones. */
+  void setDecimation(uint32_t interval);
+  void process();
+  void flush(); /* Write everything now, partial page included */
+  uint32_t getDropped(); /* Records refused while both page buffers were full */
+  static uint16_t crc16(uint16_t crc, const uint8_t* data, size_t len);
+  /* Log pages still in storage : first (oldest) and last page numbers */
+  static bool scan(BlackBoxStorage& storage, uint32_t* first, uint32_t* last);
+private:
+  BlackBoxStorage& _storage;
+  uint32_t _pageCount;
+  uint32_t _pages[2][BlackBoxStorage::PAGE_SIZE / 4]; /* Word aligned for the flash API */
+  int _fill;            /* Page buffer being filled */
+  uint32_t _fillLen;
+  int _pending;         /* Full page buffer waiting for process(), -1 if none */
+  uint32_t _nextPage;   /* Log page number of the buffer being filled */
+  uint32_t _erasedUntil;/* First log page not in an erased sector */
+  uint32_t _dropped;
+  bool _ready;
+  uint32_t _decimation; /* [us] */
+  uint64_t _lastPVT;    /* [us] time of the last record kept, 0 if none */
+  uint64_t _lastBaro;
+  static bool decimate(uint64_t time, uint64_t* last, uint32_t interval);
+  void startPage();
+  bool closePage();
+  bool writePending();
+  bool eraseNext();
+};
+
+/* Reads the log back, oldest first. Pages still in a BlackBox RAM buffer are
+ * not seen, flush() it first. */
+class BlackBoxReader {
+public:
+  BlackBoxReader(BlackBoxStorage& storage);
+  bool begin();
+  bool next(BlackBoxRecord_t* record); /* False at the end of the log */
+  /* Flat image of the log, one PAGE_SIZE page per log page from the oldest,
+   * pages lost to a crash read as erased */
+  uint32_t getPageCount();
+  uint32_t getFirstPage(); /* Log page number of index 0, changes once the ring wraps */
+  bool readPage(uint32_t index, uint8_t* page);
+private:
+  BlackBoxStorage& _storage;
+  uint32_t _first;
+  uint32_t _last;
+  bool _empty;
+  uint32_t _current;    /* Log page number in _page */
+  uint32_t _offset;     /* In _page, PAGE_SIZE when a new page is needed */
+  uint8_t _page[BlackBoxStorage::PAGE_SIZE];
+  bool loadPage(uint32_t page);
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include <BlackBoxExport.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char CSV_HEADER[] = "page,type,time,iTOW,lat,lon,height,velN,velE,velD,numSV,pressure\n";
+
+static int32_t readI32(const uint8_t* p)
+{
+  return (int32_t)(p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+// No 64 bits in the ESP8266 printf
+static char* putU64(char* dst, uint64_t v)
+{
+  char digits[20];
+  int n = 0;
+
+  do {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v > 0);
+  while (n > 0) {
+    *dst++ = digits[--n];
+  }
+  return dst;
+}
+
+static char* putI32(char* dst, int32_t v)
+{
+  if (v < 0) {
+    *dst++ = '-';
+    return putU64(dst, -(int64_t)v);
+  }
+  return putU64(dst, v);
+}
+
+static char* putText(char* dst, const char* s)
+{
+  while (*s) {
+    *dst++ = *s++;
+  }
+  return dst;
+}
+
+BlackBoxCsv::BlackBoxCsv(BlackBoxReader& reader) : _reader(reader){
+  _lineLen = 0;
+  _linePos = 0;
+}
+
+bool BlackBoxCsv::begin()
+{
+  _lineLen = strlen(CSV_HEADER);
+  _linePos = 0;
+  memcpy(_line, CSV_HEADER, _lineLen);
+  return _reader.begin();
+}
+
+size_t BlackBoxCsv::read(char* dst, size_t maxLen)
+{
+  size_t len = 0;
+
+  while (len < maxLen) {
+    if (_linePos == _lineLen && !nextLine()) {
+      break;
+    }
+    size_t chunk = _lineLen - _linePos;
+    if (chunk > maxLen - len) {
+      chunk = maxLen - len;
+    }
+    memcpy(dst + len, _line + _linePos, chunk);
+    _linePos += chunk;
+    len += chunk;
+  }
+  return len;
+}
+
+bool BlackBoxCsv::nextLine()
+{
+  uint64_t time;
+
+  if (!_reader.next(&_record)) {
+    return false;
+  }
+  char* p = putU64(_line, _record.page);
+  *p++ = ',';
+  if (_record.type == BLACKBOX_SESSION) {
+    p = putText(p, "session,,,,,,,,,,");
+  } else if (_record.type == BLACKBOX_PVT && _record.len >= sizeof(time) + 60) {
+    const uint8_t* pvt = _record.data + sizeof(time);
+    const int fields[] = { 28, 24, 32, 48, 52, 56 }; // lat, lon, height, velN, velE, velD
+    memcpy(&time, _record.data, sizeof(time));
+    p = putText(p, "pvt,");
+    p = putU64(p, time);
+    *p++ = ',';
+    p = putU64(p, (uint32_t)readI32(pvt));
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+      *p++ = ',';
+      p = putI32(p, readI32(pvt + fields[i]));
+    }
+    *p++ = ',';
+    p = putU64(p, pvt[23]);
+    *p++ = ',';
+  } else if (_record.type == BLACKBOX_BARO && _record.len == sizeof(time) + 4) {
+    memcpy(&time, _record.data, sizeof(time));
+    p = putText(p, "baro,");
+    p = putU64(p, time);
+    p = putText(p, ",,,,,,,,,");
+    p = putI32(p, readI32(_record.data + sizeof(time)));
+  } else {
+    p = putU64(p, _record.type);
+    p = putText(p, ",,,,,,,,,,");
+  }
+  *p++ = '\n';
+  _lineLen = p - _line;
+  _linePos = 0;
+  return true;
+}
+
+BlackBoxRange_t blackBoxParseRange(const char* header, uint32_t size, uint32_t* first, uint32_t* last)
+{
+  char* end;
+
+  if (header == NULL || strncmp(header, "bytes=", 6) != 0 || strchr(header, ',') != NULL) {
+    return BLACKBOX_RANGE_NONE;
+  }
+  header += 6;
+  if (*header == '-') {
+    // Suffix : the last n bytes
+    unsigned long count = strtoul(header + 1, &end, 10);
+    if (end == header + 1 || *end != '\0') {
+      return BLACKBOX_RANGE_NONE;
+    }
+    if (count == 0 || size == 0) {
+      return BLACKBOX_RANGE_UNSATISFIABLE;
+    }
+    *first = count < size ? size - count : 0;
+    *last = size - 1;
+    return BLACKBOX_RANGE_OK;
+  }
+
+  unsigned long from = strtoul(header, &end, 10);
+  if (end == header || *end != '-') {
+    return BLACKBOX_RANGE_NONE;
+  }
+  header = end + 1;
+  unsigned long to = size - 1;
+  if (*header != '\0') {
+    to = strtoul(header, &end, 10);
+    if (end == header || *end != '\0' || to < from) {
+      return BLACKBOX_RANGE_NONE;
+    }
+  }
+  if (from >= size) {
+    return BLACKBOX_RANGE_UNSATISFIABLE;
+  }
+  *first = from;
+  *last = to < size ? to : size - 1;
+  return BLACKBOX_RANGE_OK;
+}
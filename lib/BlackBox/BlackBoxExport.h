@@ -0,0 +1,35 @@
+#ifndef BlackBoxExport_h
+#define BlackBoxExport_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <BlackBox.h>
+
+const int BLACKBOX_CSV_LINE = 160;
+
+/* The log as CSV text, read in chunks of any size : only one record and its
+ * line are held in RAM */
+class BlackBoxCsv {
+public:
+  BlackBoxCsv(BlackBoxReader& reader);
+  bool begin(); /* Rewinds the reader, the header line comes first */
+  size_t read(char* dst, size_t maxLen); /* 0 at the end of the log */
+private:
+  BlackBoxReader& _reader;
+  BlackBoxRecord_t _record;
+  char _line[BLACKBOX_CSV_LINE];
+  size_t _lineLen;
+  size_t _linePos;
+  bool nextLine();
+};
+
+typedef enum {
+  BLACKBOX_RANGE_NONE,          /* No or unsupported Range : send everything */
+  BLACKBOX_RANGE_OK,
+  BLACKBOX_RANGE_UNSATISFIABLE  /* 416 */
+} BlackBoxRange_t;
+
+/* Single "bytes=" range of a size bytes resource, first and last inclusive */
+BlackBoxRange_t blackBoxParseRange(const char* header, uint32_t size, uint32_t* first, uint32_t* last);
+
+#endif
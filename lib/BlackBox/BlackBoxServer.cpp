@@ -0,0 +1,154 @@
+#ifdef ARDUINO
+#include <BlackBoxServer.h>
+
+BlackBoxServer::BlackBoxServer(BlackBox& blackBox, BlackBoxStorage& storage) :
+  _blackBox(blackBox), _reader(storage), _csv(_reader){
+  _server = NULL;
+  _stream = STREAM_IDLE;
+  _offset = 0;
+  _last = 0;
+}
+
+void BlackBoxServer::attach(ESP8266WebServer* server)
+{
+  const char* headers[] = { "Range", "If-Range" };
+
+  _server = server;
+  _server->collectHeaders(headers, 2);
+  _server->on("/log.csv", std::bind(&BlackBoxServer::handleCsv, this));
+  _server->on("/log.bin", std::bind(&BlackBoxServer::handleBinary, this));
+}
+
+void BlackBoxServer::process()
+{
+  if (_stream == STREAM_IDLE) {
+    return;
+  }
+  if (!_client.connected()) {
+    stop();
+    return;
+  }
+  for (int i = 0; i < BLACKBOX_SERVER_CHUNKS; i++) {
+    bool more = _stream == STREAM_CSV ? sendCsvChunk() : sendBinaryChunk();
+    if (!more) {
+      stop();
+      return;
+    }
+  }
+}
+
+void BlackBoxServer::handleCsv()
+{
+  // The pages still in RAM are part of the download
+  _blackBox.flush();
+  _csv.begin();
+  start(STREAM_CSV,
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/csv\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Transfer-Encoding: chunked\r\n");
+}
+
+void BlackBoxServer::handleBinary()
+{
+  uint32_t first = 0;
+  uint32_t last = 0;
+  BlackBoxRange_t range = BLACKBOX_RANGE_NONE;
+
+  _blackBox.flush();
+  _reader.begin();
+  uint32_t size = _reader.getPageCount() * BlackBoxStorage::PAGE_SIZE;
+  String etag = String("\"") + _reader.getFirstPage() + "\"";
+
+  // A resume against a wrapped log would splice two different images
+  if (_server->hasHeader("Range")
+      && (!_server->hasHeader("If-Range") || _server->header("If-Range") == etag)) {
+    range = blackBoxParseRange(_server->header("Range").c_str(), size, &first, &last);
+  }
+  if (range == BLACKBOX_RANGE_UNSATISFIABLE) {
+    _server->sendHeader("Accept-Ranges", "bytes");
+    _server->sendHeader("ETag", etag);
+    _server->sendHeader("Content-Range", String("bytes */") + size);
+    _server->send(416, "text/plain", "");
+    return;
+  }
+
+  String headers = range == BLACKBOX_RANGE_OK ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+  headers += "Content-Type: application/octet-stream\r\n";
+  headers += "Accept-Ranges: bytes\r\n";
+  headers += "ETag: " + etag + "\r\n";
+  if (range == BLACKBOX_RANGE_NONE) {
+    first = 0;
+    last = size - 1;
+  } else {
+    headers += String("Content-Range: bytes ") + first + "-" + last + "/" + size + "\r\n";
+  }
+  headers += String("Content-Length: ") + (size == 0 ? 0 : last - first + 1) + "\r\n";
+  _offset = first;
+  _last = size == 0 ? 0 : last;
+  start(size == 0 ? STREAM_IDLE : STREAM_BINARY, headers);
+}
+
+void BlackBoxServer::start(Stream_t stream, const String& headers)
+{
+  // Written to the client directly : the server would end the body once
+  // the handler returns
+  stop();
+  _client = _server->client();
+  _client.print(headers);
+  _client.print("Connection: close\r\n\r\n");
+  _stream = stream;
+  if (_stream == STREAM_IDLE) {
+    stop();
+  }
+}
+
+void BlackBoxServer::stop()
+{
+  _client.stop();
+  _client = WiFiClient();
+  _stream = STREAM_IDLE;
+}
+
+bool BlackBoxServer::sendCsvChunk()
+{
+  char size[8];
+  size_t len = _csv.read(_chunk, sizeof(_chunk));
+
+  snprintf(size, sizeof(size), "%x\r\n", (unsigned)len);
+  _client.write((const uint8_t*)size, strlen(size));
+  if (len == 0) {
+    _client.write((const uint8_t*)"\r\n", 2); // last chunk
+    return false;
+  }
+  _client.write((const uint8_t*)_chunk, len);
+  _client.write((const uint8_t*)"\r\n", 2);
+  return true;
+}
+
+bool BlackBoxServer::sendBinaryChunk()
+{
+  // Whole pages are read into the chunk, only the slice asked for goes out
+  uint32_t len = 0;
+  while (len < sizeof(_chunk) && _offset + len <= _last) {
+    uint32_t index = (_offset + len) / BlackBoxStorage::PAGE_SIZE;
+    uint32_t skip = (_offset + len) % BlackBoxStorage::PAGE_SIZE;
+    uint32_t count = BlackBoxStorage::PAGE_SIZE - skip;
+    if (count > _last - (_offset + len) + 1) {
+      count = _last - (_offset + len) + 1;
+    }
+    if (count > sizeof(_chunk) - len) {
+      count = sizeof(_chunk) - len;
+    }
+    uint8_t page[BlackBoxStorage::PAGE_SIZE];
+    if (!_reader.readPage(index, page)) {
+      return false; // Short body, the client resumes
+    }
+    memcpy(_chunk + len, page + skip, count);
+    len += count;
+  }
+  _client.write((const uint8_t*)_chunk, len);
+  _offset += len;
+  return _offset <= _last;
+}
+#endif
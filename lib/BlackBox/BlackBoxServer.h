@@ -0,0 +1,49 @@
+#ifndef BlackBoxServer_h
+#define BlackBoxServer_h
+
+#ifdef ARDUINO
+#include <ESP8266WebServer.h>
+#include <BlackBox.h>
+#include <BlackBoxExport.h>
+
+const int BLACKBOX_SERVER_CHUNK = 4 * BlackBoxStorage::PAGE_SIZE;
+const int BLACKBOX_SERVER_CHUNKS = 2; /* Per process() call */
+
+/* Log download on a web server, the config portal one :
+ *   /log.csv  chunked CSV, see BlackBoxCsv
+ *   /log.bin  flat page image (BlackBoxReader::readPage), Range and If-Range
+ *             for resume, the ETag changes once the ring wraps
+ * The handlers only answer with the headers, process() then streams the body
+ * from the main loop a few chunks at a time so sampling goes on. One download
+ * at a time, a new request ends the one in progress. */
+class BlackBoxServer {
+public:
+  BlackBoxServer(BlackBox& blackBox, BlackBoxStorage& storage);
+  void attach(ESP8266WebServer* server); /* Before server->begin() */
+  void process();
+private:
+  typedef enum {
+    STREAM_IDLE,
+    STREAM_CSV,
+    STREAM_BINARY
+  } Stream_t;
+
+  BlackBox& _blackBox;
+  BlackBoxReader _reader;
+  BlackBoxCsv _csv;
+  ESP8266WebServer* _server;
+  WiFiClient _client;   /* Kept after the handler returns, the server lets it go */
+  Stream_t _stream;
+  uint32_t _offset;     /* Next byte of the binary range */
+  uint32_t _last;
+  char _chunk[BLACKBOX_SERVER_CHUNK];
+  void handleCsv();
+  void handleBinary();
+  void start(Stream_t stream, const String& headers);
+  void stop();
+  bool sendCsvChunk();
+  bool sendBinaryChunk();
+};
+#endif
+
+#endif
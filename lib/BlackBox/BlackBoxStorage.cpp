@@ -0,0 +1,189 @@
+#include <BlackBoxStorage.h>
+#include <string.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+
+extern "C" uint32_t _SPIFFS_start;
+extern "C" uint32_t _SPIFFS_end;
+
+static const uint32_t FLASH_MAPPED_BASE = 0x40200000;
+
+FlashStorage::FlashStorage(){
+  _start = (uint32_t)&_SPIFFS_start - FLASH_MAPPED_BASE;
+  _size = (uint32_t)&_SPIFFS_end - (uint32_t)&_SPIFFS_start;
+}
+
+FlashStorage::FlashStorage(uint32_t start, uint32_t size){
+  _start = start;
+  _size = size;
+}
+
+uint32_t FlashStorage::size()
+{
+  return _size;
+}
+
+bool FlashStorage::read(uint32_t address, void* data, uint32_t len)
+{
+  // The SDK reads whole aligned words : go through a bounce buffer
+  uint32_t words[PAGE_SIZE / 4];
+  uint8_t* dst = (uint8_t*)data;
+
+  if (address + len > _size) {
+    return false;
+  }
+  while (len > 0) {
+    uint32_t offset = address & 3;
+    uint32_t chunk = len + offset > sizeof(words) ? sizeof(words) - offset : len;
+    uint32_t aligned = (chunk + offset + 3) & ~3;
+    if (!ESP.flashRead(_start + address - offset, words, aligned)) {
+      return false;
+    }
+    memcpy(dst, (uint8_t*)words + offset, chunk);
+    dst += chunk;
+    address += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+bool FlashStorage::write(uint32_t address, const void* data, uint32_t len)
+{
+  uint32_t words[PAGE_SIZE / 4];
+  const uint8_t* src = (const uint8_t*)data;
+
+  if (address + len > _size || (address & 3) || (len & 3)) {
+    return false;
+  }
+  while (len > 0) {
+    uint32_t chunk = len > sizeof(words) ? sizeof(words) : len;
+    memcpy(words, src, chunk);
+    if (!ESP.flashWrite(_start + address, words, chunk)) {
+      return false;
+    }
+    src += chunk;
+    address += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+bool FlashStorage::erase(uint32_t sector)
+{
+  if ((sector + 1) * SECTOR_SIZE > _size) {
+    return false;
+  }
+  return ESP.flashEraseSector(_start / SECTOR_SIZE + sector);
+}
+
+#else
+
+FileStorage::FileStorage(){
+  _file = NULL;
+  _size = 0;
+  _readOnly = false;
+}
+
+FileStorage::~FileStorage(){
+  close();
+}
+
+bool FileStorage::open(const char* path, uint32_t size, bool readOnly)
+{
+  close();
+  _size = size;
+  _readOnly = readOnly;
+  if (readOnly) {
+    _file = fopen(path, "rb");
+    return _file != NULL;
+  }
+  _file = fopen(path, "r+b");
+  if (_file == NULL) {
+    _file = fopen(path, "w+b");
+    if (_file == NULL) {
+      return false;
+    }
+  }
+  // Grow the image as erased flash
+  fseek(_file, 0, SEEK_END);
+  long current = ftell(_file);
+  for (long i = current; i < (long)size; i++) {
+    fputc(0xFF, _file);
+  }
+  fflush(_file);
+  return true;
+}
+
+void FileStorage::close()
+{
+  if (_file != NULL) {
+    fclose(_file);
+    _file = NULL;
+  }
+}
+
+uint32_t FileStorage::size()
+{
+  return _size;
+}
+
+bool FileStorage::read(uint32_t address, void* data, uint32_t len)
+{
+  if (_file == NULL || address + len > _size) {
+    return false;
+  }
+  fseek(_file, address, SEEK_SET);
+  size_t got = fread(data, 1, len, _file);
+  if (got < len && _readOnly) {
+    memset((uint8_t*)data + got, 0xFF, len - got);
+    return true;
+  }
+  return got == len;
+}
+
+bool FileStorage::write(uint32_t address, const void* data, uint32_t len)
+{
+  uint8_t current[PAGE_SIZE];
+  const uint8_t* src = (const uint8_t*)data;
+
+  if (_file == NULL || _readOnly || address + len > _size || (address & 3) || (len & 3)) {
+    return false;
+  }
+  // Like NOR flash, a write only clears bits
+  while (len > 0) {
+    uint32_t chunk = len > sizeof(current) ? sizeof(current) : len;
+    if (!read(address, current, chunk)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < chunk; i++) {
+      current[i] &= src[i];
+    }
+    fseek(_file, address, SEEK_SET);
+    if (fwrite(current, 1, chunk, _file) != chunk) {
+      return false;
+    }
+    src += chunk;
+    address += chunk;
+    len -= chunk;
+  }
+  fflush(_file);
+  return true;
+}
+
+bool FileStorage::erase(uint32_t sector)
+{
+  uint8_t erased[SECTOR_SIZE];
+
+  if (_file == NULL || _readOnly || (sector + 1) * SECTOR_SIZE > _size) {
+    return false;
+  }
+  memset(erased, 0xFF, sizeof(erased));
+  fseek(_file, sector * SECTOR_SIZE, SEEK_SET);
+  if (fwrite(erased, 1, sizeof(erased), _file) != sizeof(erased)) {
+    return false;
+  }
+  fflush(_file);
+  return true;
+}
+
+#endif
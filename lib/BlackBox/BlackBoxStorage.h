@@ -0,0 +1,61 @@
+#ifndef BlackBoxStorage_h
+#define BlackBoxStorage_h
+
+#include <stdint.h>
+#include <stddef.h>
+#ifndef ARDUINO
+#include <stdio.h>
+#endif
+
+/* NOR flash seen by BlackBox : erase sets a whole sector to 0xFF, writes can
+ * only clear bits. Addresses are relative to the start of the region and
+ * writes are page aligned. */
+class BlackBoxStorage {
+public:
+  static const uint32_t SECTOR_SIZE = 4096;
+  static const uint32_t PAGE_SIZE = 256;
+
+  virtual ~BlackBoxStorage() {}
+  virtual uint32_t size() = 0;
+  virtual bool read(uint32_t address, void* data, uint32_t len) = 0;
+  virtual bool write(uint32_t address, const void* data, uint32_t len) = 0;
+  virtual bool erase(uint32_t sector) = 0;
+};
+
+#ifdef ARDUINO
+/* Raw flash, by default the region the linker keeps for SPIFFS (the tracker
+ * does not mount it) */
+class FlashStorage : public BlackBoxStorage {
+public:
+  FlashStorage();
+  FlashStorage(uint32_t start, uint32_t size); /* Flash offsets, sector aligned */
+  uint32_t size();
+  bool read(uint32_t address, void* data, uint32_t len);
+  bool write(uint32_t address, const void* data, uint32_t len);
+  bool erase(uint32_t sector);
+private:
+  uint32_t _start;
+  uint32_t _size;
+};
+#else
+/* Flash image in a file, for the host tools */
+class FileStorage : public BlackBoxStorage {
+public:
+  FileStorage();
+  ~FileStorage();
+  /* Created erased if missing. Read only, the file is left as it is and
+   * what lies past its end reads as erased. */
+  bool open(const char* path, uint32_t size, bool readOnly = false);
+  void close();
+  uint32_t size();
+  bool read(uint32_t address, void* data, uint32_t len);
+  bool write(uint32_t address, const void* data, uint32_t len);
+  bool erase(uint32_t sector);
+private:
+  FILE* _file;
+  uint32_t _size;
+  bool _readOnly;
+};
+#endif
+
+#endif
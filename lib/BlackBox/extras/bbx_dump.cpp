@@ -0,0 +1,113 @@
+/* Host tool : prints a black box log as CSV, the same as /log.csv.
+ *
+ *   g++ -I.. -o bbx_dump bbx_dump.cpp ../BlackBox.cpp ../BlackBoxStorage.cpp ../BlackBoxExport.cpp
+ *   bbx_dump image.bin [size]   flash image, esptool.py read_flash of the SPIFFS area
+ *   bbx_dump -d log.bin         download of /log.bin */
+#ifndef ARDUINO
+#include <BlackBox.h>
+#include <BlackBoxExport.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint32_t PAGES_PER_SECTOR = BlackBoxStorage::SECTOR_SIZE / BlackBoxStorage::PAGE_SIZE;
+
+/* /log.bin holds the log pages in order from the oldest, seen here as the
+ * flash ring they came from */
+class DownloadStorage : public BlackBoxStorage {
+public:
+  bool open(const char* path)
+  {
+    uint8_t page[PAGE_SIZE];
+
+    _file = fopen(path, "rb");
+    if (_file == NULL) {
+      return false;
+    }
+    fseek(_file, 0, SEEK_END);
+    _pages = ftell(_file) / PAGE_SIZE;
+    _count = (_pages + PAGES_PER_SECTOR - 1) / PAGES_PER_SECTOR * PAGES_PER_SECTOR;
+    // Page number of index 0, from the first page that survived
+    _first = 0;
+    for (uint32_t i = 0; i < _pages; i++) {
+      fseek(_file, i * PAGE_SIZE, SEEK_SET);
+      if (fread(page, 1, 8, _file) == 8
+          && (page[0] | (page[1] << 8) | (page[2] << 16) | ((uint32_t)page[3] << 24)) == BLACKBOX_PAGE_MAGIC) {
+        _first = (page[4] | (page[5] << 8) | (page[6] << 16) | ((uint32_t)page[7] << 24)) - i;
+        break;
+      }
+    }
+    return true;
+  }
+  uint32_t size() { return _count * PAGE_SIZE; }
+  bool read(uint32_t address, void* data, uint32_t len)
+  {
+    uint32_t slot = address / PAGE_SIZE;
+    uint32_t index = (slot + _count - _first % _count) % _count;
+
+    memset(data, 0xFF, len);
+    if (index < _pages && address % PAGE_SIZE + len <= PAGE_SIZE) {
+      fseek(_file, index * PAGE_SIZE + address % PAGE_SIZE, SEEK_SET);
+      return fread(data, 1, len, _file) == len;
+    }
+    return true;
+  }
+  bool write(uint32_t, const void*, uint32_t) { return false; }
+  bool erase(uint32_t) { return false; }
+private:
+  FILE* _file;
+  uint32_t _pages;
+  uint32_t _count;
+  uint32_t _first;
+};
+
+int main(int argc, char** argv)
+{
+  FileStorage image;
+  DownloadStorage download;
+  BlackBoxStorage* storage = &image;
+  char chunk[1024];
+  size_t len;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s image.bin [size] | -d log.bin\n", argv[0]);
+    return 1;
+  }
+  if (strcmp(argv[1], "-d") == 0) {
+    if (argc < 3 || !download.open(argv[2])) {
+      perror(argc < 3 ? argv[0] : argv[2]);
+      return 1;
+    }
+    storage = &download;
+  } else {
+    uint32_t size;
+    if (argc > 2) {
+      size = strtoul(argv[2], NULL, 0);
+    } else {
+      FILE* file = fopen(argv[1], "rb");
+      if (file == NULL) {
+        perror(argv[1]);
+        return 1;
+      }
+      fseek(file, 0, SEEK_END);
+      size = ftell(file);
+      fclose(file);
+    }
+    // Read only : a dump must not pad or alter the image
+    if (!image.open(argv[1], size, true)) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  BlackBoxReader reader(*storage);
+  BlackBoxCsv csv(reader);
+  if (!csv.begin()) {
+    fprintf(stderr, "empty log\n");
+  }
+  while ((len = csv.read(chunk, sizeof(chunk))) > 0) {
+    fwrite(chunk, 1, len, stdout);
+  }
+  return 0;
+}
+#endif
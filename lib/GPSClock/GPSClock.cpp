@@ -0,0 +1,162 @@
+#include <GPSClock.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <time.h>
+#endif
+
+GPSClock gpsClock;
+
+GPSClock::GPSClock(){
+  _lastMicros = 0;
+  _wraps = 0;
+  _synced = false;
+  _refLocal = 0;
+  _refGPS = 0;
+  _drift = 0;
+  _lastError = 0;
+  _outliers = 0;
+  _lastNow = 0;
+}
+
+uint64_t GPSClock::micros64()
+{
+#ifdef ARDUINO
+  uint32_t us = micros();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint32_t us = (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#endif
+  if (us < _lastMicros) {
+    _wraps++;
+  }
+  _lastMicros = us;
+  return ((uint64_t)_wraps << 32) | us;
+}
+
+void GPSClock::discipline(uint64_t local,
+          unsigned long iTOW,
+          long nano,
+          uint16_t year,
+          uint8_t month,
+          uint8_t day,
+          uint8_t valid)
+{
+  uint64_t gps = epochTime(iTOW, nano, year, month, day, valid);
+  if (gps == 0) {
+    return;
+  }
+  if (!_synced) {
+    _synced = true;
+    _refLocal = local;
+    _refGPS = gps;
+    _lastError = 0;
+    _outliers = 0;
+    return;
+  }
+
+  uint64_t predicted = toGPS(local);
+  int64_t error = (int64_t)(gps - predicted);
+  _lastError = error;
+
+  // A stalled loop reads one fix late, a real time jump repeats
+  if (error > STEP_US || error < -STEP_US) {
+    if (++_outliers >= STEP_COUNT) {
+      _refLocal = local;
+      _refGPS = gps;
+      _outliers = 0;
+    }
+    return;
+  }
+  _outliers = 0;
+
+  _refLocal = local;
+  _refGPS = predicted + error / PHASE_GAIN;
+  // Not scaled by the time since the last fix : read jitter makes both vary
+  // together and would bias the frequency
+  _drift += error * FREQ_GAIN;
+  if (_drift > MAX_DRIFT_PPB) {
+    _drift = MAX_DRIFT_PPB;
+  } else if (_drift < -MAX_DRIFT_PPB) {
+    _drift = -MAX_DRIFT_PPB;
+  }
+}
+
+bool GPSClock::isSynced()
+{
+  return _synced;
+}
+
+uint64_t GPSClock::toGPS(uint64_t local)
+{
+  if (!_synced) {
+    return local;
+  }
+  // Signed, samples can be taken just before the last fix
+  int64_t elapsed = (int64_t)(local - _refLocal);
+  return _refGPS + elapsed + elapsed * _drift / 1000000000LL;
+}
+
+uint64_t GPSClock::now()
+{
+  uint64_t time = toGPS(micros64());
+  // Phase corrections may move the estimate back by a few us
+  if (time < _lastNow) {
+    return _lastNow;
+  }
+  _lastNow = time;
+  return time;
+}
+
+int64_t GPSClock::getLastError()
+{
+  return _lastError;
+}
+
+int32_t GPSClock::getDrift()
+{
+  return (int32_t)_drift;
+}
+
+uint64_t GPSClock::epochTime(unsigned long iTOW,
+          long nano,
+          uint16_t year,
+          uint8_t month,
+          uint8_t day,
+          uint8_t valid)
+{
+  if ((valid & GPS_VALID_DATE_TIME) != GPS_VALID_DATE_TIME) {
+    return 0;
+  }
+  // Around midnight the UTC date lags GPS time by the leap seconds, so the
+  // week is rounded from the date minus the GPS day of week
+  int32_t days = daysFromCivil(year, month, day) - daysFromCivil(1980, 1, 6);
+  int32_t week = (days - (int32_t)(iTOW / 86400000UL) + 3) / 7;
+  if (week < 0) {
+    return 0;
+  }
+
+  // iTOW is rounded to the ms, nano has the exact fraction of second
+  int32_t fraction = nano / 1000 - (int32_t)(iTOW % 1000) * 1000;
+  if (fraction > 500000) {
+    fraction -= 1000000;
+  } else if (fraction <= -500000) {
+    fraction += 1000000;
+  }
+  if (fraction > 1000 || fraction < -1000) {
+    fraction = 0;
+  }
+  return week * GPS_WEEK_US + (uint64_t)iTOW * 1000 + fraction;
+}
+
+int32_t GPSClock::daysFromCivil(int32_t y, uint32_t m, uint32_t d)
+{
+  // Days since 1970-01-01 in the proleptic Gregorian calendar
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  uint32_t yoe = (uint32_t)(y - era * 400);
+  uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
@@ -0,0 +1,58 @@
+#ifndef GPSClock_h
+#define GPSClock_h
+
+#include <stdint.h>
+
+const uint64_t GPS_WEEK_US = 604800000000ULL;
+const uint8_t GPS_VALID_DATE_TIME = 0x03; /* NAV-PVT valid : validDate | validTime */
+
+/* 64-bit microsecond clock. Tracks micros() wraps and, once NAV-PVT gives a
+ * valid date and time, follows GPS time (microseconds since the GPS epoch,
+ * 1980-01-06) through a PI loop on the local oscillator. Before that it
+ * returns the local time since boot. */
+class GPSClock {
+public:
+  static const int64_t STEP_US = 20000;  /* [us] bigger errors are outliers, or a step once repeated */
+  static const int STEP_COUNT = 5;
+  static const int PHASE_GAIN = 16;      /* Phase error fraction corrected per fix */
+  static const int FREQ_GAIN = 1;        /* [ppb/us] frequency correction per fix */
+  static const int64_t MAX_DRIFT_PPB = 1000000;
+
+  GPSClock();
+  uint64_t micros64(); /* [us] local time since boot, call at least once per 71 min */
+  /* NAV-PVT solution read at local time, ignored until date and time are valid */
+  void discipline(uint64_t local,
+            unsigned long iTOW,
+            long nano,
+            uint16_t year,
+            uint8_t month,
+            uint8_t day,
+            uint8_t valid);
+  bool isSynced();
+  uint64_t toGPS(uint64_t local);
+  uint64_t now(); /* [us] never goes back, GPS time once synced */
+  int64_t getLastError(); /* [us] GPS time minus clock at the last fix */
+  int32_t getDrift(); /* [ppb] local oscillator against GPS */
+  /* [us] GPS time of a NAV-PVT epoch, 0 if date or time are not valid */
+  static uint64_t epochTime(unsigned long iTOW,
+            long nano,
+            uint16_t year,
+            uint8_t month,
+            uint8_t day,
+            uint8_t valid);
+private:
+  uint32_t _lastMicros;
+  uint32_t _wraps;
+  bool _synced;
+  uint64_t _refLocal;
+  uint64_t _refGPS;
+  int64_t _drift;       /* [ppb] */
+  int64_t _lastError;   /* [us] */
+  int _outliers;
+  uint64_t _lastNow;
+  static int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d);
+};
+
+extern GPSClock gpsClock;
+
+#endif
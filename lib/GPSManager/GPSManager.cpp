@@ -1,5 +1,7 @@
 #include <Arduino.h>
 #include <GPSManager.h>
+#include <GPSClock.h>
+#include <Geofence.h>
 
 GPSManager::GPSManager()
 {
@@ -13,17 +15,256 @@ GPSManager::GPSManager()
   data.verticalAcc = 500e3;
   data.numberSV = 0;
   data.isReady = false;
-  data.timestamp = 0;
+  data.time = 0;
+  data.iTOW = 0;
+  memset(&_stats, 0, sizeof(_stats));
+  memcpy(_cfgRate, UBX_CFG_RATE, sizeof(_cfgRate));
+  _navPeriod = UBX_CFG_RATE[2] | (UBX_CFG_RATE[3] << 8);
+  _hasLastITOW = false;
+  _lastITOW = 0;
+  _rawPVTLength = 0;
+  _configCount = 0;
+  _configStatus = GPS_CONFIG_IDLE;
+  _baudState = GPS_BAUD_DETECTING;
+  _baudIndex = 0;
+  _baudMaxIndex = GPS_BAUD_RATES_COUNT-1;
+  _baudWindowStart = 0;
+  _baudValidFrames = 0;
+  _baudFailures = 0;
+}
+
+void GPSManager::init(uint32_t baud)
+{
+  _baudMaxIndex = 0;
+  for (int i = 0; i < GPS_BAUD_RATES_COUNT; i++) {
+    if (GPS_BAUD_RATES[i] <= baud) {
+      _baudMaxIndex = i;
+    }
+  }
+  /* Start with the rate used before negotiation was there */
+  _baudIndex = 3; // 230400
+  _baudState = GPS_BAUD_DETECTING;
+  setBaud(_baudIndex);
+  writeUBX(UBX_CFG_PRT_POLL,sizeof(UBX_CFG_PRT_POLL)/sizeof(UBX_CFG_PRT_POLL[0]));
+  startBaudWindow();
+}
+
+uint32_t GPSManager::getBaud()
+{
+  return GPS_BAUD_RATES[_baudIndex];
+}
+
+bool GPSManager::isLinkUp()
+{
+  return _baudState == GPS_BAUD_LOCKED;
+}
+
+void GPSManager::startBaudWindow()
+{
+  _baudWindowStart = millis();
+  _baudValidFrames = getValidFrames();
+  _baudFailures = getChecksumFailures();
+}
+
+void GPSManager::setBaud(int index)
+{
+  _baudIndex = index;
+  Serial.flush(); /* Let pending frames go out at the old rate */
+  Serial.begin(GPS_BAUD_RATES[index]);
+  Serial.swap(); /* begin() restores the default pins */
+}
+
+/* Ask the receiver to move to another rate, then follow it */
+void GPSManager::switchBaud(int index)
+{
+  uint32_t baud = GPS_BAUD_RATES[index];
+  byte cfgPrt[] =
+  {
+    0x06, 0x00,
+    0x01, 0x00,             /* UART1 */
+    0x00, 0x00,             /* txReady disabled */
+    0xD0, 0x08, 0x00, 0x00, /* 8N1 */
+    (byte)(baud & 0xFF), (byte)((baud >> 8) & 0xFF),
+    (byte)((baud >> 16) & 0xFF), (byte)((baud >> 24) & 0xFF),
+    0x03, 0x00,             /* in : UBX + NMEA */
+    0x01, 0x00,             /* out : UBX only, NMEA would waste the link */
+    0x00, 0x00, 0x00, 0x00
+  };
+  writeUBX(cfgPrt,sizeof(cfgPrt)/sizeof(cfgPrt[0]));
+  setBaud(index);
+  _baudState = GPS_BAUD_SWITCHING;
+  startBaudWindow();
+}
+
+void GPSManager::processBaud()
+{
+  unsigned long elapsed = millis()-_baudWindowStart;
+  unsigned long valid = getValidFrames()-_baudValidFrames;
+  unsigned long failures = getChecksumFailures()-_baudFailures;
+
+  switch (_baudState) {
+    case GPS_BAUD_DETECTING:
+      if (valid > 0) {
+        if (_baudIndex != _baudMaxIndex) {
+          switchBaud(_baudMaxIndex);
+        } else {
+          _baudState = GPS_BAUD_LOCKED;
+          startBaudWindow();
+        }
+      }
+      else if (elapsed >= GPS_BAUD_WINDOW) {
+        /* Nothing heard : try the next rate */
+        setBaud((_baudIndex+1) % GPS_BAUD_RATES_COUNT);
+        writeUBX(UBX_CFG_PRT_POLL,sizeof(UBX_CFG_PRT_POLL)/sizeof(UBX_CFG_PRT_POLL[0]));
+        startBaudWindow();
+      }
+      break;
+
+    case GPS_BAUD_SWITCHING:
+      if (valid > 0) {
+        _baudState = GPS_BAUD_LOCKED;
+        startBaudWindow();
+      }
+      else if (elapsed >= GPS_BAUD_WINDOW) {
+        /* Receiver not heard at the new rate : CFG-PRT lost on the way, or
+         * the link does not hold that rate. Asking again from here would not
+         * reach it in the first case, look for it at every rate */
+        _baudState = GPS_BAUD_DETECTING;
+        writeUBX(UBX_CFG_PRT_POLL,sizeof(UBX_CFG_PRT_POLL)/sizeof(UBX_CFG_PRT_POLL[0]));
+        startBaudWindow();
+      }
+      break;
+
+    case GPS_BAUD_LOCKED:
+      if (elapsed < GPS_LINK_WINDOW) {
+        break;
+      }
+      /* Silent receiver, or only garbage after a reset to another rate :
+       * make sure it is still at this rate */
+      if (valid == 0) {
+        _baudState = GPS_BAUD_DETECTING;
+        writeUBX(UBX_CFG_PRT_POLL,sizeof(UBX_CFG_PRT_POLL)/sizeof(UBX_CFG_PRT_POLL[0]));
+        startBaudWindow();
+      }
+      /* Too many bad frames : the link does not hold this rate, step down */
+      else if (failures > 2 && failures*4 > valid && _baudIndex > 0) {
+        _baudMaxIndex = _baudIndex-1;
+        switchBaud(_baudMaxIndex);
+      } else {
+        startBaudWindow();
+      }
+      break;
+  }
 }
 
 void GPSManager::flash()
 {
-  writeUBX(UBX_CFG_NAV5,sizeof(UBX_CFG_NAV5)/sizeof(UBX_CFG_NAV5[0]));
-  writeUBX(UBX_CFG_NAVX5,sizeof(UBX_CFG_NAVX5)/sizeof(UBX_CFG_NAVX5[0]));
-  writeUBX(UBX_CFG_RATE,sizeof(UBX_CFG_RATE)/sizeof(UBX_CFG_RATE[0]));
-  writeUBX(UBX_CFG_MSG,sizeof(UBX_CFG_MSG)/sizeof(UBX_CFG_MSG[0]));
-  writeUBX(UBX_CFG_CFG,sizeof(UBX_CFG_CFG)/sizeof(UBX_CFG_CFG[0]));
-  delay(1000);
+  queueConfig(UBX_CFG_NAV5,sizeof(UBX_CFG_NAV5)/sizeof(UBX_CFG_NAV5[0]));
+  queueConfig(UBX_CFG_NAVX5,sizeof(UBX_CFG_NAVX5)/sizeof(UBX_CFG_NAVX5[0]));
+  queueConfig(_cfgRate,sizeof(_cfgRate)/sizeof(_cfgRate[0]));
+  queueConfig(UBX_CFG_MSG,sizeof(UBX_CFG_MSG)/sizeof(UBX_CFG_MSG[0]));
+  queueConfig(UBX_CFG_CFG,sizeof(UBX_CFG_CFG)/sizeof(UBX_CFG_CFG[0]));
+}
+
+bool GPSManager::queueConfig(const byte msg[], int size)
+{
+  // Previous batch is over : start a new one
+  if (_configStatus != GPS_CONFIG_BUSY) {
+    _configCount = 0;
+  }
+  // Still waiting to be sent, e.g. CFG-RATE from setNavRate() then flash()
+  for (int i = 0; i < _configCount; i++) {
+    if (_config[i].msg == msg && _config[i].state == CONFIG_QUEUED) {
+      return true;
+    }
+  }
+  if (_configCount == GPS_CONFIG_QUEUE_SIZE) {
+    return false;
+  }
+  ConfigEntry_t& entry = _config[_configCount++];
+  entry.msg = msg;
+  entry.size = size;
+  entry.state = CONFIG_QUEUED;
+  entry.tries = 0;
+  entry.sentAt = 0;
+  _configStatus = GPS_CONFIG_BUSY;
+  return true;
+}
+
+bool GPSManager::setNavRate(uint16_t period)
+{
+  _cfgRate[2] = period & 0xFF;
+  _cfgRate[3] = (period >> 8) & 0xFF;
+  return queueConfig(_cfgRate,sizeof(_cfgRate)/sizeof(_cfgRate[0]));
+}
+
+GPSStats_t GPSManager::getStats()
+{
+  _stats.checksumFailures = getChecksumFailures();
+  return _stats;
+}
+
+GPSConfigStatus_t GPSManager::getConfigStatus()
+{
+  return _configStatus;
+}
+
+void GPSManager::processConfig()
+{
+  /* Frames sent at a wrong rate would only be garbage for the receiver */
+  if (_configStatus != GPS_CONFIG_BUSY || _baudState != GPS_BAUD_LOCKED) {
+    return;
+  }
+
+  bool pending = false;
+  bool failed = false;
+  unsigned long now = millis();
+
+  for (int i = 0; i < _configCount; i++) {
+    ConfigEntry_t& entry = _config[i];
+    if (entry.state == CONFIG_SENT && now - entry.sentAt >= GPS_CONFIG_ACK_TIMEOUT) {
+      entry.state = entry.tries < GPS_CONFIG_RETRIES ? CONFIG_QUEUED : CONFIG_FAILED;
+    }
+    // Everything queued is sent at once, the receiver ACKs in order
+    if (entry.state == CONFIG_QUEUED) {
+      writeUBX(entry.msg, entry.size);
+      entry.tries++;
+      entry.sentAt = now;
+      entry.state = CONFIG_SENT;
+    }
+    pending |= entry.state == CONFIG_SENT;
+    failed |= entry.state == CONFIG_FAILED;
+  }
+
+  if (!pending) {
+    _configStatus = failed ? GPS_CONFIG_FAILED : GPS_CONFIG_DONE;
+  }
+}
+
+void GPSManager::ackConfig(byte clsID, byte msgID, bool ack)
+{
+  for (int i = 0; i < _configCount; i++) {
+    ConfigEntry_t& entry = _config[i];
+    if (entry.state == CONFIG_SENT && entry.msg[0] == clsID && entry.msg[1] == msgID) {
+      entry.state = ack ? CONFIG_ACKED : CONFIG_FAILED;
+      /* The receiver only runs at the new rate once it has taken it */
+      if (ack && clsID == UBX_CFG_RATE[0] && msgID == UBX_CFG_RATE[1]) {
+        _navPeriod = entry.msg[2] | (entry.msg[3] << 8);
+        _hasLastITOW = false;
+      }
+      return;
+    }
+  }
+}
+
+void GPSManager::handle_ACK_ACK(byte clsID, byte msgID)
+{
+  ackConfig(clsID, msgID, true);
+}
+
+void GPSManager::handle_ACK_NAK(byte clsID, byte msgID)
+{
+  ackConfig(clsID, msgID, false);
 }
 
 void GPSManager::writeUBX(const byte msg[], int size)
@@ -59,39 +300,30 @@ void GPSManager::writeUBX(const byte msg[], int size)
   buffer[UBX_HEADER_OFFSET+UBX_CLASS_ID_OFFSET+UBX_LENGTH_OFFSET+payloadSize] = checksum[0]; /*ChkA*/
   buffer[UBX_HEADER_OFFSET+UBX_CLASS_ID_OFFSET+UBX_LENGTH_OFFSET+payloadSize+1] = checksum[1]; /*ChkB*/
 
-  for(int i=0;i<UBX_HEADER_OFFSET+UBX_CLASS_ID_OFFSET+UBX_LENGTH_OFFSET+payloadSize+UBX_FOOTER_OFFSET;i++)
-  {
-    Serial1.print(buffer[i],HEX); // TODO : debuglog in hex
-    Serial1.print(" ");
-  }
-  Serial1.println("");
-
-  for(int i=0;i<size+UBX_HEADER_OFFSET+UBX_LENGTH_OFFSET+UBX_FOOTER_OFFSET;i++)
-  {
-    Serial.write(buffer[i]);
-    Serial.flush();
-  }
+  /* Whole frame at once, the UART driver buffers it */
+  Serial.write(buffer,size+UBX_HEADER_OFFSET+UBX_LENGTH_OFFSET+UBX_FOOTER_OFFSET);
 }
 
 void GPSManager::process()
 {
+    /* Bytes dropped by the UART driver since the last call */
+    if(Serial.hasOverrun())
+    {
+      _stats.uartOverruns++;
+    }
     while(Serial.available()>0)
     {
       parse(Serial.read());
     }
+    processBaud();
+    processConfig();
 }
 
 void GPSManager::prepareNextMeasure()
 {
-  updateTimestamp();
   data.isReady = false;
 }
 
-void GPSManager::updateTimestamp()
-{
-  data.timestamp++;
-}
-
 bool GPSManager::isReady()
 {
   return data.isReady;
@@ -102,7 +334,19 @@ GPSData_t GPSManager::getData()
   return data;
 }
 
-void GPSManager::handle_NAV_PVT(byte fixType,
+const byte* GPSManager::getRawPVT(int* len)
+{
+  *len = _rawPVTLength;
+  return _rawPVT;
+}
+
+void GPSManager::handle_NAV_PVT(unsigned long iTOW,
+            unsigned short year,
+            byte month,
+            byte day,
+            byte valid,
+            long nano,
+            byte fixType,
             byte numSV,
             long lon,
             long lat,
@@ -114,6 +358,24 @@ void GPSManager::handle_NAV_PVT(byte fixType,
             long velE,
             long velD,
             unsigned long sAcc) {
+        /* Gap in time of week : epochs lost on the way */
+        if (_hasLastITOW) {
+          unsigned long delta = (iTOW + GPS_WEEK_MS - _lastITOW) % GPS_WEEK_MS;
+          if (delta > _navPeriod + _navPeriod/2) {
+            _stats.droppedEpochs += (delta + _navPeriod/2)/_navPeriod - 1;
+          }
+        }
+        _hasLastITOW = true;
+        _lastITOW = iTOW;
+        /* Previous fix not sent yet : the loop is too slow */
+        if (data.isReady) {
+          _stats.overwrittenEpochs++;
+        }
+        /* Read time of the frame : the loop adds jitter, filtered by the clock */
+        gpsClock.discipline(gpsClock.micros64(), iTOW, nano, year, month, day, valid);
+        uint64_t epoch = GPSClock::epochTime(iTOW, nano, year, month, day, valid);
+        data.time = epoch != 0 ? epoch : gpsClock.now();
+        data.iTOW = iTOW;
         data.longitude = lon;
         data.latitude = lat;
         data.altitude = height;
@@ -125,4 +387,10 @@ void GPSManager::handle_NAV_PVT(byte fixType,
         data.speedAcc = sAcc;
         data.numberSV = numSV;
         data.isReady = true;
+        /* Zone events on the fix that crossed, not when the loop gets to it */
+        if (fixType >= 2 && fixType <= 4) {
+          geofence.update(lat, lon, iTOW);
+        }
+        _rawPVTLength = getPayloadLength() < UBX_NAV_PVT_SIZE ? getPayloadLength() : UBX_NAV_PVT_SIZE;
+        memcpy(_rawPVT, getPayload(), _rawPVTLength);
 }
@@ -34,30 +34,74 @@ const byte UBX_CFG_RATE[] =
 {
   0x06, 0x08, 0xC8, 0x00, 0x01, 0x00, 0x01, 0x00
 };
+const int UBX_CFG_RATE_SIZE = sizeof(UBX_CFG_RATE)/sizeof(UBX_CFG_RATE[0]);
+const unsigned long GPS_WEEK_MS = 604800000UL;
+const int UBX_NAV_PVT_SIZE = 92; /* NAV-PVT payload, protocol 15+ */
 
 const byte UBX_CFG_MSG[] =
 {
   0x06, 0x01, 0x01, 0x02, 0x00 // NAV-PVT
 };
 
+/* Polls the configuration of the current port : any answer proves the baud rate */
+const byte UBX_CFG_PRT_POLL[] =
+{
+  0x06, 0x00
+};
+
 const byte UBX_CFG_CFG[] =
 {
   0x06, 0x09, 0x00, 0x00, 0x00, 0x00, 0x1e, 0x1e,
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
+const int GPS_CONFIG_QUEUE_SIZE = 8;
+const int GPS_CONFIG_RETRIES = 3;
+const unsigned long GPS_CONFIG_ACK_TIMEOUT = 1000; // [ms]
+
+const uint32_t GPS_BAUD_RATES[] = { 9600, 38400, 115200, 230400, 460800, 921600 };
+const int GPS_BAUD_RATES_COUNT = sizeof(GPS_BAUD_RATES)/sizeof(GPS_BAUD_RATES[0]);
+const unsigned long GPS_BAUD_WINDOW = 1500; // [ms] to hear a valid frame
+const unsigned long GPS_LINK_WINDOW = 2000; // [ms] link quality check period
+
+typedef enum {
+  GPS_BAUD_DETECTING, /* Looking for the receiver baud rate */
+  GPS_BAUD_SWITCHING, /* CFG-PRT sent, waiting for frames at the new rate */
+  GPS_BAUD_LOCKED     /* Link up, checksum failures monitored */
+} GPSBaudState_t;
+
+typedef enum {
+  GPS_CONFIG_IDLE,    /* Nothing queued */
+  GPS_CONFIG_BUSY,    /* Waiting for ACKs */
+  GPS_CONFIG_DONE,    /* Every message ACKed */
+  GPS_CONFIG_FAILED   /* At least one NAK, or no answer after retries */
+} GPSConfigStatus_t;
+
 class GPSManager : public UBX_Parser
 {
 
 public:
   GPSManager();
-  void flash();
+  void init(uint32_t baud); /* Find the receiver and bring it to baud (or the best lower rate) */
+  uint32_t getBaud();
+  bool isLinkUp();
+  void flash(); /* Queue the configuration, see getConfigStatus() */
+  bool queueConfig(const byte msg[], int size);
+  bool setNavRate(uint16_t period); /* [ms] 40 for 25 Hz, queued like the rest of the config, used once ACKed */
+  GPSStats_t getStats();
+  GPSConfigStatus_t getConfigStatus();
   void process();
   void prepareNextMeasure();
-  void updateTimestamp();
   bool isReady();
   GPSData_t getData();
-  void handle_NAV_PVT(byte fixType,
+  const byte* getRawPVT(int* len); /* Payload of the last NAV-PVT, for the black box */
+  void handle_NAV_PVT(unsigned long iTOW,
+              unsigned short year,
+              byte month,
+              byte day,
+              byte valid,
+              long nano,
+              byte fixType,
               byte numSV,
               long lon,
               long lat,
@@ -69,8 +113,47 @@ public:
               long velE,
               long velD,
               unsigned long sAcc);
+  void handle_ACK_ACK(byte clsID, byte msgID);
+  void handle_ACK_NAK(byte clsID, byte msgID);
 private:
+  typedef enum {
+    CONFIG_QUEUED,
+    CONFIG_SENT,
+    CONFIG_ACKED,
+    CONFIG_FAILED
+  } ConfigState_t;
+
+  typedef struct {
+    const byte* msg;
+    int size;
+    ConfigState_t state;
+    int tries;
+    unsigned long sentAt;
+  } ConfigEntry_t;
+
   GPSData_t data;
+  GPSStats_t _stats;
+  byte _rawPVT[UBX_NAV_PVT_SIZE];
+  int _rawPVTLength;
+  byte _cfgRate[UBX_CFG_RATE_SIZE];
+  uint16_t _navPeriod;  /* [ms] ACKed by the receiver */
+  bool _hasLastITOW;
+  unsigned long _lastITOW;
+  GPSBaudState_t _baudState;
+  int _baudIndex;       /* Current rate in GPS_BAUD_RATES */
+  int _baudMaxIndex;    /* Best rate allowed, lowered when the link degrades */
+  unsigned long _baudWindowStart;
+  unsigned long _baudValidFrames;
+  unsigned long _baudFailures;
+  ConfigEntry_t _config[GPS_CONFIG_QUEUE_SIZE];
+  int _configCount;
+  GPSConfigStatus_t _configStatus;
+  void processBaud();
+  void startBaudWindow();
+  void setBaud(int index);
+  void switchBaud(int index);
+  void processConfig();
+  void ackConfig(byte clsID, byte msgID, bool ack);
   void writeUBX(const byte msg[], int size); /* TODO tests & define output port */
 };
 
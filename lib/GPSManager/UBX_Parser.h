@@ -46,10 +46,12 @@ class UBX_Parser {
         int msgclass;
         int msgid;
         int msglen;
-        char chka;
-        char chkb;
+        unsigned char chka;
+        unsigned char chkb;
         int count;
         char payload[1000];
+        unsigned long validFrames;
+        unsigned long checksumFailures;
         bool hdseen;
         int timer;
 
@@ -61,6 +63,36 @@ class UBX_Parser {
 
 
         void dispatchMessage() {
+            switch (this->msgclass) {
+                case 0x01:
+                    this->dispatchNAV();
+                    break;
+                case 0x05:
+                    this->dispatchACK();
+                    break;
+                default:
+                    this->reportUnhandled(this->msgid);
+                    break;
+            }
+        }
+
+        void dispatchACK() {
+            unsigned char clsID = this->payload[0];
+            unsigned char msgID = this->payload[1];
+            switch (this->msgid) {
+                case 0x01:
+                    this->handle_ACK_ACK(clsID, msgID);
+                    break;
+                case 0x00:
+                    this->handle_ACK_NAK(clsID, msgID);
+                    break;
+                default:
+                    this->reportUnhandled(this->msgid);
+                    break;
+            }
+        }
+
+        void dispatchNAV() {
             switch (this->msgid) {
                 case 0x02:
                     {
@@ -89,16 +121,16 @@ class UBX_Parser {
                     break;
                  case 0x07:
                     {
-                    //unsigned long iTOW = (unsigned long)this->unpack_int32(0);
-                    //unsigned short year = (unsigned short)this->unpack_int16(4);
-                    //unsigned int month = (unsigned int)this->unpack_int(6);
-                    //unsigned int day = (unsigned int)this->unpack_int(7);
+                    unsigned long iTOW = (unsigned long)this->unpack_int32(0);
+                    unsigned short year = (unsigned short)this->unpack_int16(4);
+                    unsigned char month = this->payload[6];
+                    unsigned char day = this->payload[7];
                     //unsigned int hour = (unsigned int)this->unpack_int(8);
                     //unsigned int min = (unsigned int)this->unpack_int(9);
                     //unsigned int sec = (unsigned int)this->unpack_int(10);
-                    //unsigned int valid = (unsigned int)this->unpack_int(11);
+                    unsigned char valid = this->payload[11];
                     //unsigned long tacc = (unsigned long)this->unpack_int32(12);
-                    //long nano = this->unpack_int32(16);
+                    long nano = this->unpack_int32(16);
                     unsigned char fixType = this->payload[20];
                     //unsigned int flags = (unsigned int)this->unpack_int(21);
                     //unsigned int flags2 = (unsigned int)this->unpack_int(22);
@@ -115,7 +147,7 @@ class UBX_Parser {
                     //long gSpeed = this->unpack_int32(60);
                     //long headMot = this->unpack_int32(64);
                     unsigned long sAcc = (unsigned long)this->unpack_int32(68);
-                    this->handle_NAV_PVT(fixType, numSV, lon, lat, height, hMSL, hAcc, vAcc, velN, velE, velD,sAcc);
+                    this->handle_NAV_PVT(iTOW, year, month, day, valid, nano, fixType, numSV, lon, lat, height, hMSL, hAcc, vAcc, velN, velE, velD,sAcc);
                     }
                     break;
                 case 0x12:
@@ -131,6 +163,7 @@ class UBX_Parser {
                     unsigned long cAcc = (unsigned long)this->unpack_int32(32);
                     this->handle_NAV_VELNED(iTOW, velN, velE, velD, speed, gSpeed, heading, sAcc, cAcc);
                     }
+                    break;
                     /*
                 case 0x06:
                     {
@@ -213,6 +246,12 @@ class UBX_Parser {
 
         /**
           Override this method to handle NAV-VELPVT messages.
+          @param iTOW GPS Millisecond Time of Week
+          @param year UTC year
+          @param month UTC month, 1..12
+          @param day UTC day, 1..31
+          @param valid Validity flags, bit 0 date, bit 1 time
+          @param nano Fraction of second in nanoseconds, -1e9..1e9
           @param gpsType GPS fix type
 		  @param numSV number of satellites used
           @param lon Longitude in degrees * 10<sup>7</sup>
@@ -226,7 +265,13 @@ class UBX_Parser {
           @param velD NED down velocity in cm/sec
           @param sAcc Speed Accuracy Estimate in cm/sec
           */
-          virtual void handle_NAV_PVT(unsigned char fixType,
+          virtual void handle_NAV_PVT(unsigned long iTOW,
+                unsigned short year,
+                unsigned char month,
+                unsigned char day,
+                unsigned char valid,
+                long nano,
+                unsigned char fixType,
         		unsigned char numSV,
         		long lon,
         		long lat,
@@ -276,6 +321,20 @@ class UBX_Parser {
                  char gpsFix) { }
                  */
 
+        /**
+          Override this method to handle ACK-ACK messages.
+          @param clsID Class ID of the acknowledged message
+          @param msgID Message ID of the acknowledged message
+          */
+        virtual void handle_ACK_ACK(unsigned char clsID, unsigned char msgID) { }
+
+        /**
+          Override this method to handle ACK-NAK messages.
+          @param clsID Class ID of the rejected message
+          @param msgID Message ID of the rejected message
+          */
+        virtual void handle_ACK_NAK(unsigned char clsID, unsigned char msgID) { }
+
          /**
            * Override this method to report receipt of messages not
            * handled by current code.
@@ -299,8 +358,30 @@ class UBX_Parser {
             this->count    = 0;
             this->hdseen = false;
             this->timer = 0;
+            this->validFrames = 0;
+            this->checksumFailures = 0;
         }
 
+        /**
+          * @return number of frames received with a good checksum
+          */
+        unsigned long getValidFrames() { return this->validFrames; }
+
+        /**
+          * @return number of frames dropped because of a bad checksum or length
+          */
+        unsigned long getChecksumFailures() { return this->checksumFailures; }
+
+        /**
+          * @return payload of the message being dispatched, valid in the handle_ methods
+          */
+        const unsigned char* getPayload() { return (const unsigned char*)this->payload; }
+
+        /**
+          * @return length of the payload of the message being dispatched
+          */
+        int getPayloadLength() { return this->msglen; }
+
         /**
           * Parses a new byte from the GPS. Automatically calls handle_ methods when a new
           * message is successfully parsed.
@@ -355,6 +436,15 @@ class UBX_Parser {
                 this->count = 0;
                 this->addchk(b);
                 // Serial1.print("got_length2 ");
+
+                // Garbled length (wrong baud rate...) : do not overflow payload
+                if (this->msglen > (int)sizeof(this->payload)) {
+                    this->checksumFailures++;
+                    this->state = GOT_NONE;
+                }
+                else if (this->msglen == 0) {
+                    this->state = GOT_PAYLOAD;
+                }
             }
 
             else if (this->state == GOT_LENGTH2) {
@@ -373,6 +463,9 @@ class UBX_Parser {
             else if (this->state == GOT_PAYLOAD) {
 
                 this->state = (b == this->chka) ? GOT_CHKA : GOT_NONE;
+                if (this->state == GOT_NONE) {
+                    this->checksumFailures++;
+                }
                   // Serial1.print("got_chka ");
             }
 
@@ -381,10 +474,12 @@ class UBX_Parser {
                 if (b == this->chkb) {
                     // Serial1.println("got_checkb");
                     this->hdseen = false;
+                    this->validFrames++;
                     this->dispatchMessage();
                 }
 
                 else {
+                    this->checksumFailures++;
                     this->state = GOT_NONE;
                 }
             }
@@ -0,0 +1,263 @@
+#include <Geofence.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef ARDUINO
+#define memcpy_P memcpy
+#endif
+
+Geofence geofence;
+
+Geofence::Geofence(){
+  _zones = NULL;
+  _vertices = NULL;
+  _zoneCount = 0;
+  _minLat = 0;
+  _minLon = 0;
+  _cellLat = 1;
+  _cellLon = 1;
+  _cellStart = NULL;
+  _cellZones = NULL;
+  _insideCount = 0;
+  _eventHead = 0;
+  _eventCount = 0;
+  _droppedEvents = 0;
+  _tests = 0;
+}
+
+Geofence::~Geofence(){
+  free(_cellStart);
+  free(_cellZones);
+}
+
+bool Geofence::init(const GeofenceZone_t* zones, uint16_t zoneCount, const GeofencePoint_t* vertices)
+{
+  const int cells = GEOFENCE_GRID_SIZE * GEOFENCE_GRID_SIZE;
+  GeofencePoint_t low;
+  GeofencePoint_t high;
+  GeofencePoint_t zoneLow;
+  GeofencePoint_t zoneHigh;
+
+  free(_cellStart);
+  free(_cellZones);
+  _cellStart = NULL;
+  _cellZones = NULL;
+  _zones = zones;
+  _vertices = vertices;
+  _zoneCount = zoneCount;
+  _insideCount = 0;
+
+  // Grid over the bounding box of every zone
+  bool any = false;
+  for (uint16_t z = 0; z < _zoneCount; z++) {
+    if (!boundingBox(z, &zoneLow, &zoneHigh)) {
+      continue;
+    }
+    if (!any) {
+      low = zoneLow;
+      high = zoneHigh;
+      any = true;
+    }
+    low.lat = zoneLow.lat < low.lat ? zoneLow.lat : low.lat;
+    low.lon = zoneLow.lon < low.lon ? zoneLow.lon : low.lon;
+    high.lat = zoneHigh.lat > high.lat ? zoneHigh.lat : high.lat;
+    high.lon = zoneHigh.lon > high.lon ? zoneHigh.lon : high.lon;
+  }
+  if (!any) {
+    return true;
+  }
+  _minLat = low.lat;
+  _minLon = low.lon;
+  _cellLat = ((int64_t)high.lat - low.lat) / GEOFENCE_GRID_SIZE + 1;
+  _cellLon = ((int64_t)high.lon - low.lon) / GEOFENCE_GRID_SIZE + 1;
+
+  // Compressed rows : count the zones of each cell, then fill
+  _cellStart = (uint16_t*)calloc(cells + 1, sizeof(uint16_t));
+  if (_cellStart == NULL) {
+    return false;
+  }
+  uint32_t total = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    for (uint16_t z = 0; z < _zoneCount; z++) {
+      if (!boundingBox(z, &zoneLow, &zoneHigh)) {
+        continue;
+      }
+      int y0 = cell(zoneLow.lat, _minLat, _cellLat);
+      int y1 = cell(zoneHigh.lat, _minLat, _cellLat);
+      int x0 = cell(zoneLow.lon, _minLon, _cellLon);
+      int x1 = cell(zoneHigh.lon, _minLon, _cellLon);
+      for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+          if (pass == 0) {
+            _cellStart[y * GEOFENCE_GRID_SIZE + x + 1]++;
+            total++;
+          } else {
+            _cellZones[_cellStart[y * GEOFENCE_GRID_SIZE + x]++] = z;
+          }
+        }
+      }
+    }
+    if (pass == 0) {
+      if (total > 0xFFFF) {
+        free(_cellStart);
+        _cellStart = NULL;
+        return false;
+      }
+      for (int c = 0; c < cells; c++) {
+        _cellStart[c + 1] += _cellStart[c];
+      }
+      _cellZones = (uint16_t*)malloc(total * sizeof(uint16_t));
+      if (_cellZones == NULL) {
+        free(_cellStart);
+        _cellStart = NULL;
+        return false;
+      }
+    }
+  }
+  // The fill moved each start to the next one
+  for (int c = cells; c > 0; c--) {
+    _cellStart[c] = _cellStart[c - 1];
+  }
+  _cellStart[0] = 0;
+  return true;
+}
+
+void Geofence::update(int32_t lat, int32_t lon, uint32_t iTOW)
+{
+  // Zones left first, so moving between adjacent zones reads leave then enter
+  for (int i = 0; i < _insideCount;) {
+    if (!contains(_inside[i], lat, lon)) {
+      pushEvent(_inside[i], GEOFENCE_LEAVE, iTOW);
+      _inside[i] = _inside[--_insideCount];
+    } else {
+      i++;
+    }
+  }
+
+  if (_cellStart == NULL) {
+    return;
+  }
+  int y = cell(lat, _minLat, _cellLat);
+  int x = cell(lon, _minLon, _cellLon);
+  if (x < 0 || y < 0) {
+    return;
+  }
+  int c = y * GEOFENCE_GRID_SIZE + x;
+  for (uint16_t k = _cellStart[c]; k < _cellStart[c + 1]; k++) {
+    uint16_t z = _cellZones[k];
+    if (_insideCount < GEOFENCE_MAX_INSIDE && !isInside(z) && contains(z, lat, lon)) {
+      _inside[_insideCount++] = z;
+      pushEvent(z, GEOFENCE_ENTER, iTOW);
+    }
+  }
+}
+
+bool Geofence::popEvent(GeofenceEvent_t* event)
+{
+  if (_eventCount == 0) {
+    return false;
+  }
+  *event = _events[_eventHead];
+  _eventHead = (_eventHead + 1) % GEOFENCE_EVENT_QUEUE;
+  _eventCount--;
+  return true;
+}
+
+uint32_t Geofence::getDroppedEvents()
+{
+  return _droppedEvents;
+}
+
+uint32_t Geofence::getTests()
+{
+  return _tests;
+}
+
+bool Geofence::contains(uint16_t zone, int32_t lat, int32_t lon)
+{
+  GeofenceZone_t z = readZone(zone);
+  GeofencePoint_t a;
+  GeofencePoint_t b;
+  bool inside = false;
+
+  _tests++;
+  if (z.count < 3) {
+    return false;
+  }
+  // Crossing number, exact : zones under 90 degrees keep the products in 64 bits
+  memcpy_P(&a, &_vertices[z.first + z.count - 1], sizeof(a));
+  for (uint16_t i = 0; i < z.count; i++) {
+    memcpy_P(&b, &_vertices[z.first + i], sizeof(b));
+    if ((a.lat > lat) != (b.lat > lat)) {
+      int64_t dLat = (int64_t)b.lat - a.lat;
+      int64_t cross = ((int64_t)b.lon - a.lon) * ((int64_t)lat - a.lat) - ((int64_t)lon - a.lon) * dLat;
+      if ((cross > 0) == (dLat > 0)) {
+        inside = !inside;
+      }
+    }
+    a = b;
+  }
+  return inside;
+}
+
+GeofenceZone_t Geofence::readZone(uint16_t zone)
+{
+  GeofenceZone_t z;
+
+  memcpy_P(&z, &_zones[zone], sizeof(z));
+  return z;
+}
+
+bool Geofence::boundingBox(uint16_t zone, GeofencePoint_t* low, GeofencePoint_t* high)
+{
+  GeofenceZone_t z = readZone(zone);
+  GeofencePoint_t p;
+
+  if (z.count < 3) {
+    return false;
+  }
+  for (uint16_t i = 0; i < z.count; i++) {
+    memcpy_P(&p, &_vertices[z.first + i], sizeof(p));
+    if (i == 0) {
+      *low = p;
+      *high = p;
+    }
+    low->lat = p.lat < low->lat ? p.lat : low->lat;
+    low->lon = p.lon < low->lon ? p.lon : low->lon;
+    high->lat = p.lat > high->lat ? p.lat : high->lat;
+    high->lon = p.lon > high->lon ? p.lon : high->lon;
+  }
+  return true;
+}
+
+int Geofence::cell(int32_t value, int32_t min, uint32_t size)
+{
+  int64_t index = ((int64_t)value - min) / size;
+
+  if (value < min || index >= GEOFENCE_GRID_SIZE) {
+    return -1;
+  }
+  return (int)index;
+}
+
+bool Geofence::isInside(uint16_t zone)
+{
+  for (int i = 0; i < _insideCount; i++) {
+    if (_inside[i] == zone) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Geofence::pushEvent(uint16_t zone, uint8_t type, uint32_t iTOW)
+{
+  if (_eventCount == GEOFENCE_EVENT_QUEUE) {
+    _droppedEvents++;
+    return;
+  }
+  GeofenceEvent_t& event = _events[(_eventHead + _eventCount) % GEOFENCE_EVENT_QUEUE];
+  event.id = readZone(zone).id;
+  event.type = type;
+  event.iTOW = iTOW;
+  _eventCount++;
+}
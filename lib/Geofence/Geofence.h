@@ -0,0 +1,81 @@
+#ifndef Geofence_h
+#define Geofence_h
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ARDUINO
+#include <pgmspace.h>
+#else
+#define PROGMEM
+#endif
+
+const int GEOFENCE_GRID_SIZE = 32;     /* Cells per side of the index */
+const int GEOFENCE_MAX_INSIDE = 16;    /* Zones the tracker can be in at once */
+const int GEOFENCE_EVENT_QUEUE = 8;
+
+/* Positions in 1e-7 degrees, as in NAV-PVT */
+typedef struct {
+  int32_t lat;
+  int32_t lon;
+} GeofencePoint_t;
+
+/* A polygon of the PROGMEM tables : count vertices from first, closed
+ * implicitly, less than 90 degrees across, not over the antimeridian */
+typedef struct {
+  uint16_t id;
+  uint16_t first;
+  uint16_t count;
+} GeofenceZone_t;
+
+typedef enum {
+  GEOFENCE_ENTER = 1,
+  GEOFENCE_LEAVE
+} GeofenceEventType_t;
+
+typedef struct {
+  uint16_t id;
+  uint8_t type;
+  uint32_t iTOW;  /* [ms] fix that crossed the boundary */
+} GeofenceEvent_t;
+
+/* Zone enter/leave detection, run on every fix. init() builds a uniform grid
+ * over the zones bounding boxes, each cell listing the zones overlapping it :
+ * a fix tests only the zones of its cell, plus the ones it is already in. */
+class Geofence {
+public:
+  Geofence();
+  ~Geofence();
+  /* zones and vertices in PROGMEM, false if the index does not fit in RAM */
+  bool init(const GeofenceZone_t* zones, uint16_t zoneCount, const GeofencePoint_t* vertices);
+  void update(int32_t lat, int32_t lon, uint32_t iTOW);
+  bool popEvent(GeofenceEvent_t* event);
+  uint32_t getDroppedEvents(); /* Queue full, the loop did not pop them */
+  uint32_t getTests(); /* Point in polygon tests so far */
+  bool contains(uint16_t zone, int32_t lat, int32_t lon); /* Index in the zone table */
+private:
+  const GeofenceZone_t* _zones;
+  const GeofencePoint_t* _vertices;
+  uint16_t _zoneCount;
+  int32_t _minLat;
+  int32_t _minLon;
+  uint32_t _cellLat;    /* Cell size [1e-7 deg] */
+  uint32_t _cellLon;
+  uint16_t* _cellStart; /* GEOFENCE_GRID_SIZE^2 + 1 offsets in _cellZones */
+  uint16_t* _cellZones;
+  uint16_t _inside[GEOFENCE_MAX_INSIDE];
+  int _insideCount;
+  GeofenceEvent_t _events[GEOFENCE_EVENT_QUEUE];
+  int _eventHead;
+  int _eventCount;
+  uint32_t _droppedEvents;
+  uint32_t _tests;
+  GeofenceZone_t readZone(uint16_t zone);
+  bool boundingBox(uint16_t zone, GeofencePoint_t* low, GeofencePoint_t* high);
+  int cell(int32_t value, int32_t min, uint32_t size);
+  bool isInside(uint16_t zone);
+  void pushEvent(uint16_t zone, uint8_t type, uint32_t iTOW);
+};
+
+extern Geofence geofence;
+
+#endif
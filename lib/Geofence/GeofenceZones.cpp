@@ -0,0 +1,33 @@
+#include <GeofenceZones.h>
+
+#ifdef GEOFENCE_EXAMPLE_ZONES
+/* Vertices of every zone one after the other, in 1e-7 degrees (lat, lon).
+ * The zones are examples, only built with -DGEOFENCE_EXAMPLE_ZONES : replace
+ * them with the ones of the flying site. */
+const GeofencePoint_t GEOFENCE_VERTICES[] PROGMEM = {
+  /* 1 : take-off area */
+  { 456000000, 58000000 },
+  { 456000000, 58020000 },
+  { 456015000, 58020000 },
+  { 456015000, 58000000 },
+  /* 2 : no-fly zone */
+  { 456100000, 58100000 },
+  { 456120000, 58150000 },
+  { 456080000, 58180000 },
+  { 456050000, 58120000 },
+};
+
+const GeofenceZone_t GEOFENCE_ZONES[] PROGMEM = {
+  /* id, first vertex, vertices */
+  { 1, 0, 4 },
+  { 2, 4, 4 },
+};
+
+const uint16_t GEOFENCE_ZONE_COUNT = sizeof(GEOFENCE_ZONES) / sizeof(GEOFENCE_ZONES[0]);
+#else
+/* No zone by default : MSG_GEOFENCE only reports zones of the flying site
+ * once they are filled in here, in the format of the examples above */
+const GeofencePoint_t GEOFENCE_VERTICES[1] PROGMEM = {};
+const GeofenceZone_t GEOFENCE_ZONES[1] PROGMEM = {};
+const uint16_t GEOFENCE_ZONE_COUNT = 0;
+#endif
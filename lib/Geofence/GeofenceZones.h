@@ -0,0 +1,11 @@
+#ifndef GeofenceZones_h
+#define GeofenceZones_h
+
+#include <Geofence.h>
+
+/* Zones of the flying site, see GeofenceZones.cpp */
+extern const GeofencePoint_t GEOFENCE_VERTICES[] PROGMEM;
+extern const GeofenceZone_t GEOFENCE_ZONES[] PROGMEM;
+extern const uint16_t GEOFENCE_ZONE_COUNT;
+
+#endif
@@ -3,47 +3,100 @@
 
 LEDManager::LEDManager(int pin) {
       _pin = pin;
-      _timerLED = millis();
+      _pattern.onMs = 0;
+      _pattern.offMs = 0;
+      _pattern.blinks = 0;
+      _pattern.pauseMs = 0;
+      _changed = true;
       _ledIsOn = false;
+      _blinkCount = 0;
+      _remainingMs = 0;
 }
 
-void LEDManager::blink(int thresholdOn, int thresholdOff) {
-  if(thresholdOn==0 && thresholdOff==0)
-  {
-    digitalWrite(_pin,LOW);
-  }
-  else if(thresholdOn==1 && thresholdOff==1)
-  {
-    digitalWrite(_pin,LOW);
-  }
-  if ((millis()-_timerLED) >= thresholdOff && !_ledIsOn) {
-    digitalWrite(_pin,HIGH);
-    _ledIsOn = true;
-    _timerLED = millis();
-  }
-  if ((millis()-_timerLED) >= thresholdOn && _ledIsOn) {
-    digitalWrite(_pin,LOW);
-    _ledIsOn = false;
-    _timerLED = millis();
+void LEDManager::init() {
+  pinMode(_pin, OUTPUT);
+  digitalWrite(_pin, LOW);
+  _ticker.attach_ms(TICK_MS, LEDManager::onTick, this);
+}
+
+void LEDManager::onTick(LEDManager* led) {
+  led->tick();
+}
+
+void LEDManager::setPattern(const LEDPattern_t& pattern) {
+  // Called every loop : only restart the pattern when it changes
+  if (pattern.onMs == _pattern.onMs && pattern.offMs == _pattern.offMs &&
+      pattern.blinks == _pattern.blinks && pattern.pauseMs == _pattern.pauseMs) {
+    return;
   }
+  _pattern.onMs = pattern.onMs;
+  _pattern.offMs = pattern.offMs;
+  _pattern.blinks = pattern.blinks;
+  _pattern.pauseMs = pattern.pauseMs;
+  _changed = true;
 }
 
 void LEDManager::status(bool wifiOk, bool gpsOk) {
   if(wifiOk && !gpsOk)
   {
-    blink(1e3,1e3);
+    setPattern(LED_PATTERN_NO_GPS_FIX);
   }
-
   else if(!wifiOk && gpsOk)
   {
-    blink(1e2,1e2);
+    setPattern(LED_PATTERN_NO_WIFI);
   }
   else if(wifiOk && gpsOk)
   {
-    blink(1,0);
+    setPattern(LED_PATTERN_ON);
   }
   else
   {
-    blink(0,0);
+    setPattern(LED_PATTERN_OFF);
+  }
+}
+
+void LEDManager::tick() {
+  if (_changed) {
+    _changed = false;
+    _blinkCount = 0;
+    _remainingMs = 0;
+    write(false);
+  }
+  if (_remainingMs > TICK_MS) {
+    _remainingMs -= TICK_MS;
+    return;
+  }
+  nextStep();
+}
+
+void LEDManager::write(bool on) {
+  if (on != _ledIsOn) {
+    digitalWrite(_pin, on ? HIGH : LOW);
+    _ledIsOn = on;
+  }
+}
+
+void LEDManager::nextStep() {
+  if (_pattern.onMs == 0) {
+    // Steady off until next pattern change
+    write(false);
+    _remainingMs = UINT32_MAX;
+  }
+  else if (_pattern.offMs == 0 && _pattern.pauseMs == 0) {
+    // Steady on until next pattern change
+    write(true);
+    _remainingMs = UINT32_MAX;
+  }
+  else if (!_ledIsOn) {
+    write(true);
+    _remainingMs = _pattern.onMs;
+  }
+  else {
+    write(false);
+    _remainingMs = _pattern.offMs;
+    if (_pattern.blinks != 0 && ++_blinkCount >= _pattern.blinks) {
+      _blinkCount = 0;
+      _remainingMs = _pattern.pauseMs;
+    }
   }
 }
@@ -1,15 +1,45 @@
 #ifndef LEDManager_h
 #define LEDManager_h
 
+#include <Arduino.h>
+#include <Ticker.h>
+
+/* Blink pattern : blinks times on/off, then pause (blinks = 0 repeats on/off
+ * forever). onMs = 0 keeps the LED off, offMs = pauseMs = 0 keeps it on. */
+typedef struct {
+  uint16_t onMs;
+  uint16_t offMs;
+  uint8_t blinks;
+  uint16_t pauseMs;
+} LEDPattern_t;
+
+const LEDPattern_t LED_PATTERN_OFF = {0, 0, 0, 0};
+const LEDPattern_t LED_PATTERN_ON = {1, 0, 0, 0};
+const LEDPattern_t LED_PATTERN_NO_GPS_FIX = {1000, 1000, 0, 0};
+const LEDPattern_t LED_PATTERN_NO_WIFI = {100, 100, 0, 0};
+const LEDPattern_t LED_PATTERN_WIFI_RECONNECTING = {100, 200, 2, 1000};
+const LEDPattern_t LED_PATTERN_BUFFER_OVERFLOW = {100, 200, 3, 1000};
+
 class LEDManager {
 public:
+  static const uint32_t TICK_MS = 10;
+
   LEDManager(int pin);
-  void blink(int thresholdOn, int thresholdOff);
+  void init(); /* Setup pin and start the timer driving it */
+  void setPattern(const LEDPattern_t& pattern);
   void status(bool wifiOk, bool gpsOk);
+  void tick(); /* Advance the pattern by TICK_MS, called from the timer */
 private:
   int _pin;
-  int _timerLED;
+  Ticker _ticker;
+  volatile LEDPattern_t _pattern;
+  volatile bool _changed;
   bool _ledIsOn;
+  uint8_t _blinkCount;
+  uint32_t _remainingMs;
+  static void onTick(LEDManager* led);
+  void write(bool on);
+  void nextStep();
 };
 
 #endif
@@ -1,43 +1,246 @@
 #include <MessagesManager.h>
+#include <ESP8266WiFi.h>
 #include <libpomp.h>
 #include <pomp_priv.h>
+#include <Profiler.h>
+#include <Types.h>
 
 MessagesManager::MessagesManager(){
-  strcpy(_host,"0.0.0.0");
-  _port = 0;
+  _msg = pomp_msg_new();
+  _destinationCount = 0;
+  _backlogHead = 0;
+  _backlogCount = 0;
+  _dropped = 0;
+  _sendFailures = 0;
+  // Lets the ground tell a reboot from a sequence wrap
+  _session = RANDOM_REG32;
+  _seq = 0;
+  _fecK = 0;
+  _fecCount = 0;
+  _fecFirstSeq = 0;
+  _fecLenXor = 0;
+  _fecMaxLen = 0;
 }
 
-void MessagesManager::init(const char* host, const uint32_t port)
+int MessagesManager::addDestination(const char host[], const uint16_t port, const uint32_t minInterval)
 {
-  strcpy(_host,host);
-  _port = port;
-  client.begin(_port);
+  if (_destinationCount == MAX_DESTINATIONS) {
+    return -1;
+  }
+  Destination_t& destination = _destinations[_destinationCount];
+  destination.host = host;
+  destination.address = IPAddress();
+  destination.resolved = false;
+  destination.lastResolve = 0;
+  destination.port = port;
+  destination.enabled = true;
+  destination.minInterval = minInterval;
+  destination.lastSend = 0;
+  return _destinationCount++;
+}
+
+void MessagesManager::setDestinationEnabled(int index, bool enabled)
+{
+  if (index >= 0 && index < _destinationCount) {
+    _destinations[index].enabled = enabled;
+  }
+}
+
+void MessagesManager::init()
+{
+  // Resolved once, beginPacket would parse the string for every packet
+  for (int i = 0; i < _destinationCount; i++) {
+    resolve(_destinations[i]);
+  }
+  if (_destinationCount > 0) {
+    client.begin(_destinations[0].port);
+  }
 }
 
 void MessagesManager::send(uint32_t msgid, const char *fmt, ...)
 {
-  struct pomp_msg msg = POMP_MSG_INITIALIZER;
   struct pomp_encoder enc = POMP_ENCODER_INITIALIZER;
+  uint32_t seq = _seq++;
 
   va_list args;
   va_start(args, fmt);
 
-  pomp_msg_init(&msg,msgid);
+  {
+    PROFILE_SCOPE(PROFILE_ENCODE);
+    // No allocation unless the previous buffer went to the backlog
+    pomp_msg_reinit(_msg,msgid);
+    pomp_encoder_init(&enc,_msg);
+    pomp_encoder_write_u32(&enc,_session);
+    pomp_encoder_write_u32(&enc,seq);
+    pomp_encoder_writev(&enc,fmt,args);
+    pomp_msg_finish(_msg);
+  }
+
+  struct pomp_buffer* buf = pomp_msg_get_buffer(_msg);
+
+  dispatch(buf);
+  if (_fecK > 0) {
+    addParity(buf,seq);
+  }
+
+  va_end(args);
+}
+
+void MessagesManager::process()
+{
+  if (WiFi.status() != WL_CONNECTED || _destinationCount == 0) {
+    return;
+  }
+  // At most one lookup per call, each destination once per RESOLVE_INTERVAL
+  uint32_t now = millis();
+  for (int i = 0; i < _destinationCount; i++) {
+    Destination_t& destination = _destinations[i];
+    if (!destination.resolved && destination.enabled && now - destination.lastResolve >= RESOLVE_INTERVAL) {
+      resolve(destination);
+      break;
+    }
+  }
+  // Bounded so a long outage does not stall the loop once back online
+  for (int i = 0; i < BACKLOG_FLUSH_MAX && _backlogCount > 0; i++) {
+    struct pomp_buffer* buf = _backlog[_backlogHead];
+    _backlogHead = (_backlogHead + 1) % BACKLOG_SIZE;
+    _backlogCount--;
+    sendBuffer(buf);
+    pomp_buffer_unref(buf);
+  }
+}
+
+bool MessagesManager::isBacklogFull()
+{
+  return _backlogCount == BACKLOG_SIZE;
+}
+
+uint32_t MessagesManager::getDroppedCount()
+{
+  return _dropped;
+}
+
+void MessagesManager::setFEC(uint8_t k)
+{
+  _fecK = k > FEC_MAX_GROUP ? FEC_MAX_GROUP : k;
+  _fecCount = 0;
+}
+
+uint32_t MessagesManager::getSendFailures()
+{
+  return _sendFailures;
+}
+
+void MessagesManager::dispatch(struct pomp_buffer* buf)
+{
+  // Keep order : older messages go first
+  if (WiFi.status() == WL_CONNECTED && _backlogCount == 0) {
+    sendBuffer(buf);
+  } else {
+    pushBacklog(buf);
+  }
+}
+
+void MessagesManager::addParity(struct pomp_buffer* buf, uint32_t seq)
+{
+  const void* cdata;
+  size_t len;
+
+  pomp_buffer_get_cdata(buf,&cdata,&len,NULL);
+  if (len > FEC_MAX_SIZE) {
+    // Group cannot be protected, start a new one after this message
+    _fecCount = 0;
+    return;
+  }
+  if (_fecCount == 0) {
+    memset(_fecParity,0,sizeof(_fecParity));
+    _fecFirstSeq = seq;
+    _fecLenXor = 0;
+    _fecMaxLen = 0;
+  }
+  // Shorter messages count as zero padded up to the longest one
+  const uint8_t* data = (const uint8_t*)cdata;
+  for (size_t i = 0; i < len; i++) {
+    _fecParity[i] ^= data[i];
+  }
+  _fecLenXor ^= len;
+  if (len > _fecMaxLen) {
+    _fecMaxLen = len;
+  }
+  if (++_fecCount < _fecK) {
+    return;
+  }
+  _fecCount = 0;
+
+  // Not numbered, its first arguments identify the protected group
+  struct pomp_msg msg = POMP_MSG_INITIALIZER;
+  struct pomp_encoder enc = POMP_ENCODER_INITIALIZER;
+
+  pomp_msg_init(&msg,MSG_FEC);
   pomp_encoder_init(&enc,&msg);
-  pomp_encoder_writev(&enc,fmt,args);
+  pomp_encoder_write(&enc,"%u%u%u%u%p%u",
+    _session,
+    _fecFirstSeq,
+    (uint32_t)_fecK,
+    _fecLenXor,
+    _fecParity,
+    _fecMaxLen);
   pomp_msg_finish(&msg);
+  dispatch(pomp_msg_get_buffer(&msg));
+  pomp_msg_clear(&msg);
+}
 
+void MessagesManager::sendBuffer(struct pomp_buffer* buf)
+{
+  PROFILE_SCOPE(PROFILE_UDP_SEND);
   const void* cdata;
   size_t len;
-  struct pomp_buffer* buf;
 
-  buf = pomp_msg_get_buffer(&msg);
   pomp_buffer_get_cdata(buf,&cdata,&len,NULL);
 
-  client.beginPacket(_host,_port);
-  client.write((const uint8_t *)cdata,len);
-  client.endPacket();
+  uint32_t now = millis();
+  for (int i = 0; i < _destinationCount; i++) {
+    Destination_t& destination = _destinations[i];
+    // 0.0.0.0 would only fail in the stack
+    if (!destination.enabled || !destination.resolved) {
+      continue;
+    }
+    if (destination.minInterval > 0) {
+      if (now - destination.lastSend < destination.minInterval) {
+        continue;
+      }
+      destination.lastSend = now;
+    }
+    if (!client.beginPacket(destination.address,destination.port)) {
+      _sendFailures++;
+      continue;
+    }
+    client.write((const uint8_t *)cdata,len);
+    if (!client.endPacket()) {
+      _sendFailures++;
+    }
+  }
+}
+
+void MessagesManager::resolve(Destination_t& destination)
+{
+  destination.lastResolve = millis();
+  destination.resolved = WiFi.hostByName(destination.host,destination.address) == 1;
+  if (!destination.resolved) {
+    destination.address = IPAddress();
+  }
+}
 
-  va_end(args);
-  pomp_msg_clear(&msg);
+void MessagesManager::pushBacklog(struct pomp_buffer* buf)
+{
+  // Drop the oldest message, the newest are the most useful
+  if (_backlogCount == BACKLOG_SIZE) {
+    pomp_buffer_unref(_backlog[_backlogHead]);
+    _backlogHead = (_backlogHead + 1) % BACKLOG_SIZE;
+    _backlogCount--;
+    _dropped++;
+  }
+  pomp_buffer_ref(buf);
+  _backlog[(_backlogHead + _backlogCount) % BACKLOG_SIZE] = buf;
+  _backlogCount++;
 }
@@ -3,16 +3,70 @@
 
 #include <Arduino.h>
 #include <WiFiUdp.h>
+#include <IPAddress.h>
+
+struct pomp_buffer;
+struct pomp_msg;
+
+/* Ground station receiving every message, encoded once for all of them */
+typedef struct {
+  const char* host;     /* Kept as given, resolved by init() */
+  IPAddress address;
+  bool resolved;        /* Skipped until then, process() tries again */
+  uint32_t lastResolve; /* [ms] */
+  uint16_t port;
+  bool enabled;
+  uint32_t minInterval; /* [ms] 0 sends every message */
+  uint32_t lastSend;    /* [ms] */
+} Destination_t;
 
 class MessagesManager {
   public:
+  static const int MAX_DESTINATIONS = 4;
+
   MessagesManager();
-  void init(const char host[],const uint32_t port);
+  /* Returns the destination index, -1 if the list is full. A rate limited
+   * destination skips messages, it sees them as lost. */
+  int addDestination(const char host[], const uint16_t port, const uint32_t minInterval = 0);
+  void setDestinationEnabled(int index, bool enabled);
+  void init(); /* Resolves destinations, call once connected */
+  /* Every message starts with two implicit %u : session id, sequence number */
   void send(uint32_t msgid, const char *fmt, ...);
+  void process(); /* Send messages kept while WiFi was down, resolve destinations init() could not */
+  bool isBacklogFull();
+  uint32_t getDroppedCount();
+  uint32_t getSendFailures(); /* UDP packets the stack refused */
+  /* Follow every k messages by a MSG_FEC XOR parity message so the ground
+   * (tools/ground/FecDecoder) can rebuild a single loss per group. 0 disables it. */
+  void setFEC(uint8_t k);
+  static const int FEC_MAX_GROUP = 16;
+  static const int FEC_MAX_SIZE = 256; /* Bigger messages are not protected */
 private:
-  char _host[15];
-  uint32_t _port;
+  static const int BACKLOG_SIZE = 32;
+  static const int BACKLOG_FLUSH_MAX = 8; /* Per process() call */
+  static const uint32_t RESOLVE_INTERVAL = 30000; /* [ms] hostByName blocks until the DNS answers or times out */
+  Destination_t _destinations[MAX_DESTINATIONS];
+  int _destinationCount;
   WiFiUDP client;
+  struct pomp_msg* _msg; /* Reused while its buffer is not held by the backlog */
+  struct pomp_buffer* _backlog[BACKLOG_SIZE];
+  int _backlogHead;
+  int _backlogCount;
+  uint32_t _dropped;
+  uint32_t _sendFailures;
+  uint32_t _session;
+  uint32_t _seq;
+  uint8_t _fecK;
+  uint8_t _fecCount;
+  uint32_t _fecFirstSeq;
+  uint32_t _fecLenXor;
+  uint32_t _fecMaxLen;
+  uint8_t _fecParity[FEC_MAX_SIZE];
+  void dispatch(struct pomp_buffer* buf);
+  void addParity(struct pomp_buffer* buf, uint32_t seq);
+  void sendBuffer(struct pomp_buffer* buf);
+  void resolve(Destination_t& destination);
+  void pushBacklog(struct pomp_buffer* buf);
 };
 
 #endif
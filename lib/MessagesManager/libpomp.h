@@ -134,6 +134,9 @@ POMP_API void pomp_buffer_unref(struct pomp_buffer *buf);
  * @param capacity : new capacity of buffer (shall be greater than used length).
  * @return 0 in case of success, negative errno value in case of error.
  * -EPERM is returned if the buffer is shared (ref count is greater than 1).
+ *
+ * @remarks : capacities that fit in the inline storage of the buffer do not
+ * allocate anything, the capacity is then the size of the inline storage.
  */
 POMP_API int pomp_buffer_set_capacity(struct pomp_buffer *buf, size_t capacity);
 
@@ -524,6 +527,254 @@ POMP_API int pomp_encoder_write_f64(struct pomp_encoder *enc, double v);
  */
 POMP_API int pomp_encoder_write_fd(struct pomp_encoder *enc, int v);
 
+/*
+ * Decoder API (Advanced).
+ */
+
+/**
+ * Create a new decoder object.
+ * @return new decoder object or NULL in case of error.
+ */
+POMP_API struct pomp_decoder *pomp_decoder_new(void);
+
+/**
+ * Destroy a decoder object.
+ * @param dec : decoder.
+ * @return 0 in case of success, negative errno value in case of error.
+ *
+ * @remarks the associated message is NOT destroyed.
+ */
+POMP_API int pomp_decoder_destroy(struct pomp_decoder *dec);
+
+/**
+ * Initialize a decoder object before starting to decode a message.
+ * @param dec : decoder.
+ * @param msg : message to decode.
+ * @return 0 in case of success, negative errno value in case of error.
+ *
+ * @remarks the message ownership is not transferred, it will NOT be destroyed
+ * when decoder object is destroyed.
+ */
+POMP_API int pomp_decoder_init(struct pomp_decoder *dec,
+		const struct pomp_msg *msg);
+
+/**
+ * Initialize a decoder object directly over received data (header + payload)
+ * without copying it in a message.
+ * @param dec : decoder.
+ * @param data : data of the message, as received from the transport.
+ * @param len : size of data. It can be greater than the message size.
+ * @param msgid : will receive the id of the message (optional can be NULL).
+ * @return size of the message in case of success, negative errno value in case
+ * of error (-EINVAL if the header is invalid, -EAGAIN if data is truncated).
+ *
+ * @remarks data is not copied, it shall remain valid and unmodified as long as
+ * the decoder is used, as well as any string or buffer read from it.
+ */
+POMP_API int pomp_decoder_init_with_data(struct pomp_decoder *dec,
+		const void *data, size_t len, uint32_t *msgid);
+
+/**
+ * Clear decoder object.
+ * @param dec : decoder.
+ * @return 0 in case of success, negative errno value in case of error.
+ *
+ * @remarks the associated message is NOT destroyed.
+ */
+POMP_API int pomp_decoder_clear(struct pomp_decoder *dec);
+
+/**
+ * Decode arguments according to given format string.
+ * @param dec : decoder.
+ * @param fmt : format string. Can be NULL if no arguments given.
+ * @param ... : arguments.
+ * @return 0 in case of success, negative errno value in case of error.
+ *
+ * @remarks '%ms' expects a 'char **' and '%p%u' a 'void **' followed by an
+ * 'unsigned int *'. They receive pointers inside the decoded data (no copy),
+ * that shall be considered read-only and not be freed.
+ */
+POMP_API int pomp_decoder_read(struct pomp_decoder *dec,
+		const char *fmt, ...) POMP_ATTRIBUTE_FORMAT_SCANF(2, 3);
+
+/**
+ * Decode arguments according to given format string.
+ * @param dec : decoder.
+ * @param fmt : format string. Can be NULL if no arguments given.
+ * @param args : arguments.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_readv(struct pomp_decoder *dec,
+		const char *fmt, va_list args);
+
+/**
+ * Decode a 8-bit signed integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_i8(struct pomp_decoder *dec, int8_t *v);
+
+/**
+ * Decode a 8-bit unsigned integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_u8(struct pomp_decoder *dec, uint8_t *v);
+
+/**
+ * Decode a 16-bit signed integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_i16(struct pomp_decoder *dec, int16_t *v);
+
+/**
+ * Decode a 16-bit unsigned integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_u16(struct pomp_decoder *dec, uint16_t *v);
+
+/**
+ * Decode a 32-bit signed integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_i32(struct pomp_decoder *dec, int32_t *v);
+
+/**
+ * Decode a 32-bit unsigned integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_u32(struct pomp_decoder *dec, uint32_t *v);
+
+/**
+ * Decode a 64-bit signed integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_i64(struct pomp_decoder *dec, int64_t *v);
+
+/**
+ * Decode a 64-bit unsigned integer.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_u64(struct pomp_decoder *dec, uint64_t *v);
+
+/**
+ * Decode a string without copy.
+ * @param dec : decoder.
+ * @param v : will receive a pointer to the null terminated string inside the
+ * decoded data.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_cstr(struct pomp_decoder *dec, const char **v);
+
+/**
+ * Decode a buffer without copy.
+ * @param dec : decoder.
+ * @param v : will receive a pointer to the buffer inside the decoded data.
+ * @param n : buffer size.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_cbuf(struct pomp_decoder *dec, const void **v,
+		uint32_t *n);
+
+/**
+ * Decode a 32-bit floating point.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_f32(struct pomp_decoder *dec, float *v);
+
+/**
+ * Decode a 64-bit floating point.
+ * @param dec : decoder.
+ * @param v : decoded value.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+POMP_API int pomp_decoder_read_f64(struct pomp_decoder *dec, double *v);
+
+/*
+ * Varint API (Advanced).
+ */
+
+/**
+ * Encode an array of unsigned 32-bit integers as variable length integers,
+ * with the same format as the integer arguments of a message.
+ * @param src : values to encode.
+ * @param count : number of values.
+ * @param dst : destination, shall have room for 5 bytes per value.
+ * @return number of bytes written.
+ */
+POMP_API size_t pomp_varint_encode_u32_array(const uint32_t *src, size_t count,
+		void *dst);
+
+/**
+ * Decode an array of unsigned 32-bit integers encoded with
+ * pomp_varint_encode_u32_array.
+ * @param src : source.
+ * @param len : size of source.
+ * @param dst : decoded values.
+ * @param count : number of values to decode.
+ * @return number of bytes read, negative errno value in case of error.
+ */
+POMP_API int pomp_varint_decode_u32_array(const void *src, size_t len,
+		uint32_t *dst, size_t count);
+
+/**
+ * Encode an array of signed 32-bit integers as zigzag variable length
+ * integers, with the same format as the integer arguments of a message.
+ * @param src : values to encode.
+ * @param count : number of values.
+ * @param dst : destination, shall have room for 5 bytes per value.
+ * @return number of bytes written.
+ */
+POMP_API size_t pomp_varint_encode_i32_array(const int32_t *src, size_t count,
+		void *dst);
+
+/**
+ * Decode an array of signed 32-bit integers encoded with
+ * pomp_varint_encode_i32_array.
+ * @param src : source.
+ * @param len : size of source.
+ * @param dst : decoded values.
+ * @param count : number of values to decode.
+ * @return number of bytes read, negative errno value in case of error.
+ */
+POMP_API int pomp_varint_decode_i32_array(const void *src, size_t len,
+		int32_t *dst, size_t count);
+
+/**
+ * Zigzag encode an array of signed 32-bit integers.
+ * @param src : values to encode.
+ * @param dst : encoded values, can be the same array as src.
+ * @param count : number of values.
+ */
+POMP_API void pomp_varint_zigzag_encode_i32_array(const int32_t *src,
+		uint32_t *dst, size_t count);
+
+/**
+ * Zigzag decode an array of unsigned 32-bit integers.
+ * @param src : values to decode.
+ * @param dst : decoded values, can be the same array as src.
+ * @param count : number of values.
+ */
+POMP_API void pomp_varint_zigzag_decode_i32_array(const uint32_t *src,
+		int32_t *dst, size_t count);
+
+
 
 #ifdef __cplusplus
 }
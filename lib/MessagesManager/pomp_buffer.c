@@ -11,6 +11,9 @@
  * internally so all operations can be mixed without problems.
  * The buffer structure only stores the data, and size used.
  *
+ * Small data is stored inside the buffer structure itself, it is moved to a
+ * separate allocation only when the capacity exceeds POMP_BUFFER_INLINE_SIZE.
+ *
  * @author yves-marie.morgan@parrot.com
  *
  * Copyright (c) 2014 Parrot S.A.
@@ -121,10 +124,11 @@ int pomp_buffer_clear(struct pomp_buffer *buf)
 	buf->fdcount = 0;
 	memset(buf->fdoffs, 0, sizeof(buf->fdoffs));
 
-	/* Free internal data */
-	free(buf->data);
-	buf->data = NULL;
-	buf->capacity = 0;
+	/* Free internal data, go back to inline storage */
+	if (buf->data != buf->inlinedata)
+		free(buf->data);
+	buf->data = buf->inlinedata;
+	buf->capacity = POMP_BUFFER_INLINE_SIZE;
 	buf->len = 0;
 	return 0;
 }
@@ -141,9 +145,12 @@ struct pomp_buffer *pomp_buffer_new(size_t capacity)
 	if (buf == NULL)
 		return NULL;
 	buf->refcount = 1;
+	buf->data = buf->inlinedata;
+	buf->capacity = POMP_BUFFER_INLINE_SIZE;
 
 	/* Set initial capacity */
-	if (capacity != 0 && pomp_buffer_set_capacity(buf, capacity) < 0) {
+	if (capacity > buf->capacity
+			&& pomp_buffer_set_capacity(buf, capacity) < 0) {
 		free(buf);
 		return NULL;
 	}
@@ -244,14 +251,7 @@ struct pomp_buffer *pomp_buffer_new_get_data(size_t capacity, void **data)
  */
 void pomp_buffer_ref(struct pomp_buffer *buf)
 {
-#if defined(__GNUC__)
-	__sync_add_and_fetch(&buf->refcount, 1);
-#elif defined(_WIN32)
-	/* codecheck_ignore[SPACING,VOLATILE] */
-	InterlockedIncrement((long volatile *)&buf->refcount);
-#else
-#error No atomic increment function found on this platform
-#endif
+	POMP_ATOMIC_ADD_FETCH(&buf->refcount, 1);
 }
 
 /*
@@ -259,15 +259,7 @@ void pomp_buffer_ref(struct pomp_buffer *buf)
  */
 void pomp_buffer_unref(struct pomp_buffer *buf)
 {
-	uint32_t res = 0;
-// #if defined(__GNUC__)
-// 	res = __sync_sub_and_fetch(&buf->refcount, 1);
-// #elif defined(_WIN32)
-	/* codecheck_ignore[SPACING,VOLATILE] */
-// res = (uint32_t)InterlockedDecrement((long volatile *)&buf->refcount);
-// #else
-// #error No atomic decrement function found on this platform
-// #endif
+	uint32_t res = POMP_ATOMIC_SUB_FETCH(&buf->refcount, 1);
 
 	/* Free resource when ref count reaches 0 */
 	if (res == 0) {
@@ -286,10 +278,28 @@ int pomp_buffer_set_capacity(struct pomp_buffer *buf, size_t capacity)
 	POMP_RETURN_ERR_IF_FAILED(capacity >= buf->len, -EINVAL);
 	POMP_RETURN_ERR_IF_FAILED(buf->refcount <= 1, -EPERM);
 
-	/* Resize internal data */
-	data = realloc(buf->data, capacity);
-	if (data == NULL)
-		return -ENOMEM;
+	/* Small capacity, use inline storage (moving data back if needed) */
+	if (capacity <= POMP_BUFFER_INLINE_SIZE) {
+		if (buf->data != buf->inlinedata) {
+			memcpy(buf->inlinedata, buf->data, buf->len);
+			free(buf->data);
+			buf->data = buf->inlinedata;
+		}
+		buf->capacity = POMP_BUFFER_INLINE_SIZE;
+		return 0;
+	}
+
+	/* Resize internal data, spill inline data to the heap the first time */
+	if (buf->data == buf->inlinedata) {
+		data = malloc(capacity);
+		if (data == NULL)
+			return -ENOMEM;
+		memcpy(data, buf->inlinedata, buf->len);
+	} else {
+		data = realloc(buf->data, capacity);
+		if (data == NULL)
+			return -ENOMEM;
+	}
 	buf->data = data;
 	buf->capacity = capacity;
 	return 0;
@@ -11,6 +11,9 @@
  * internally so all operations can be mixed without problems.
  * The buffer structure only stores the data, and size used.
  *
+ * Small data is stored inside the buffer structure itself, it is moved to a
+ * separate allocation only when the capacity exceeds POMP_BUFFER_INLINE_SIZE.
+ *
  * @author yves-marie.morgan@parrot.com
  *
  * Copyright (c) 2014 Parrot S.A.
@@ -43,6 +46,10 @@
 #ifndef _POMP_BUFFER_H_
 #define _POMP_BUFFER_H_
 
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
 /** Allocation step in buffer (shall be a power of 2) */
 #define POMP_BUFFER_ALLOC_STEP	(256u)
 
@@ -50,19 +57,27 @@
 #define POMP_BUFFER_ALIGN_ALLOC_SIZE(_x) \
 	(((_x) + POMP_BUFFER_ALLOC_STEP - 1) & (~(POMP_BUFFER_ALLOC_STEP - 1)))
 
+/** Size of storage embedded in buffer structure (fits telemetry messages) */
+#ifndef POMP_BUFFER_INLINE_SIZE
+#  define POMP_BUFFER_INLINE_SIZE	(128u)
+#endif
+
 /** Maximum number of file descriptor that can be put in a buffer */
 #define POMP_BUFFER_MAX_FD_COUNT	4
 
 /** Reference counted buffer */
 struct pomp_buffer {
 	uint32_t	refcount;	/**< Reference count */
-	uint8_t		*data;		/**< Allocated data */
+	uint8_t		*data;		/**< Data (inline or allocated) */
 	size_t		capacity;	/**< Allocated size */
 	size_t		len;		/**< Used length */
 	uint32_t	fdcount;	/**< Number of fds put in buffer */
 
 	/** Offsets in buffer where a file descriptor was put */
 	size_t		fdoffs[POMP_BUFFER_MAX_FD_COUNT];
+
+	/** Inline storage used while data fits in it */
+	uint8_t		inlinedata[POMP_BUFFER_INLINE_SIZE];
 };
 
 int pomp_buffer_get_fd(const struct pomp_buffer *buf, size_t off);
@@ -90,4 +105,8 @@ int pomp_buffer_readb(const struct pomp_buffer *buf, size_t *pos, uint8_t *b);
 
 int pomp_buffer_read_fd(struct pomp_buffer *buf, size_t *pos, int *fd);
 
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
 #endif /* !_POMP_BUFFER_H_ */
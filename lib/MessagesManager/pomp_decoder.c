@@ -0,0 +1,659 @@
+/**
+ * @file pomp_decoder.c
+ *
+ * @brief Handle message payload decoding.
+ *
+ * The decoder never copies the payload : it reads fields directly from the
+ * data of the message (or from the data given by the caller), strings and
+ * buffers are returned as pointers inside this data.
+ *
+ * @author yves-marie.morgan@parrot.com
+ *
+ * Copyright (c) 2014 Parrot S.A.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "pomp_priv.h"
+
+/* Integer flag found in format specifier */
+#define FLAG_L	0x01	/**< %l format specifier */
+#define FLAG_LL	0x02	/**< %ll format specifier */
+#define FLAG_H	0x04	/**< %h format specifier */
+#define FLAG_HH	0x08	/**< %hh format specifier */
+#define FLAG_M	0x10	/**< %m format specifier */
+
+/*
+ * See documentation in public header.
+ */
+struct pomp_decoder *pomp_decoder_new(void)
+{
+	struct pomp_decoder *dec = NULL;
+	dec = calloc(1, sizeof(*dec));
+	if (dec == NULL)
+		return NULL;
+	return dec;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_destroy(struct pomp_decoder *dec)
+{
+	POMP_RETURN_ERR_IF_FAILED(dec != NULL, -EINVAL);
+	free(dec);
+	return 0;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_init(struct pomp_decoder *dec, const struct pomp_msg *msg)
+{
+	POMP_RETURN_ERR_IF_FAILED(dec != NULL, -EINVAL);
+	POMP_RETURN_ERR_IF_FAILED(msg != NULL, -EINVAL);
+	POMP_RETURN_ERR_IF_FAILED(msg->buf != NULL, -EINVAL);
+	POMP_RETURN_ERR_IF_FAILED(msg->finished, -EINVAL);
+	dec->msg = msg;
+	dec->data = msg->buf->data;
+	dec->len = msg->buf->len;
+	dec->pos = POMP_PROT_HEADER_SIZE;
+	return 0;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_init_with_data(struct pomp_decoder *dec,
+		const void *data, size_t len, uint32_t *msgid)
+{
+	const uint8_t *p = data;
+	uint32_t d = 0;
+
+	POMP_RETURN_ERR_IF_FAILED(dec != NULL, -EINVAL);
+	POMP_RETURN_ERR_IF_FAILED(data != NULL, -EINVAL);
+
+	/* Make sure header is complete */
+	if (len < POMP_PROT_HEADER_SIZE)
+		return -EAGAIN;
+
+	/* Check magic */
+	if (p[0] != POMP_PROT_HEADER_MAGIC_0
+			|| p[1] != POMP_PROT_HEADER_MAGIC_1
+			|| p[2] != POMP_PROT_HEADER_MAGIC_2
+			|| p[3] != POMP_PROT_HEADER_MAGIC_3) {
+		POMP_LOGW("Bad header magic");
+		return -EINVAL;
+	}
+
+	/* Check message size */
+	memcpy(&d, &p[8], sizeof(d));
+	d = POMP_LE32TOH(d);
+	if (d < POMP_PROT_HEADER_SIZE) {
+		POMP_LOGW("Bad header size : %d", d);
+		return -EINVAL;
+	}
+	if (d > len)
+		return -EAGAIN;
+
+	/* Message id */
+	if (msgid != NULL) {
+		memcpy(msgid, &p[4], sizeof(*msgid));
+		*msgid = POMP_LE32TOH(*msgid);
+	}
+
+	/* Decode directly from given data */
+	dec->msg = NULL;
+	dec->data = p;
+	dec->len = d;
+	dec->pos = POMP_PROT_HEADER_SIZE;
+	return (int)d;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_clear(struct pomp_decoder *dec)
+{
+	POMP_RETURN_ERR_IF_FAILED(dec != NULL, -EINVAL);
+	dec->msg = NULL;
+	dec->data = NULL;
+	dec->len = 0;
+	dec->pos = 0;
+	return 0;
+}
+
+/**
+ * Check the type of the next argument and skip it.
+ * @param dec : decoder.
+ * @param type : expected data type.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+static int decoder_read_type(struct pomp_decoder *dec, uint8_t type)
+{
+	if (dec->pos >= dec->len) {
+		POMP_LOGW("decoder : no more data");
+		return -EINVAL;
+	}
+	if (dec->data[dec->pos] != type) {
+		POMP_LOGW("decoder : type mismatch %d(%d)",
+				dec->data[dec->pos], type);
+		return -EINVAL;
+	}
+	dec->pos++;
+	return 0;
+}
+
+/**
+ * Get a pointer to raw data of the message and skip it.
+ * @param dec : decoder.
+ * @param p : will receive pointer to data.
+ * @param n : data size.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+static int decoder_cread(struct pomp_decoder *dec, const void **p, size_t n)
+{
+	if (n > dec->len - dec->pos) {
+		POMP_LOGW("decoder : truncated data");
+		return -EINVAL;
+	}
+	*p = dec->data + dec->pos;
+	dec->pos += n;
+	return 0;
+}
+
+/**
+ * Read data from message.
+ * @param dec : decoder.
+ * @param type : expected data type.
+ * @param p : data read.
+ * @param n : data size.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+static int decoder_read_data(struct pomp_decoder *dec, uint8_t type,
+		void *p, size_t n)
+{
+	int res = 0;
+	const void *src = NULL;
+
+	/* Read type */
+	res = decoder_read_type(dec, type);
+	if (res < 0)
+		return res;
+
+	/* Read data, only small scalar values are copied (no alignment) */
+	res = decoder_cread(dec, &src, n);
+	if (res < 0)
+		return res;
+	memcpy(p, src, n);
+	return 0;
+}
+
+/**
+ * Read an integer encoded as a variable number of bytes.
+ * @param dec : decoder.
+ * @param type : expected data type, 0 to just read raw data without type byte.
+ * @param v : value read.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+static int decoder_read_varint(struct pomp_decoder *dec, uint8_t type,
+		uint64_t *v)
+{
+	int res = 0;
+
+	/* Read type */
+	if (type != 0) {
+		res = decoder_read_type(dec, type);
+		if (res < 0)
+			return res;
+	}
+
+	/* Read value */
+	res = pomp_varint_decode(dec->data + dec->pos, dec->len - dec->pos, v);
+	if (res < 0) {
+		POMP_LOGW("decoder : invalid varint");
+		return res;
+	}
+	dec->pos += (size_t)res;
+	return 0;
+}
+
+/**
+ * Read size field as u32.
+ * @param dec : decoder.
+ * @param n : size read.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+static int decoder_read_size_u32(struct pomp_decoder *dec, uint32_t *n)
+{
+	int res = 0;
+	uint64_t d = 0;
+	res = decoder_read_varint(dec, 0, &d);
+	if (res < 0)
+		return res;
+	if (d > 0xffffffff) {
+		POMP_LOGW("decoder : invalid size");
+		return -EINVAL;
+	}
+	*n = (uint32_t)d;
+	return 0;
+}
+
+/**
+ * Check common decoder preconditions.
+ * _dec : decoder.
+ * _v : pointer to value to decode.
+ */
+#define DECODER_CHECK(_dec, _v) \
+	do { \
+		POMP_RETURN_ERR_IF_FAILED((_dec) != NULL, -EINVAL); \
+		POMP_RETURN_ERR_IF_FAILED((_dec)->data != NULL, -EINVAL); \
+		POMP_RETURN_ERR_IF_FAILED((_v) != NULL, -EINVAL); \
+	} while (0)
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_readv(struct pomp_decoder *dec, const char *fmt, va_list args)
+{
+	int res = 0;
+	int flags = 0;
+	char c = 0;
+	const void *cbuf = NULL;
+	uint32_t len = 0;
+
+	POMP_RETURN_ERR_IF_FAILED(dec != NULL, -EINVAL);
+
+	/* Allow NULL format string, simply return immediately */
+	if (fmt == NULL)
+		return 0;
+
+	while (res == 0 && *fmt != '\0') {
+		/* Only formatting spec expected here */
+		c = *fmt++;
+		if (c != '%') {
+			POMP_LOGW("decoder : invalid format char (%c)", c);
+			return -EINVAL;
+		}
+		flags = 0;
+
+again:
+		c = *fmt++;
+		switch (c) {
+		case 'l':
+			if (*fmt == 'l') {
+				fmt++;
+				flags |= FLAG_LL;
+			} else {
+				flags |= FLAG_L;
+			}
+			goto again;
+
+		case 'h':
+			if (*fmt == 'h') {
+				fmt++;
+				flags |= FLAG_HH;
+			} else {
+				flags |= FLAG_H;
+			}
+			goto again;
+
+		case 'm':
+			flags |= FLAG_M;
+			goto again;
+
+		/* Signed integer */
+		case 'i': /* NO BREAK */
+		case 'd':
+			if (flags & FLAG_LL) {
+				res = pomp_decoder_read_i64(dec,
+						va_arg(args, int64_t *));
+			} else if (flags & FLAG_L) {
+#if defined(__WORDSIZE) && (__WORDSIZE == 64)
+				res = pomp_decoder_read_i64(dec,
+						va_arg(args, int64_t *));
+#else
+				res = pomp_decoder_read_i32(dec,
+						va_arg(args, int32_t *));
+#endif
+			} else if (flags & FLAG_HH) {
+				res = pomp_decoder_read_i8(dec,
+						va_arg(args, int8_t *));
+			} else if (flags & FLAG_H) {
+				res = pomp_decoder_read_i16(dec,
+						va_arg(args, int16_t *));
+			} else {
+				res = pomp_decoder_read_i32(dec,
+						va_arg(args, int32_t *));
+			}
+			break;
+
+		/* Unsigned integer */
+		case 'u':
+			if (flags & FLAG_LL) {
+				res = pomp_decoder_read_u64(dec,
+						va_arg(args, uint64_t *));
+			} else if (flags & FLAG_L) {
+#if defined(__WORDSIZE) && (__WORDSIZE == 64)
+				res = pomp_decoder_read_u64(dec,
+						va_arg(args, uint64_t *));
+#else
+				res = pomp_decoder_read_u32(dec,
+						va_arg(args, uint32_t *));
+#endif
+			} else if (flags & FLAG_HH) {
+				res = pomp_decoder_read_u8(dec,
+						va_arg(args, uint8_t *));
+			} else if (flags & FLAG_H) {
+				res = pomp_decoder_read_u16(dec,
+						va_arg(args, uint16_t *));
+			} else {
+				res = pomp_decoder_read_u32(dec,
+						va_arg(args, uint32_t *));
+			}
+			break;
+
+		/* String, pointer inside decoded data */
+		case 's':
+			if (!(flags & FLAG_M)) {
+				POMP_LOGW("decoder : expected %%ms for strings");
+				res = -EINVAL;
+			} else {
+				res = pomp_decoder_read_cstr(dec,
+						va_arg(args, const char **));
+			}
+			break;
+
+		/* Buffer, pointer inside decoded data */
+		case 'p':
+			if (*fmt++ != '%' || *fmt++ != 'u') {
+				/* Size expected after pointer */
+				POMP_LOGW("decoder : expected %%u after %%p");
+				res = -EINVAL;
+			} else {
+				res = pomp_decoder_read_cbuf(dec, &cbuf, &len);
+				if (res == 0) {
+					*va_arg(args, const void **) = cbuf;
+					*va_arg(args, unsigned int *) = len;
+				}
+			}
+			break;
+
+		/* Floating point */
+		case 'f': /* NO BREAK */
+		case 'F': /* NO BREAK */
+		case 'e': /* NO BREAK */
+		case 'E': /* NO BREAK */
+		case 'g': /* NO BREAK */
+		case 'G':
+			if (flags & (FLAG_LL | FLAG_H | FLAG_HH)) {
+				POMP_LOGW("decoder : unsupported format width");
+				res = -EINVAL;
+			} else if (flags & FLAG_L) {
+				res = pomp_decoder_read_f64(dec,
+						va_arg(args, double *));
+			} else {
+				res = pomp_decoder_read_f32(dec,
+						va_arg(args, float *));
+			}
+			break;
+
+		default:
+			POMP_LOGW("decoder : invalid format specifier (%c)", c);
+			res = -EINVAL;
+			break;
+		}
+	}
+
+	return res;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read(struct pomp_decoder *dec, const char *fmt, ...)
+{
+	int res = 0;
+	va_list args;
+	va_start(args, fmt);
+	res = pomp_decoder_readv(dec, fmt, args);
+	va_end(args);
+	return res;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_i8(struct pomp_decoder *dec, int8_t *v)
+{
+	uint8_t d = 0;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_data(dec, POMP_PROT_DATA_TYPE_I8, &d, sizeof(d));
+	if (res == 0)
+		*v = (int8_t)d;
+	return res;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_u8(struct pomp_decoder *dec, uint8_t *v)
+{
+	DECODER_CHECK(dec, v);
+	return decoder_read_data(dec, POMP_PROT_DATA_TYPE_U8, v, sizeof(*v));
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_i16(struct pomp_decoder *dec, int16_t *v)
+{
+	uint16_t d = 0;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_data(dec, POMP_PROT_DATA_TYPE_I16, &d, sizeof(d));
+	if (res == 0)
+		*v = (int16_t)POMP_LE16TOH(d);
+	return res;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_u16(struct pomp_decoder *dec, uint16_t *v)
+{
+	uint16_t d = 0;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_data(dec, POMP_PROT_DATA_TYPE_U16, &d, sizeof(d));
+	if (res == 0)
+		*v = POMP_LE16TOH(d);
+	return res;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_i32(struct pomp_decoder *dec, int32_t *v)
+{
+	uint64_t d = 0;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_varint(dec, POMP_PROT_DATA_TYPE_I32, &d);
+	if (res < 0)
+		return res;
+	if (d > 0xffffffff) {
+		POMP_LOGW("decoder : i32 out of range");
+		return -EINVAL;
+	}
+	/* Zigzag decoding */
+	*v = (int32_t)((uint32_t)(d >> 1) ^ (-(uint32_t)(d & 1)));
+	return 0;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_u32(struct pomp_decoder *dec, uint32_t *v)
+{
+	uint64_t d = 0;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_varint(dec, POMP_PROT_DATA_TYPE_U32, &d);
+	if (res < 0)
+		return res;
+	if (d > 0xffffffff) {
+		POMP_LOGW("decoder : u32 out of range");
+		return -EINVAL;
+	}
+	*v = (uint32_t)d;
+	return 0;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_i64(struct pomp_decoder *dec, int64_t *v)
+{
+	uint64_t d = 0;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_varint(dec, POMP_PROT_DATA_TYPE_I64, &d);
+	if (res < 0)
+		return res;
+	/* Zigzag decoding */
+	*v = (int64_t)((d >> 1) ^ (-(d & 1)));
+	return 0;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_u64(struct pomp_decoder *dec, uint64_t *v)
+{
+	DECODER_CHECK(dec, v);
+	return decoder_read_varint(dec, POMP_PROT_DATA_TYPE_U64, v);
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_cstr(struct pomp_decoder *dec, const char **v)
+{
+	int res = 0;
+	uint64_t len = 0;
+	const void *p = NULL;
+
+	DECODER_CHECK(dec, v);
+
+	/* Read type */
+	res = decoder_read_type(dec, POMP_PROT_DATA_TYPE_STR);
+	if (res < 0)
+		return res;
+
+	/* Read string length, it includes the null byte */
+	res = decoder_read_varint(dec, 0, &len);
+	if (res < 0)
+		return res;
+	if (len == 0 || len > 0xffff) {
+		POMP_LOGW("decoder : invalid string length %u", (uint32_t)len);
+		return -EINVAL;
+	}
+
+	/* Point to string data, make sure it is null terminated */
+	res = decoder_cread(dec, &p, (size_t)len);
+	if (res < 0)
+		return res;
+	if (((const char *)p)[len - 1] != '\0') {
+		POMP_LOGW("decoder : string not null terminated");
+		return -EINVAL;
+	}
+	*v = p;
+	return 0;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_cbuf(struct pomp_decoder *dec, const void **v,
+		uint32_t *n)
+{
+	int res = 0;
+
+	DECODER_CHECK(dec, v);
+	POMP_RETURN_ERR_IF_FAILED(n != NULL, -EINVAL);
+
+	/* Read type */
+	res = decoder_read_type(dec, POMP_PROT_DATA_TYPE_BUF);
+	if (res < 0)
+		return res;
+
+	/* Read length */
+	res = decoder_read_size_u32(dec, n);
+	if (res < 0)
+		return res;
+
+	/* Point to buffer data */
+	return decoder_cread(dec, v, *n);
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_f32(struct pomp_decoder *dec, float *v)
+{
+	union {
+		float f32;
+		uint32_t u32;
+	} d;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_data(dec, POMP_PROT_DATA_TYPE_F32, &d, sizeof(d));
+	if (res < 0)
+		return res;
+	d.u32 = POMP_LE32TOH(d.u32);
+	*v = d.f32;
+	return 0;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_decoder_read_f64(struct pomp_decoder *dec, double *v)
+{
+	union {
+		double f64;
+		uint64_t u64;
+	} d;
+	int res = 0;
+	DECODER_CHECK(dec, v);
+	res = decoder_read_data(dec, POMP_PROT_DATA_TYPE_F64, &d, sizeof(d));
+	if (res < 0)
+		return res;
+	d.u64 = POMP_LE64TOH(d.u64);
+	*v = d.f64;
+	return 0;
+}
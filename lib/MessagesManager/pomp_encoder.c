@@ -121,20 +121,8 @@ static int encoder_write_data(struct pomp_encoder *enc, uint8_t type,
 static int encoder_write_varint(struct pomp_encoder *enc, uint8_t type,
 		uint64_t v)
 {
-	uint8_t d[10];
-	uint32_t n = 0;
-	uint8_t b = 0;
-	int more = 0;
-
-	/* Process value, use logical right shift without sign propagation */
-	do {
-		b = v & 0x7f;
-		v >>= 7;
-		more = (v != 0);
-		if (more)
-			b |= 0x80;
-		d[n++] = b;
-	} while (more);
+	uint8_t d[POMP_VARINT_MAX_SIZE_64];
+	uint32_t n = pomp_varint_encode(d, v);
 
 	/* Write encoded data */
 	if (type != 0)
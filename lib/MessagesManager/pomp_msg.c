@@ -173,6 +173,30 @@ int pomp_msg_init(struct pomp_msg *msg, uint32_t msgid)
 	return 0;
 }
 
+/**
+ * Initialize a message object, keeping its current buffer if it is not
+ * shared. This avoids a buffer allocation when a message object is reused.
+ * @param msg : message.
+ * @param msgid : message id.
+ * @return 0 in case of success, negative errno value in case of error.
+ */
+int pomp_msg_reinit(struct pomp_msg *msg, uint32_t msgid)
+{
+	POMP_RETURN_ERR_IF_FAILED(msg != NULL, -EINVAL);
+
+	/* Buffer can not be reused, start from a new one */
+	if (msg->buf == NULL || msg->buf->refcount > 1
+			|| msg->buf->fdcount != 0) {
+		(void)pomp_msg_clear(msg);
+		return pomp_msg_init(msg, msgid);
+	}
+
+	msg->msgid = msgid;
+	msg->finished = 0;
+	msg->buf->len = 0;
+	return 0;
+}
+
 /*
  * See documentation in public header.
  */
@@ -342,34 +366,34 @@ out:
 /*
  * See documentation in public header.
  */
-// int pomp_msg_read(const struct pomp_msg *msg, const char *fmt, ...)
-// {
-// 	int res = 0;
-// 	va_list args;
-// 	va_start(args, fmt);
-// 	res = pomp_msg_readv(msg, fmt, args);
-// 	va_end(args);
-// 	return res;
-// }
+int pomp_msg_read(const struct pomp_msg *msg, const char *fmt, ...)
+{
+	int res = 0;
+	va_list args;
+	va_start(args, fmt);
+	res = pomp_msg_readv(msg, fmt, args);
+	va_end(args);
+	return res;
+}
 
 /*
  * See documentation in public header.
  */
-// int pomp_msg_readv(const struct pomp_msg *msg, const char *fmt, va_list args)
-// {
-// 	int res = 0;
-// 	struct pomp_decoder dec = POMP_DECODER_INITIALIZER;
-//
-// 	POMP_RETURN_ERR_IF_FAILED(msg != NULL, -EINVAL);
-//
-// 	res = pomp_decoder_init(&dec, msg);
-// 	if (res == 0)
-// 		res = pomp_decoder_readv(&dec, fmt, args);
-//
-// 	/* Always clear decoder, even in case of error during decoding */
-// 	(void)pomp_decoder_clear(&dec);
-// 	return res;
-// }
+int pomp_msg_readv(const struct pomp_msg *msg, const char *fmt, va_list args)
+{
+	int res = 0;
+	struct pomp_decoder dec = POMP_DECODER_INITIALIZER;
+
+	POMP_RETURN_ERR_IF_FAILED(msg != NULL, -EINVAL);
+
+	res = pomp_decoder_init(&dec, msg);
+	if (res == 0)
+		res = pomp_decoder_readv(&dec, fmt, args);
+
+	/* Always clear decoder, even in case of error during decoding */
+	(void)pomp_decoder_clear(&dec);
+	return res;
+}
 
 /*
  * See documentation in public header.
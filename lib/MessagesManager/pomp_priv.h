@@ -35,7 +35,10 @@
 #ifndef _POMP_PRIV_H_
 #define _POMP_PRIV_H_
 
-#define _GNU_SOURCE
+/* Already set by g++, pomp_priv.h is also included from C++ */
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
 
 /* Generic headers */
 #include <stdlib.h>
@@ -115,6 +118,26 @@
 // #  define POMP_TIMER_POSIX_SIGNO	SIGRTMIN
 // #endif /* POMP_TIMER_POSIX_SIGNO */
 
+/* Atomic operations. The esp8266 toolchain does not provide the __sync
+ * builtins and only runs a single thread, plain operations are enough there */
+#if defined(ARDUINO_ARCH_ESP8266)
+#  define POMP_ATOMIC_ADD_FETCH(_p, _v)	(*(_p) += (_v))
+#  define POMP_ATOMIC_SUB_FETCH(_p, _v)	(*(_p) -= (_v))
+#  define POMP_ATOMIC_CAS(_p, _old, _new) \
+	((*(_p) == (_old)) ? (*(_p) = (_new), 1) : 0)
+#  define POMP_ATOMIC_XCHG(_p, _v) \
+	__extension__ ({ __typeof__(*(_p)) _o = *(_p); *(_p) = (_v); _o; })
+#elif defined(__GNUC__)
+#  define POMP_ATOMIC_ADD_FETCH(_p, _v)	__sync_add_and_fetch((_p), (_v))
+#  define POMP_ATOMIC_SUB_FETCH(_p, _v)	__sync_sub_and_fetch((_p), (_v))
+#  define POMP_ATOMIC_CAS(_p, _old, _new) \
+	__sync_bool_compare_and_swap((_p), (_old), (_new))
+#  define POMP_ATOMIC_XCHG(_p, _v) \
+	__sync_lock_test_and_set((_p), (_v))
+#else
+#  error No atomic functions found on this platform
+#endif
+
 /** Enable advance API */
 #define POMP_ENABLE_ADVANCED_API
 
@@ -122,6 +145,7 @@
 
 #include "pomp_log.h"
 #include "pomp_buffer.h"
+#include "pomp_varint.h"
 // #include "pomp_timer.h"
 // #include "pomp_loop.h"
 #include "pomp_prot.h"
@@ -131,19 +155,20 @@ extern "C" {
 #endif /* __cplusplus */
 
 /** Message structure initializer */
-#define POMP_MSG_INITIALIZER		{0, 0, NULL}
+#define POMP_MSG_INITIALIZER		{0, 0, NULL, NULL}
 
 /** Encoder structure initializer*/
 #define POMP_ENCODER_INITIALIZER	{NULL, 0}
 
 /** Decoder structure initializer*/
-#define POMP_DECODER_INITIALIZER	{NULL, 0}
+#define POMP_DECODER_INITIALIZER	{NULL, NULL, 0, 0}
 
 /** Message data */
 struct pomp_msg {
 	uint32_t		msgid;		/**< Id of message */
 	uint32_t		finished;	/**< Header is filled */
 	struct pomp_buffer	*buf;		/**< Buffer with data */
+	struct pomp_msg		*next;		/**< Next message in a free list */
 };
 
 /** Encode state */
@@ -152,11 +177,13 @@ struct pomp_encoder {
 	size_t			pos;		/**< Position in data */
 };
 
-// /** Decoder state */
-// struct pomp_decoder {
-// 	const struct pomp_msg	*msg;		/**< Associated message */
-// 	size_t			pos;		/**< Position in data */
-// };
+/** Decoder state */
+struct pomp_decoder {
+	const struct pomp_msg	*msg;		/**< Associated message */
+	const uint8_t		*data;		/**< Data being decoded (not owned) */
+	size_t			len;		/**< Size of data */
+	size_t			pos;		/**< Position in data */
+};
 
 /** Value union */
 union pomp_value {
@@ -190,6 +217,10 @@ union pomp_value {
 // int pomp_ctx_notify_raw_buf(struct pomp_ctx *ctx, struct pomp_conn *conn,
 // 		struct pomp_buffer *buf);
 
+/* Message functions not part of public API */
+
+int pomp_msg_reinit(struct pomp_msg *msg, uint32_t msgid);
+
 /* Connection functions not part of public API */
 
 // struct pomp_conn *pomp_conn_new(struct pomp_ctx *ctx,
@@ -66,6 +66,14 @@ struct pomp_prot {
 	size_t			offpayload;
 	/** Associated message */
 	struct pomp_msg		*msg;
+	/** Idle messages, only used by the decoding thread */
+	struct pomp_msg		*freemsgs;
+	/** Messages released from any thread, taken back in bulk */
+	struct pomp_msg		*releasedmsgs;
+	/** Number of idle messages held in both lists */
+	uint32_t		idlecount;
+	/** Maximum number of idle messages held */
+	uint32_t		poolsize;
 };
 
 /**
@@ -81,6 +89,69 @@ static void pomp_prot_reset_state(struct pomp_prot *prot)
 	prot->offpayload = 0;
 }
 
+/**
+ * Take an idle message from the pool.
+ * @param prot : protocol decoder.
+ * @return idle message or NULL if the pool is empty.
+ */
+static struct pomp_msg *pomp_prot_pool_get(struct pomp_prot *prot)
+{
+	struct pomp_msg *msg = NULL;
+
+	/* Refill from messages released by other threads, the whole list is
+	 * taken at once so there is no ABA problem */
+	if (prot->freemsgs == NULL)
+		prot->freemsgs = POMP_ATOMIC_XCHG(&prot->releasedmsgs, NULL);
+
+	msg = prot->freemsgs;
+	if (msg != NULL) {
+		prot->freemsgs = msg->next;
+		msg->next = NULL;
+		(void)POMP_ATOMIC_SUB_FETCH(&prot->idlecount, 1);
+	}
+	return msg;
+}
+
+/**
+ * Give a message back to the pool. It can be called from any thread.
+ * @param prot : protocol decoder.
+ * @param msg : message to release.
+ * @return 1 if the message was kept, 0 if the pool is full.
+ */
+static int pomp_prot_pool_put(struct pomp_prot *prot, struct pomp_msg *msg)
+{
+	struct pomp_msg *head = NULL;
+
+	if (POMP_ATOMIC_ADD_FETCH(&prot->idlecount, 1) > prot->poolsize) {
+		(void)POMP_ATOMIC_SUB_FETCH(&prot->idlecount, 1);
+		return 0;
+	}
+
+	/* Keep buffer for next message unless someone else still uses it */
+	if (msg->buf != NULL && msg->buf->refcount > 1)
+		(void)pomp_msg_clear(msg);
+
+	do {
+		head = prot->releasedmsgs;
+		msg->next = head;
+	} while (!POMP_ATOMIC_CAS(&prot->releasedmsgs, head, msg));
+	return 1;
+}
+
+/**
+ * Destroy all messages of a list.
+ * @param msg : first message of the list.
+ */
+static void pomp_prot_pool_destroy_list(struct pomp_msg *msg)
+{
+	struct pomp_msg *next = NULL;
+	while (msg != NULL) {
+		next = msg->next;
+		pomp_msg_destroy(msg);
+		msg = next;
+	}
+}
+
 /**
  * Make sure the internal message object is properly allocated.
  * @param prot : protocol decoder.
@@ -93,14 +164,17 @@ static int pomp_prot_alloc_msg(struct pomp_prot *prot, uint32_t msgid,
 {
 	int res = 0;
 
-	/* Allocate new message if needed */
+	/* Take message from the pool, allocate new message if needed */
+	if (prot->msg == NULL)
+		prot->msg = pomp_prot_pool_get(prot);
 	if (prot->msg == NULL)
 		prot->msg = pomp_msg_new();
 	if (prot->msg == NULL)
 		return -ENOMEM;
 
-	/* Initialize message, setup buffer inside message */
-	res = pomp_msg_init(prot->msg, msgid);
+	/* Initialize message, setup buffer inside message (the buffer of a
+	 * pooled message is reused) */
+	res = pomp_msg_reinit(prot->msg, msgid);
 	if (res < 0)
 		return res;
 	return pomp_buffer_ensure_capacity(prot->msg->buf, size);
@@ -253,11 +327,65 @@ struct pomp_prot *pomp_prot_new(void)
 	if (prot == NULL)
 		return NULL;
 
-	/* Reset internal state */
+	/* Reset internal state, by default keep a single message for reuse */
 	pomp_prot_reset_state(prot);
+	prot->poolsize = 1;
 	return prot;
 }
 
+/**
+ * Setup the pool of messages used by the decoder. Messages given back with
+ * 'pomp_prot_release_msg' are kept for reuse (with their buffer) up to the
+ * size of the pool, so consumers holding several messages at once do not
+ * need a malloc/free per message.
+ * @param prot : protocol decoder.
+ * @param count : maximum number of idle messages kept.
+ * @param capacity : capacity of buffers allocated in advance for the pool.
+ * 0 to not allocate anything in advance.
+ * @return 0 in case of success, negative errno value in case of error.
+ *
+ * @remarks : 'pomp_prot_release_msg' can be called from any thread, other
+ * functions shall be called from the decoding thread. Each decoding thread
+ * owns its own decoder and hence its own pool.
+ */
+int pomp_prot_set_pool(struct pomp_prot *prot, uint32_t count, size_t capacity)
+{
+	struct pomp_msg *msg = NULL;
+	uint32_t i = 0;
+
+	POMP_RETURN_ERR_IF_FAILED(prot != NULL, -EINVAL);
+	POMP_RETURN_ERR_IF_FAILED(count != 0, -EINVAL);
+
+	/* Drop idle messages above new size */
+	prot->poolsize = count;
+	while (prot->idlecount > count) {
+		msg = pomp_prot_pool_get(prot);
+		if (msg == NULL)
+			break;
+		pomp_msg_destroy(msg);
+	}
+	if (capacity == 0)
+		return 0;
+
+	/* Pre-allocate messages and buffers */
+	for (i = prot->idlecount; i < count; i++) {
+		msg = pomp_msg_new();
+		if (msg == NULL)
+			return -ENOMEM;
+		if (pomp_msg_init(msg, 0) < 0
+				|| pomp_buffer_ensure_capacity(msg->buf,
+						capacity) < 0) {
+			pomp_msg_destroy(msg);
+			return -ENOMEM;
+		}
+		if (!pomp_prot_pool_put(prot, msg)) {
+			pomp_msg_destroy(msg);
+			break;
+		}
+	}
+	return 0;
+}
+
 /**
  * Destroy a protocol decoder object.
  * @param prot : protocol decoder.
@@ -268,6 +396,8 @@ int pomp_prot_destroy(struct pomp_prot *prot)
 	POMP_RETURN_ERR_IF_FAILED(prot != NULL, -EINVAL);
 	if (prot->msg != NULL)
 		pomp_msg_destroy(prot->msg);
+	pomp_prot_pool_destroy_list(prot->freemsgs);
+	pomp_prot_pool_destroy_list(prot->releasedmsgs);
 	pomp_prot_reset_state(prot);
 	free(prot);
 	return 0;
@@ -360,24 +490,21 @@ ssize_t pomp_prot_decode_msg(struct pomp_prot *prot, const void *buf,
 
 /**
  * Release a previously decoded message. This is to reuse message structure
- * if possible and avoid some malloc/free at each decoded message. If there
- * is already a internal message structure, it is simply destroyed.
+ * if possible and avoid some malloc/free at each decoded message. If the pool
+ * of messages is already full, it is simply destroyed.
  * @param prot : protocol decoder.
  * @param msg : message to release.
  * @return 0 in case of success, negative errno value in case of error.
+ *
+ * @remarks : it can be called from any thread.
  */
 int pomp_prot_release_msg(struct pomp_prot *prot, struct pomp_msg *msg)
 {
 	POMP_RETURN_ERR_IF_FAILED(prot != NULL, -EINVAL);
 	POMP_RETURN_ERR_IF_FAILED(msg != NULL, -EINVAL);
 
-	/* if we already have one, destroy given one, otherwise get ownership
-	 * but clear it */
-	if (prot->msg != NULL) {
+	/* Keep it in the pool if there is room, destroy it otherwise */
+	if (!pomp_prot_pool_put(prot, msg))
 		pomp_msg_destroy(msg);
-	} else {
-		prot->msg = msg;
-		pomp_msg_clear(prot->msg);
-	}
 	return 0;
 }
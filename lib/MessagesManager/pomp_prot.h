@@ -129,6 +129,9 @@ struct pomp_prot *pomp_prot_new(void);
 
 int pomp_prot_destroy(struct pomp_prot *prot);
 
+int pomp_prot_set_pool(struct pomp_prot *prot, uint32_t count,
+		size_t capacity);
+
 ssize_t pomp_prot_decode_msg(struct pomp_prot *prot, const void *buf,
 		size_t len, struct pomp_msg **msg);
 
@@ -0,0 +1,317 @@
+/**
+ * @file pomp_varint.c
+ *
+ * @brief Batch variable length integer encoding.
+ *
+ * Arrays of samples are encoded back to back with the same format as the one
+ * used for the integer arguments of a message (see pomp_varint.h), without
+ * any type byte. Ground builds use SSE4.1/AVX2 for the common cases (runs of
+ * small values), other builds (and the device) use the scalar helpers.
+ *
+ * Copyright (c) 2014 Parrot S.A.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "pomp_priv.h"
+
+#if defined(__SSE4_1__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/** Number of values handled at once when zigzag encoding through a buffer */
+#define VARINT_ZIGZAG_CHUNK	64
+
+/**
+ * Zigzag encode a signed value.
+ * @param v : value to encode.
+ * @return encoded value.
+ */
+static inline uint32_t zigzag_encode(int32_t v)
+{
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+/**
+ * Zigzag decode a value.
+ * @param v : value to decode.
+ * @return decoded value.
+ */
+static inline int32_t zigzag_decode(uint32_t v)
+{
+	return (int32_t)((v >> 1) ^ (0u - (v & 1)));
+}
+
+#if defined(__SSE4_1__)
+
+/**
+ * Encode blocks of 16 values all lower than 128, one byte each.
+ * @param src : values to encode.
+ * @param count : number of values.
+ * @param dst : destination.
+ * @param n : number of bytes written, updated.
+ * @return number of values encoded.
+ */
+static size_t varint_encode_blocks(const uint32_t *src, size_t count,
+		uint8_t *dst, size_t *n)
+{
+	size_t i = 0;
+	const __m128i hi = _mm_set1_epi32(~0x7f);
+	__m128i a, b, c, d;
+
+	while (i + 16 <= count) {
+		a = _mm_loadu_si128((const __m128i *)(src + i));
+		b = _mm_loadu_si128((const __m128i *)(src + i + 4));
+		c = _mm_loadu_si128((const __m128i *)(src + i + 8));
+		d = _mm_loadu_si128((const __m128i *)(src + i + 12));
+		if (!_mm_testz_si128(_mm_or_si128(_mm_or_si128(a, b),
+				_mm_or_si128(c, d)), hi))
+			break;
+		a = _mm_packus_epi32(a, b);
+		c = _mm_packus_epi32(c, d);
+		_mm_storeu_si128((__m128i *)(dst + *n), _mm_packus_epi16(a, c));
+		*n += 16;
+		i += 16;
+	}
+	return i;
+}
+
+/**
+ * Decode blocks of 16 one byte values or 8 two bytes values.
+ * @param src : source.
+ * @param len : size of source.
+ * @param pos : position in source, updated.
+ * @param dst : decoded values.
+ * @param count : number of values to decode.
+ * @return number of values decoded.
+ */
+static size_t varint_decode_blocks(const uint8_t *src, size_t len,
+		size_t *pos, uint32_t *dst, size_t count)
+{
+	size_t i = 0;
+	int mask = 0;
+	const __m128i lo7 = _mm_set1_epi16(0x7f);
+	__m128i x, v;
+
+	while (*pos + 16 <= len && i + 8 <= count) {
+		x = _mm_loadu_si128((const __m128i *)(src + *pos));
+		mask = _mm_movemask_epi8(x);
+		if (mask == 0 && i + 16 <= count) {
+			/* 16 values of 1 byte */
+			_mm_storeu_si128((__m128i *)(dst + i),
+					_mm_cvtepu8_epi32(x));
+			_mm_storeu_si128((__m128i *)(dst + i + 4),
+					_mm_cvtepu8_epi32(_mm_srli_si128(x, 4)));
+			_mm_storeu_si128((__m128i *)(dst + i + 8),
+					_mm_cvtepu8_epi32(_mm_srli_si128(x, 8)));
+			_mm_storeu_si128((__m128i *)(dst + i + 12),
+					_mm_cvtepu8_epi32(_mm_srli_si128(x, 12)));
+			*pos += 16;
+			i += 16;
+		} else if (mask == 0x5555) {
+			/* 8 values of 2 bytes */
+			v = _mm_or_si128(_mm_and_si128(x, lo7),
+					_mm_slli_epi16(_mm_srli_epi16(x, 8), 7));
+			_mm_storeu_si128((__m128i *)(dst + i),
+					_mm_cvtepu16_epi32(v));
+			_mm_storeu_si128((__m128i *)(dst + i + 4),
+					_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+			*pos += 16;
+			i += 8;
+		} else {
+			break;
+		}
+	}
+	return i;
+}
+
+#endif /* __SSE4_1__ */
+
+/*
+ * See documentation in public header.
+ */
+size_t pomp_varint_encode_u32_array(const uint32_t *src, size_t count,
+		void *dst)
+{
+	size_t i = 0, n = 0, end = count;
+	uint8_t *d = dst;
+
+	if (src == NULL || dst == NULL)
+		return 0;
+
+	while (i < count) {
+#if defined(__SSE4_1__)
+		i += varint_encode_blocks(src + i, count - i, d, &n);
+		if (i >= count)
+			break;
+		/* At least one large value in next block, encode the block one
+		 * value at a time rather than testing it again for each value */
+		end = i + 16 < count ? i + 16 : count;
+#endif /* __SSE4_1__ */
+		while (i < end)
+			n += pomp_varint_encode(d + n, src[i++]);
+	}
+	return n;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_varint_decode_u32_array(const void *src, size_t len,
+		uint32_t *dst, size_t count)
+{
+	int res = 0;
+	size_t i = 0, pos = 0, end = 0;
+	uint64_t v = 0;
+	const uint8_t *s = src;
+
+	POMP_RETURN_ERR_IF_FAILED(src != NULL || len == 0, -EINVAL);
+	POMP_RETURN_ERR_IF_FAILED(dst != NULL || count == 0, -EINVAL);
+	POMP_RETURN_ERR_IF_FAILED(len <= INT32_MAX, -EINVAL);
+
+	while (i < count) {
+#if defined(__SSE4_1__)
+		i += varint_decode_blocks(s, len, &pos, dst + i, count - i);
+		if (i >= count)
+			break;
+		/* Next 16 bytes are not a block, decode them one value at a
+		 * time rather than testing them again for each value */
+		end = pos + 16;
+#else
+		end = len;
+#endif /* __SSE4_1__ */
+		do {
+			res = pomp_varint_decode(s + pos, len - pos, &v);
+			if (res < 0 || v > 0xffffffff)
+				return -EINVAL;
+			dst[i++] = (uint32_t)v;
+			pos += (size_t)res;
+		} while (i < count && pos < end);
+	}
+	return (int)pos;
+}
+
+/*
+ * See documentation in public header.
+ */
+void pomp_varint_zigzag_encode_i32_array(const int32_t *src, uint32_t *dst,
+		size_t count)
+{
+	size_t i = 0;
+
+#if defined(__AVX2__)
+	__m256i v8;
+	for (; i + 8 <= count; i += 8) {
+		v8 = _mm256_loadu_si256((const __m256i *)(src + i));
+		v8 = _mm256_xor_si256(_mm256_slli_epi32(v8, 1),
+				_mm256_srai_epi32(v8, 31));
+		_mm256_storeu_si256((__m256i *)(dst + i), v8);
+	}
+#endif /* __AVX2__ */
+#if defined(__SSE4_1__)
+	__m128i v4;
+	for (; i + 4 <= count; i += 4) {
+		v4 = _mm_loadu_si128((const __m128i *)(src + i));
+		v4 = _mm_xor_si128(_mm_slli_epi32(v4, 1),
+				_mm_srai_epi32(v4, 31));
+		_mm_storeu_si128((__m128i *)(dst + i), v4);
+	}
+#endif /* __SSE4_1__ */
+	for (; i < count; i++)
+		dst[i] = zigzag_encode(src[i]);
+}
+
+/*
+ * See documentation in public header.
+ */
+void pomp_varint_zigzag_decode_i32_array(const uint32_t *src, int32_t *dst,
+		size_t count)
+{
+	size_t i = 0;
+
+#if defined(__AVX2__)
+	const __m256i one8 = _mm256_set1_epi32(1);
+	__m256i v8;
+	for (; i + 8 <= count; i += 8) {
+		v8 = _mm256_loadu_si256((const __m256i *)(src + i));
+		v8 = _mm256_xor_si256(_mm256_srli_epi32(v8, 1),
+				_mm256_sub_epi32(_mm256_setzero_si256(),
+				_mm256_and_si256(v8, one8)));
+		_mm256_storeu_si256((__m256i *)(dst + i), v8);
+	}
+#endif /* __AVX2__ */
+#if defined(__SSE4_1__)
+	const __m128i one4 = _mm_set1_epi32(1);
+	__m128i v4;
+	for (; i + 4 <= count; i += 4) {
+		v4 = _mm_loadu_si128((const __m128i *)(src + i));
+		v4 = _mm_xor_si128(_mm_srli_epi32(v4, 1),
+				_mm_sub_epi32(_mm_setzero_si128(),
+				_mm_and_si128(v4, one4)));
+		_mm_storeu_si128((__m128i *)(dst + i), v4);
+	}
+#endif /* __SSE4_1__ */
+	for (; i < count; i++)
+		dst[i] = zigzag_decode(src[i]);
+}
+
+/*
+ * See documentation in public header.
+ */
+size_t pomp_varint_encode_i32_array(const int32_t *src, size_t count,
+		void *dst)
+{
+	size_t i = 0, n = 0, chunk = 0;
+	uint32_t tmp[VARINT_ZIGZAG_CHUNK];
+
+	if (src == NULL || dst == NULL)
+		return 0;
+
+	/* Zigzag through a small buffer to keep the source untouched */
+	for (i = 0; i < count; i += chunk) {
+		chunk = count - i;
+		if (chunk > VARINT_ZIGZAG_CHUNK)
+			chunk = VARINT_ZIGZAG_CHUNK;
+		pomp_varint_zigzag_encode_i32_array(src + i, tmp, chunk);
+		n += pomp_varint_encode_u32_array(tmp, chunk, (uint8_t *)dst + n);
+	}
+	return n;
+}
+
+/*
+ * See documentation in public header.
+ */
+int pomp_varint_decode_i32_array(const void *src, size_t len,
+		int32_t *dst, size_t count)
+{
+	int res = 0;
+
+	/* Decode in place, then undo zigzag */
+	res = pomp_varint_decode_u32_array(src, len, (uint32_t *)dst, count);
+	if (res < 0)
+		return res;
+	pomp_varint_zigzag_decode_i32_array((const uint32_t *)dst, dst, count);
+	return res;
+}
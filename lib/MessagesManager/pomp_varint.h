@@ -0,0 +1,87 @@
+/**
+ * @file pomp_varint.h
+ *
+ * @brief Variable length integer encoding helpers.
+ *
+ * Integers are written 7 bits at a time, least significant group first, the
+ * most significant bit of each byte being set when more bytes follow. Signed
+ * integers are first zigzag encoded so that small negative values stay short.
+ *
+ * Copyright (c) 2014 Parrot S.A.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _POMP_VARINT_H_
+#define _POMP_VARINT_H_
+
+/** Maximum encoded size of a 64-bit integer */
+#define POMP_VARINT_MAX_SIZE_64		10
+
+/**
+ * Encode an integer as a variable number of bytes.
+ * @param d : destination, shall have room for POMP_VARINT_MAX_SIZE_64 bytes.
+ * @param v : value to encode.
+ * @return number of bytes written.
+ */
+static inline uint32_t pomp_varint_encode(uint8_t *d, uint64_t v)
+{
+	uint32_t n = 0;
+
+	/* Use logical right shift without sign propagation */
+	while (v >= 0x80) {
+		d[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	d[n++] = (uint8_t)v;
+	return n;
+}
+
+/**
+ * Decode an integer encoded as a variable number of bytes.
+ * @param p : source.
+ * @param len : size of source.
+ * @param v : decoded value.
+ * @return number of bytes read, -EINVAL if the source is truncated or the
+ * value is longer than POMP_VARINT_MAX_SIZE_64 bytes.
+ */
+static inline int pomp_varint_decode(const uint8_t *p, size_t len, uint64_t *v)
+{
+	uint32_t n = 0;
+	uint32_t shift = 0;
+	uint8_t b = 0;
+
+	*v = 0;
+	do {
+		if (n >= len || n >= POMP_VARINT_MAX_SIZE_64)
+			return -EINVAL;
+		b = p[n++];
+		*v |= ((uint64_t)(b & 0x7f)) << shift;
+		shift += 7;
+	} while (b & 0x80);
+	return (int)n;
+}
+
+#endif /* !_POMP_VARINT_H_ */
@@ -0,0 +1,86 @@
+#include <MotionPolicy.h>
+#include <math.h>
+
+static const float MM_PER_UNIT = 11.1319f; // [mm] per 1e-7 deg of latitude
+
+MotionPolicy::MotionPolicy(){
+  _speedThreshold = 500;
+  _distanceThreshold = 5000;
+  _stillDelay = 3000000;
+  _keepalive = 10000000;
+  _hasAnchor = false;
+  _anchorLat = 0;
+  _anchorLon = 0;
+  _anchorAlt = 0;
+  _lastMotion = 0;
+  _lastSent = 0;
+  _stationary = false;
+  _skipped = 0;
+}
+
+void MotionPolicy::setSpeedThreshold(float speed)
+{
+  _speedThreshold = speed;
+}
+
+void MotionPolicy::setDistanceThreshold(float distance)
+{
+  _distanceThreshold = distance;
+}
+
+void MotionPolicy::setStillDelay(uint32_t delay)
+{
+  _stillDelay = (uint64_t)delay * 1000;
+}
+
+void MotionPolicy::setKeepalive(uint32_t period)
+{
+  _keepalive = (uint64_t)period * 1000;
+}
+
+bool MotionPolicy::shouldSend(const GPSData_t& data)
+{
+  if (!_hasAnchor || isMoving(data)) {
+    _hasAnchor = true;
+    _anchorLat = data.latitude;
+    _anchorLon = data.longitude;
+    _anchorAlt = data.altitude;
+    _lastMotion = data.time;
+  }
+  // The clock steps forward when it syncs to GPS time : only shortens the delay
+  _stationary = data.time - _lastMotion >= _stillDelay;
+  if (_stationary && data.time - _lastSent < _keepalive) {
+    _skipped++;
+    return false;
+  }
+  _lastSent = data.time;
+  return true;
+}
+
+bool MotionPolicy::isStationary()
+{
+  return _stationary;
+}
+
+uint32_t MotionPolicy::getSkipped()
+{
+  return _skipped;
+}
+
+bool MotionPolicy::isMoving(const GPSData_t& data)
+{
+  float speed = sqrtf(data.northSpeed * data.northSpeed
+    + data.eastSpeed * data.eastSpeed
+    + data.downSpeed * data.downSpeed);
+  if (speed > _speedThreshold + data.speedAcc) {
+    return true;
+  }
+
+  // Slow creep : distance to the anchor, which stays where the tracker stopped
+  float y = (data.latitude - _anchorLat) * MM_PER_UNIT;
+  float x = (data.longitude - _anchorLon) * MM_PER_UNIT * cosf(data.latitude * 1e-7f * (float)M_PI / 180);
+  if (sqrtf(x * x + y * y) > _distanceThreshold + data.horizontalAcc) {
+    return true;
+  }
+  return fabsf(data.altitude - _anchorAlt) > _distanceThreshold + data.verticalAcc;
+}
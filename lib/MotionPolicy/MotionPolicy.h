@@ -0,0 +1,38 @@
+#ifndef MotionPolicy_h
+#define MotionPolicy_h
+
+#include <stdint.h>
+#include <Types.h>
+
+/* Decides which fixes are worth sending. Moving, every fix goes. Once still
+ * for a while, only a keepalive fix goes now and then. A fix is moving when
+ * its speed, or its distance to where the tracker stopped, is beyond noise :
+ * the threshold plus the accuracy the receiver reports. The first moving fix
+ * goes at once. */
+class MotionPolicy {
+public:
+  MotionPolicy();
+  void setSpeedThreshold(float speed); /* [mm/s] */
+  void setDistanceThreshold(float distance); /* [mm] horizontal or vertical */
+  void setStillDelay(uint32_t delay); /* [ms] full rate kept that long after the last motion */
+  void setKeepalive(uint32_t period); /* [ms] still, one fix that often */
+  bool shouldSend(const GPSData_t& data);
+  bool isStationary();
+  uint32_t getSkipped();
+private:
+  float _speedThreshold;
+  float _distanceThreshold;
+  uint64_t _stillDelay;   /* [us] */
+  uint64_t _keepalive;    /* [us] */
+  bool _hasAnchor;
+  double _anchorLat;      /* [deg 1e-7] last moving fix */
+  double _anchorLon;
+  float _anchorAlt;       /* [mm] */
+  uint64_t _lastMotion;   /* [us] data.time */
+  uint64_t _lastSent;
+  bool _stationary;
+  uint32_t _skipped;
+  bool isMoving(const GPSData_t& data);
+};
+
+#endif
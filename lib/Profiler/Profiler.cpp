@@ -0,0 +1,95 @@
+#include <Profiler.h>
+#include <string.h>
+
+Profiler profiler;
+
+static const char* const PROFILE_NAMES[PROFILE_SPAN_COUNT] = {
+  "loop",
+  "baro",
+  "gps",
+  "sendAll",
+  "encode",
+  "udpSend",
+};
+
+Profiler::Profiler(){
+  memset(_ring, 0, sizeof(_ring));
+  _ringHead = 0;
+  _ringCount = 0;
+  memset(_count, 0, sizeof(_count));
+  memset(_total, 0, sizeof(_total));
+  memset(_max, 0, sizeof(_max));
+}
+
+void Profiler::record(uint8_t id, ProfileTime_t start, ProfileTime_t end)
+{
+  if (id >= PROFILE_SPAN_COUNT) {
+    return;
+  }
+  // Unsigned difference stays right across one cycle counter wrap
+  uint32_t duration = (uint32_t)(end - start);
+
+  ProfileSpan_t& span = _ring[_ringHead];
+  span.id = id;
+  span.start = start;
+  span.duration = duration;
+  _ringHead = (_ringHead + 1) % PROFILER_RING_SIZE;
+  if (_ringCount < PROFILER_RING_SIZE) {
+    _ringCount++;
+  }
+
+  _count[id]++;
+  _total[id] += duration;
+  if (duration > _max[id]) {
+    _max[id] = duration;
+  }
+}
+
+size_t Profiler::takeSummary(ProfileSummary_t* summary, size_t count)
+{
+  if (count > PROFILE_SPAN_COUNT) {
+    count = PROFILE_SPAN_COUNT;
+  }
+  for (size_t i = 0; i < count; i++) {
+    summary[i].count = _count[i];
+    summary[i].totalUs = toUs(_total[i]);
+    summary[i].maxUs = toUs(_max[i]);
+  }
+  memset(_count, 0, sizeof(_count));
+  memset(_total, 0, sizeof(_total));
+  memset(_max, 0, sizeof(_max));
+  return count;
+}
+
+const char* Profiler::getName(uint8_t id)
+{
+  return id < PROFILE_SPAN_COUNT ? PROFILE_NAMES[id] : "unknown";
+}
+
+uint32_t Profiler::toUs(uint64_t duration)
+{
+#ifdef ARDUINO
+  return (uint32_t)(duration / ESP.getCpuFreqMHz());
+#else
+  return (uint32_t)(duration / 1000);
+#endif
+}
+
+#ifndef ARDUINO
+void Profiler::dumpChromeTrace(FILE* out)
+{
+  size_t first = (_ringHead + PROFILER_RING_SIZE - _ringCount) % PROFILER_RING_SIZE;
+
+  fprintf(out, "{\"traceEvents\":[");
+  for (size_t i = 0; i < _ringCount; i++) {
+    const ProfileSpan_t& span = _ring[(first + i) % PROFILER_RING_SIZE];
+    fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+      "\"ts\":%.3f,\"dur\":%.3f}",
+      i == 0 ? "" : ",",
+      getName(span.id),
+      span.start / 1000.0,
+      span.duration / 1000.0);
+  }
+  fprintf(out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+}
+#endif
@@ -0,0 +1,104 @@
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <stdio.h>
+#include <time.h>
+#endif
+
+/* Scoped spans timed with the cycle counter on the device and with
+ * clock_gettime on a host build, kept in a ring buffer and summarized per id.
+ * Build with -DPROFILER_ENABLED=0 to compile the macros out. */
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#ifndef PROFILER_RING_SIZE
+#define PROFILER_RING_SIZE 128
+#endif
+
+enum
+{
+    PROFILE_LOOP = 0,
+    PROFILE_BARO,
+    PROFILE_GPS,
+    PROFILE_SEND_ALL,
+    PROFILE_ENCODE,
+    PROFILE_UDP_SEND,
+    PROFILE_SPAN_COUNT
+};
+
+#ifdef ARDUINO
+typedef uint32_t ProfileTime_t; // [cycles], wraps every 26 s at 160 MHz
+#else
+typedef uint64_t ProfileTime_t; // [ns]
+#endif
+
+typedef struct {
+  ProfileTime_t start;
+  uint32_t duration;
+  uint8_t id;
+} ProfileSpan_t;
+
+typedef struct {
+  uint32_t count;
+  uint32_t totalUs;
+  uint32_t maxUs;
+} ProfileSummary_t;
+
+class Profiler {
+public:
+  Profiler();
+  static inline ProfileTime_t now() {
+#ifdef ARDUINO
+    return ESP.getCycleCount();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ProfileTime_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+  }
+  void record(uint8_t id, ProfileTime_t start, ProfileTime_t end);
+  /* Copy the per id stats gathered since the last call, then reset them.
+   * Returns the number of entries written (PROFILE_SPAN_COUNT at most). */
+  size_t takeSummary(ProfileSummary_t* summary, size_t count);
+  const char* getName(uint8_t id);
+#ifndef ARDUINO
+  /* Write the spans still in the ring as Chrome trace JSON (chrome://tracing) */
+  void dumpChromeTrace(FILE* out);
+#endif
+private:
+  ProfileSpan_t _ring[PROFILER_RING_SIZE];
+  uint16_t _ringHead;
+  uint16_t _ringCount;
+  uint32_t _count[PROFILE_SPAN_COUNT];
+  uint64_t _total[PROFILE_SPAN_COUNT];
+  uint32_t _max[PROFILE_SPAN_COUNT];
+  static uint32_t toUs(uint64_t duration);
+};
+
+extern Profiler profiler;
+
+class ProfileScope {
+public:
+  ProfileScope(uint8_t id) : _id(id), _start(Profiler::now()) {}
+  ~ProfileScope() { profiler.record(_id, _start, Profiler::now()); }
+private:
+  uint8_t _id;
+  ProfileTime_t _start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(id) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(id)
+#else
+#define PROFILE_SCOPE(id) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,267 @@
+#include <TrackHistory.h>
+#include <math.h>
+#include <string.h>
+#include <libpomp.h>
+
+static const float METERS_PER_UNIT = 0.0111319f; // [m] per 1e-7 deg of latitude
+static const unsigned long WEEK_MS = 604800000UL;
+
+static int16_t clamp16(float v)
+{
+  if (v > 32767) {
+    return 32767;
+  }
+  if (v < -32768) {
+    return -32768;
+  }
+  return (int16_t)v;
+}
+
+static float wrapAngle(float a)
+{
+  if (a > (float)M_PI) {
+    return a - 2 * (float)M_PI;
+  }
+  if (a <= -(float)M_PI) {
+    return a + 2 * (float)M_PI;
+  }
+  return a;
+}
+
+TrackHistory::TrackHistory(){
+  _horizontalTolerance = 5;
+  _verticalTolerance = 5;
+  _maxGap = 60000;
+  clear();
+}
+
+void TrackHistory::setTolerance(float horizontal, float vertical)
+{
+  _horizontalTolerance = horizontal;
+  _verticalTolerance = vertical;
+}
+
+void TrackHistory::setMaxGap(uint32_t gap)
+{
+  _maxGap = gap;
+}
+
+void TrackHistory::clear()
+{
+  _head = 0;
+  _count = 0;
+  _overwritten = 0;
+  _baseAltitude = 0;
+  _hasBase = false;
+  _hasAnchor = false;
+  _hasSector = false;
+  _hasSlope = false;
+  _hasCandidate = false;
+  _maxDistance = 0;
+  _returned = false;
+}
+
+size_t TrackHistory::size()
+{
+  return _count;
+}
+
+uint32_t TrackHistory::getOverwritten()
+{
+  return _overwritten;
+}
+
+int32_t TrackHistory::getBaseAltitude()
+{
+  return _baseAltitude;
+}
+
+void TrackHistory::add(const GPSData_t& data)
+{
+  TrackPoint_t point = toPoint(data);
+
+  if (!_hasAnchor) {
+    keep(point);
+    return;
+  }
+  while (!extend(point)) {
+    // A fresh sleeve only refuses a point after a gap
+    if (!closeSleeve()) {
+      keep(point);
+      return;
+    }
+  }
+  _candidate = point;
+  _hasCandidate = true;
+}
+
+size_t TrackHistory::pack(uint8_t* dst, size_t maxLen, size_t* count)
+{
+  // The latest position is worth more than a slightly better simplification
+  if (_hasCandidate) {
+    keep(_candidate);
+  }
+
+  size_t len = 0;
+  size_t n = 0;
+  const TrackPoint_t* previous = NULL;
+  while (n < _count && len + TRACK_POINT_MAX_PACKED <= maxLen) {
+    const TrackPoint_t& point = _ring[(_head + n) % TRACK_HISTORY_SIZE];
+    int32_t values[TRACK_POINT_FIELDS] = {
+      (int32_t)point.iTOW,
+      point.lat,
+      point.lon,
+      point.alt,
+      point.velN,
+      point.velE,
+      point.velD
+    };
+    if (previous != NULL) {
+      values[0] -= (int32_t)previous->iTOW;
+      values[1] -= previous->lat;
+      values[2] -= previous->lon;
+      values[3] -= previous->alt;
+    }
+    len += pomp_varint_encode_i32_array(values, TRACK_POINT_FIELDS, dst + len);
+    previous = &point;
+    n++;
+  }
+  *count = n;
+  return len;
+}
+
+void TrackHistory::consume(size_t count)
+{
+  if (count > _count) {
+    count = _count;
+  }
+  _head = (_head + count) % TRACK_HISTORY_SIZE;
+  _count -= count;
+}
+
+TrackPoint_t TrackHistory::toPoint(const GPSData_t& data)
+{
+  TrackPoint_t point;
+
+  if (!_hasBase) {
+    _baseAltitude = (int32_t)data.altitude;
+    _hasBase = true;
+  }
+  point.iTOW = data.iTOW;
+  point.lat = (int32_t)data.latitude;
+  point.lon = (int32_t)data.longitude;
+  point.alt = clamp16((data.altitude - _baseAltitude) / 100);
+  point.velN = clamp16(data.northSpeed / 10);
+  point.velE = clamp16(data.eastSpeed / 10);
+  point.velD = clamp16(data.downSpeed / 10);
+  return point;
+}
+
+bool TrackHistory::extend(const TrackPoint_t& point)
+{
+  uint32_t dt = (point.iTOW + WEEK_MS - _anchor.iTOW) % WEEK_MS;
+  _returned = false;
+  if (dt > _maxGap) {
+    return false;
+  }
+
+  // Vertical : altitude slope range keeping every point within tolerance
+  float slopeLow = _slopeLow;
+  float slopeHigh = _slopeHigh;
+  if (dt > 0) {
+    float dz = point.alt - _anchor.alt;
+    float tolerance = _verticalTolerance * 10;
+    float slope = dz / dt;
+    if (_hasSlope && (slope < _slopeLow || slope > _slopeHigh)) {
+      return false;
+    }
+    slopeLow = (dz - tolerance) / dt;
+    slopeHigh = (dz + tolerance) / dt;
+  }
+
+  // Horizontal : directions from the anchor keeping every point within tolerance
+  float sectorRef = _sectorRef;
+  float sectorLow = _sectorLow;
+  float sectorHigh = _sectorHigh;
+  float x = (point.lon - _anchor.lon) * _metersPerLon;
+  float y = (point.lat - _anchor.lat) * METERS_PER_UNIT;
+  float distance = sqrtf(x * x + y * y);
+  // Coming back towards the anchor : the turnaround would be lost in the sector
+  if (distance < _maxDistance - _horizontalTolerance) {
+    _returned = true;
+    return false;
+  }
+  if (distance > _horizontalTolerance) {
+    float direction = atan2f(y, x);
+    float half = asinf(_horizontalTolerance / distance);
+    if (!_hasSector) {
+      sectorRef = direction;
+      sectorLow = -half;
+      sectorHigh = half;
+    } else {
+      float relative = wrapAngle(direction - _sectorRef);
+      if (relative < _sectorLow || relative > _sectorHigh) {
+        return false;
+      }
+      sectorLow = fmaxf(_sectorLow, relative - half);
+      sectorHigh = fminf(_sectorHigh, relative + half);
+    }
+    _hasSector = true;
+  }
+
+  if (dt > 0) {
+    _slopeLow = _hasSlope ? fmaxf(_slopeLow, slopeLow) : slopeLow;
+    _slopeHigh = _hasSlope ? fminf(_slopeHigh, slopeHigh) : slopeHigh;
+    _hasSlope = true;
+  }
+  _sectorRef = sectorRef;
+  _sectorLow = sectorLow;
+  _sectorHigh = sectorHigh;
+  if (distance > _maxDistance) {
+    _maxDistance = distance;
+    _farthest = point;
+  }
+  return true;
+}
+
+bool TrackHistory::closeSleeve()
+{
+  // Out and back : the turnaround ends the sleeve, the way back starts from it
+  if (_returned && _hasCandidate && _farthest.iTOW != _candidate.iTOW) {
+    TrackPoint_t candidate = _candidate;
+    keep(_farthest);
+    if (extend(candidate)) {
+      _candidate = candidate;
+      _hasCandidate = true;
+    } else {
+      keep(candidate);
+    }
+    return true;
+  }
+  // Last point reachable in a straight line becomes the new origin
+  if (_hasCandidate) {
+    keep(_candidate);
+    return true;
+  }
+  return false;
+}
+
+void TrackHistory::keep(const TrackPoint_t& point)
+{
+  // Full : the oldest points go, recent track matters most
+  if (_count == TRACK_HISTORY_SIZE) {
+    _head = (_head + 1) % TRACK_HISTORY_SIZE;
+    _count--;
+    _overwritten++;
+  }
+  _ring[(_head + _count) % TRACK_HISTORY_SIZE] = point;
+  _count++;
+
+  _anchor = point;
+  _hasAnchor = true;
+  _metersPerLon = METERS_PER_UNIT * cosf(point.lat * 1e-7f * (float)M_PI / 180);
+  _hasSector = false;
+  _hasSlope = false;
+  _hasCandidate = false;
+  _maxDistance = 0;
+}
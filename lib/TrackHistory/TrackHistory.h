@@ -0,0 +1,80 @@
+#ifndef TrackHistory_h
+#define TrackHistory_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <Types.h>
+
+#ifndef TRACK_HISTORY_SIZE
+#define TRACK_HISTORY_SIZE 256
+#endif
+
+/* 20 bytes per point against 64 for a GPSData_t */
+typedef struct {
+  uint32_t iTOW;  // [ms]
+  int32_t lat;    // [deg 1e-7]
+  int32_t lon;    // [deg 1e-7]
+  int16_t alt;    // [dm] from the history base altitude
+  int16_t velN;   // [cm/s]
+  int16_t velE;   // [cm/s]
+  int16_t velD;   // [cm/s]
+} TrackPoint_t;
+
+const int TRACK_POINT_FIELDS = 7;
+const int TRACK_POINT_MAX_PACKED = TRACK_POINT_FIELDS * 5;
+
+/* Ring of the points needed to redraw the track within a tolerance. Points
+ * are simplified as they come with sleeve (opening window) tests : a point is
+ * kept once the next one can no longer be reached in a straight line from the
+ * last kept point without leaving the tolerance, horizontally (angular sector
+ * seen from that point, nor closer to it than the farthest point so far) or
+ * vertically (altitude slope range). O(1) per fix. */
+class TrackHistory {
+public:
+  TrackHistory();
+  void setTolerance(float horizontal, float vertical); /* [m] */
+  void setMaxGap(uint32_t gap); /* [ms] keep a point at least that often */
+  void add(const GPSData_t& data);
+  size_t size(); /* Kept points, not flushed yet */
+  uint32_t getOverwritten(); /* Oldest points lost to a full ring */
+  int32_t getBaseAltitude(); /* [mm] reference of TrackPoint_t::alt */
+  /* Pack the oldest points as zigzag varints : iTOW, lat, lon, alt, velN, velE,
+   * velD of the first point, then differences with the previous point for the
+   * first four fields. Returns the packed size, count gets the number of
+   * points, to be given to consume() once sent. */
+  size_t pack(uint8_t* dst, size_t maxLen, size_t* count);
+  void consume(size_t count);
+  void clear();
+private:
+  TrackPoint_t _ring[TRACK_HISTORY_SIZE];
+  size_t _head;
+  size_t _count;
+  uint32_t _overwritten;
+  int32_t _baseAltitude;
+  bool _hasBase;
+  float _horizontalTolerance;
+  float _verticalTolerance;
+  uint32_t _maxGap;
+  /* Sleeve from the last kept point */
+  TrackPoint_t _anchor;
+  bool _hasAnchor;
+  float _metersPerLon;
+  bool _hasSector;
+  float _sectorRef;       /* [rad] direction of the first point out of tolerance */
+  float _sectorLow;       /* [rad] relative to _sectorRef */
+  float _sectorHigh;
+  float _maxDistance;     /* [m] farthest point from the anchor in the sleeve */
+  TrackPoint_t _farthest;
+  bool _returned;         /* Last extend() failed on a point coming back */
+  bool _hasSlope;
+  float _slopeLow;        /* [dm/ms] */
+  float _slopeHigh;
+  TrackPoint_t _candidate;
+  bool _hasCandidate;
+  TrackPoint_t toPoint(const GPSData_t& data);
+  bool extend(const TrackPoint_t& point); /* False if the sleeve cannot hold point */
+  bool closeSleeve(); /* Keep the point ending the sleeve, false if there is none */
+  void keep(const TrackPoint_t& point);
+};
+
+#endif
@@ -1,10 +1,12 @@
 #ifndef Types_h
 #define Types_h
 
+#include <stdint.h>
+
 typedef struct {
   double longitude;
   double latitude;
-  double timestampGPS;
+  uint64_t time; // [us] GPS time of the epoch, see GPSClock
   float altitude;
   float northSpeed;
   float eastSpeed;
@@ -14,19 +16,49 @@ typedef struct {
   float speedAcc;
   int numberSV;
   bool isReady;
-  int timestamp;
+  unsigned long iTOW; // [ms] GPS time of week
 } GPSData_t;
 
+typedef struct {
+  unsigned long droppedEpochs;     // missing in the receiver iTOW sequence
+  unsigned long overwrittenEpochs; // replaced before the loop sent them
+  unsigned long uartOverruns;      // RX overruns reported by the UART driver
+  unsigned long checksumFailures;
+} GPSStats_t;
+
 typedef struct {
   long pressureFiltered;
   long pressureZero;
-  int timestamp;
+  uint64_t time; // [us] GPSClock time of the sample
 } BaroData_t;
 
+typedef struct {
+  unsigned long loopRate;         // [iterations/s]
+  unsigned long maxLoopTime;      // [us]
+  unsigned long freeHeap;         // [bytes]
+  unsigned long maxFreeBlock;     // [bytes]
+  unsigned long uartOverruns;
+  unsigned long checksumFailures;
+  unsigned long sendFailures;
+  long rssi;                      // [dBm]
+  unsigned long reconnects;
+  unsigned long gpsConfig;        // GPSConfigStatus_t
+} HealthData_t;
+
+/* Layout of the messages, see Messages in README.md. Version 2 starts every
+ * message with the session and sequence numbers and sends the GPS time of
+ * MSG_GPS and MSG_BARO as %llu; version 1 receivers cannot read it. */
+const uint32_t MSG_FORMAT_VERSION = 2;
+
 enum
 {
     MSG_GPS = 1,
     MSG_BARO,
+    MSG_PROFILE,
+    MSG_HEALTH,
+    MSG_FEC,
+    MSG_TRACK,
+    MSG_GEOFENCE,
 };
 
 #endif
@@ -11,6 +11,7 @@
  **************************************************************/
 
 #include "WiFiManager.h"
+#include <algorithm>
 
 WiFiManagerParameter::WiFiManagerParameter(const char *custom) {
   _id = NULL;
@@ -117,10 +118,18 @@ void WiFiManager::setupConfigPortal() {
   server->on("/r", std::bind(&WiFiManager::handleReset, this));
   //server->on("/generate_204", std::bind(&WiFiManager::handle204, this));  //Android/Chrome OS captive portal check.
   server->on("/fwlink", std::bind(&WiFiManager::handleRoot, this));  //Microsoft captive portal. Maybe not needed. Might be handled by notFound handler.
+  server->on("/wm.css", std::bind(&WiFiManager::handleAsset, this, PSTR("text/css"), WM_STYLE_GZ, sizeof(WM_STYLE_GZ)));
+  server->on("/wm.js", std::bind(&WiFiManager::handleAsset, this, PSTR("application/javascript"), WM_SCRIPT_GZ, sizeof(WM_SCRIPT_GZ)));
+  if (_webservercallback != NULL) {
+    _webservercallback(server.get());
+  }
   server->onNotFound (std::bind(&WiFiManager::handleNotFound, this));
   server->begin(); // Web server start
   DEBUG_WM(F("HTTP server started"));
 
+  //results should be there when the wifi page is opened
+  startScan();
+
 }
 
 boolean WiFiManager::autoConnect() {
@@ -171,11 +180,19 @@ boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPasswo
   connect = false;
   setupConfigPortal();
 
+  if (!_configPortalIsBlocking) {
+    DEBUG_WM(F("Config portal running in non blocking mode"));
+    _configPortalActive = true;
+    _connecting = false;
+    return false;
+  }
+
   while (_configPortalTimeout == 0 || millis() < _configPortalStart + _configPortalTimeout) {
     //DNS
     dnsServer->processNextRequest();
     //HTTP
     server->handleClient();
+    updateScanCache();
 
 
     if (connect) {
@@ -210,10 +227,107 @@ boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPasswo
     yield();
   }
 
+  stopConfigPortal();
+
+  return  WiFi.status() == WL_CONNECTED;
+}
+
+boolean WiFiManager::process() {
+  if (!_configPortalActive) {
+    return false;
+  }
+  if (processConfigPortal()) {
+    stopConfigPortal();
+    return true;
+  }
+  return false;
+}
+
+boolean WiFiManager::processConfigPortal() {
+  if (_configPortalTimeout != 0 && millis() >= _configPortalStart + _configPortalTimeout) {
+    DEBUG_WM(F("Config portal timeout"));
+    return true;
+  }
+
+  //DNS
+  dnsServer->processNextRequest();
+  //HTTP
+  server->handleClient();
+  updateScanCache();
+
+  if (connect) {
+    //wait before switching so the save page reaches the client
+    connect = false;
+    _connecting = true;
+    _connectBegun = false;
+    _connectStart = millis();
+  }
+  if (!_connecting) {
+    return false;
+  }
+
+  if (!_connectBegun) {
+    if (millis() - _connectStart < 2000) {
+      return false;
+    }
+    DEBUG_WM(F("Connecting to new AP"));
+    if (_sta_static_ip) {
+      DEBUG_WM(F("Custom STA IP/GW/Subnet"));
+      WiFi.config(_sta_static_ip, _sta_static_gw, _sta_static_sn);
+    }
+    // using user-provided  _ssid, _pass in place of system-stored ssid and pass
+    if (_ssid != "") {
+      WiFi.begin(_ssid.c_str(), _pass.c_str());
+    } else {
+      WiFi.begin();
+    }
+    _connectBegun = true;
+    _connectStart = millis();
+    return false;
+  }
+
+  // same default as WiFi.waitForConnectResult()
+  unsigned long timeout = _connectTimeout != 0 ? _connectTimeout : 10000;
+  uint8_t connRes = WiFi.status();
+  if (connRes == WL_CONNECTED) {
+    WiFi.mode(WIFI_STA);
+    saveConnectionCache();
+    //notify that configuration has changed and any optional parameters should be saved
+    if ( _savecallback != NULL) {
+      _savecallback();
+    }
+    return true;
+  }
+  if (connRes != WL_CONNECT_FAILED && millis() - _connectStart < timeout) {
+    return false;
+  }
+
+  DEBUG_WM(F("Failed to connect."));
+  _connecting = false;
+  if (_shouldBreakAfterConfig) {
+    //flag set to exit after config after trying to connect
+    if ( _savecallback != NULL) {
+      _savecallback();
+    }
+    return true;
+  }
+  return false;
+}
+
+void WiFiManager::stopConfigPortal() {
   server.reset();
   dnsServer.reset();
+  clearScanCache();
+  _configPortalActive = false;
+  _connecting = false;
+}
 
-  return  WiFi.status() == WL_CONNECTED;
+void WiFiManager::setConfigPortalBlocking(boolean shouldBlock) {
+  _configPortalIsBlocking = shouldBlock;
+}
+
+boolean WiFiManager::isConfigPortalActive() {
+  return _configPortalActive;
 }
 
 
@@ -257,30 +371,181 @@ int WiFiManager::connectWifi(String ssid, String pass) {
     //should be connected at the end of WPS
     connRes = waitForConnectResult();
   }
+  if (connRes == WL_CONNECTED) {
+    saveConnectionCache();
+  }
   return connRes;
 }
 
+boolean WiFiManager::reconnect() {
+  ConnectionCache_t cache;
+
+  WiFi.mode(WIFI_STA);
+  String ssid = WiFi.SSID();
+  String pass = WiFi.psk();
+  if (ssid == "") {
+    DEBUG_WM(F("No saved credentials"));
+    return false;
+  }
+
+  _reconnecting = true;
+  _reconnectStart = millis();
+  _fastReconnect = readConnectionCache(&cache);
+  if (_fastReconnect) {
+    DEBUG_WM(F("Fast reconnect with cached BSSID/channel/lease"));
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gw), IPAddress(cache.sn));
+    //keep the BSSID lock out of the config saved in flash
+    WiFi.persistent(false);
+    WiFi.begin(ssid.c_str(), pass.c_str(), cache.channel, cache.bssid);
+    WiFi.persistent(true);
+  } else {
+    beginReconnect(ssid, pass);
+  }
+  return true;
+}
+
+boolean WiFiManager::processReconnect() {
+  if (!_reconnecting) {
+    return false;
+  }
+  if (WiFi.status() == WL_CONNECTED) {
+    _reconnecting = false;
+    return true;
+  }
+
+  if (_fastReconnect) {
+    if (millis() - _reconnectStart < _fastConnectTimeout) {
+      return false;
+    }
+    //AP moved or lease is no longer valid, do not try it again
+    DEBUG_WM(F("Fast reconnect failed"));
+    clearConnectionCache();
+    //not WiFi.disconnect(), it would erase the saved credentials
+    wifi_station_disconnect();
+    _fastReconnect = false;
+    _reconnectStart = millis();
+    beginReconnect(WiFi.SSID(), WiFi.psk());
+    return false;
+  }
+
+  // same default as WiFi.waitForConnectResult()
+  unsigned long timeout = _connectTimeout != 0 ? _connectTimeout : 10000;
+  if (millis() - _reconnectStart >= timeout) {
+    //the station keeps retrying on its own
+    DEBUG_WM(F("Reconnect timeout"));
+    _reconnecting = false;
+  }
+  return false;
+}
+
+boolean WiFiManager::isReconnecting() {
+  return _reconnecting;
+}
+
+void WiFiManager::beginReconnect(String ssid, String pass) {
+  //back to scan and DHCP, unless a static ip was asked for
+  if (_sta_static_ip) {
+    WiFi.config(_sta_static_ip, _sta_static_gw, _sta_static_sn);
+  } else {
+    wifi_station_dhcpc_start();
+  }
+  WiFi.begin(ssid.c_str(), pass.c_str());
+}
+
+void WiFiManager::saveConnectionCache() {
+  ConnectionCache_t cache;
+  uint8_t* bssid = WiFi.BSSID();
+
+  if (WiFi.status() != WL_CONNECTED || bssid == NULL) {
+    return;
+  }
+  memcpy(cache.bssid, bssid, sizeof(cache.bssid));
+  cache.channel = WiFi.channel();
+  cache.reserved = 0;
+  cache.ip = WiFi.localIP();
+  cache.gw = WiFi.gatewayIP();
+  cache.sn = WiFi.subnetMask();
+  cache.crc = connectionCacheCRC(&cache);
+  writeConnectionCache(&cache);
+}
+
+boolean WiFiManager::readConnectionCache(ConnectionCache_t* cache) {
+  //RTC memory only survives a deep sleep, it is random after a power cycle
+  if (ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE
+      && ESP.rtcUserMemoryRead(WIFI_MANAGER_RTC_OFFSET, (uint32_t*)cache, sizeof(*cache))
+      && validConnectionCache(cache)) {
+    return true;
+  }
+  EEPROM.begin(WIFI_MANAGER_EEPROM_OFFSET + sizeof(*cache));
+  EEPROM.get(WIFI_MANAGER_EEPROM_OFFSET, *cache);
+  EEPROM.end();
+  return validConnectionCache(cache);
+}
+
+boolean WiFiManager::validConnectionCache(ConnectionCache_t* cache) {
+  return cache->crc == connectionCacheCRC(cache) && cache->ip != 0;
+}
+
+/** RTC memory is written every time, flash only when the content changed */
+void WiFiManager::writeConnectionCache(ConnectionCache_t* cache) {
+  ConnectionCache_t saved;
+
+  ESP.rtcUserMemoryWrite(WIFI_MANAGER_RTC_OFFSET, (uint32_t*)cache, sizeof(*cache));
+  EEPROM.begin(WIFI_MANAGER_EEPROM_OFFSET + sizeof(*cache));
+  EEPROM.get(WIFI_MANAGER_EEPROM_OFFSET, saved);
+  if (memcmp(&saved, cache, sizeof(saved)) != 0) {
+    EEPROM.put(WIFI_MANAGER_EEPROM_OFFSET, *cache);
+    EEPROM.commit();
+  }
+  EEPROM.end();
+}
+
+void WiFiManager::clearConnectionCache() {
+  ConnectionCache_t cache;
+  memset(&cache, 0, sizeof(cache));
+  cache.crc = ~connectionCacheCRC(&cache);
+  writeConnectionCache(&cache);
+}
+
+/** CRC32 of the cache, crc field excluded */
+uint32_t WiFiManager::connectionCacheCRC(const ConnectionCache_t* cache) {
+  const uint8_t* data = (const uint8_t*)cache + sizeof(cache->crc);
+  size_t len = sizeof(*cache) - sizeof(cache->crc);
+  uint32_t crc = 0xffffffff;
+  while (len--) {
+    crc ^= *data++;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
 uint8_t WiFiManager::waitForConnectResult() {
   if (_connectTimeout == 0) {
     return WiFi.waitForConnectResult();
   } else {
-    DEBUG_WM (F("Waiting for connection result with time out"));
-    unsigned long start = millis();
-    boolean keepConnecting = true;
-    uint8_t status;
-    while (keepConnecting) {
-      status = WiFi.status();
-      if (millis() > start + _connectTimeout) {
-        keepConnecting = false;
-        DEBUG_WM (F("Connection timed out"));
-      }
-      if (status == WL_CONNECTED || status == WL_CONNECT_FAILED) {
-        keepConnecting = false;
-      }
-      delay(100);
+    return waitForConnectResult(_connectTimeout);
+  }
+}
+
+uint8_t WiFiManager::waitForConnectResult(unsigned long timeout) {
+  DEBUG_WM (F("Waiting for connection result with time out"));
+  unsigned long start = millis();
+  boolean keepConnecting = true;
+  uint8_t status;
+  while (keepConnecting) {
+    status = WiFi.status();
+    if (millis() > start + timeout) {
+      keepConnecting = false;
+      DEBUG_WM (F("Connection timed out"));
+    }
+    if (status == WL_CONNECTED || status == WL_CONNECT_FAILED) {
+      keepConnecting = false;
     }
-    return status;
+    delay(100);
   }
+  return status;
 }
 
 void WiFiManager::startWPS() {
@@ -318,6 +583,7 @@ void WiFiManager::resetSettings() {
   DEBUG_WM(F("settings invalidated"));
   DEBUG_WM(F("THIS MAY CAUSE AP NOT TO START UP PROPERLY. YOU NEED TO COMMENT IT OUT AFTER ERASING THE DATA."));
   WiFi.disconnect(true);
+  clearConnectionCache();
   //delay(200);
 }
 void WiFiManager::setTimeout(unsigned long seconds) {
@@ -328,6 +594,10 @@ void WiFiManager::setConfigPortalTimeout(unsigned long seconds) {
   _configPortalTimeout = seconds * 1000;
 }
 
+void WiFiManager::setFastConnectTimeout(unsigned long seconds) {
+  _fastConnectTimeout = seconds * 1000;
+}
+
 void WiFiManager::setConnectTimeout(unsigned long seconds) {
   _connectTimeout = seconds * 1000;
 }
@@ -363,173 +633,90 @@ void WiFiManager::handleRoot() {
     return;
   }
 
-  String page = FPSTR(HTTP_HEAD);
-  page.replace("{v}", "Options");
-  page += FPSTR(HTTP_SCRIPT);
-  page += FPSTR(HTTP_STYLE);
-  page += _customHeadElement;
-  page += FPSTR(HTTP_HEAD_END);
-  page += F("<h1>Tracker Configuration</h1>");
-  page += "<h2>";
-  page += _apName;
-  page += "</h2>";
-  page += FPSTR(HTTP_PORTAL_OPTIONS);
-  page += FPSTR(HTTP_END);
-
-  server->send(200, "text/html", page);
+  pageBegin("Options");
+  pageWrite_P(PSTR("<h1>Tracker Configuration</h1><h2>"));
+  pageWrite(_apName);
+  pageWrite_P(PSTR("</h2>"));
+  pageWrite_P(HTTP_PORTAL_OPTIONS);
+  pageEnd();
 
 }
 
 /** Wifi config page handler */
 void WiFiManager::handleWifi(boolean scan) {
 
-  String page = FPSTR(HTTP_HEAD);
-  page.replace("{v}", "Config ESP");
-  page += FPSTR(HTTP_SCRIPT);
-  page += FPSTR(HTTP_STYLE);
-  page += _customHeadElement;
-  page += FPSTR(HTTP_HEAD_END);
+  pageBegin("Config ESP");
 
   if (scan) {
-    int n = WiFi.scanNetworks();
-    DEBUG_WM(F("Scan done"));
-    if (n == 0) {
+    updateScanCache();
+    if (!_scanValid || millis() - _scanTime >= _scanCacheTTL) {
+      startScan();
+    }
+
+    if (!_scanValid) {
+      pageWrite_P(PSTR("Scanning networks, refresh in a few seconds."));
+    } else if (_scanCount == 0) {
       DEBUG_WM(F("No networks found"));
-      page += F("No networks found. Refresh to scan again.");
+      pageWrite_P(PSTR("No networks found. Refresh to scan again."));
     } else {
-
-      //sort networks
-      int indices[n];
-      for (int i = 0; i < n; i++) {
-        indices[i] = i;
-      }
-
-      // RSSI SORT
-
-      // old sort
-      for (int i = 0; i < n; i++) {
-        for (int j = i + 1; j < n; j++) {
-          if (WiFi.RSSI(indices[j]) > WiFi.RSSI(indices[i])) {
-            std::swap(indices[i], indices[j]);
-          }
-        }
-      }
-
-      /*std::sort(indices, indices + n, [](const int & a, const int & b) -> bool
-        {
-        return WiFi.RSSI(a) > WiFi.RSSI(b);
-        });*/
-
-      // remove duplicates ( must be RSSI sorted )
-      if (_removeDuplicateAPs) {
-        String cssid;
-        for (int i = 0; i < n; i++) {
-          if (indices[i] == -1) continue;
-          cssid = WiFi.SSID(indices[i]);
-          for (int j = i + 1; j < n; j++) {
-            if (cssid == WiFi.SSID(indices[j])) {
-              DEBUG_WM("DUP AP: " + WiFi.SSID(indices[j]));
-              indices[j] = -1; // set dup aps to index -1
-            }
-          }
-        }
-      }
-
       //display networks in page
-      for (int i = 0; i < n; i++) {
-        if (indices[i] == -1) continue; // skip dups
-        DEBUG_WM(WiFi.SSID(indices[i]));
-        DEBUG_WM(WiFi.RSSI(indices[i]));
-        int quality = getRSSIasQuality(WiFi.RSSI(indices[i]));
+      for (int i = 0; i < _scanCount; i++) {
+        const ScanEntry_t& ap = _scanEntries[_scanOrder[i]];
+        int quality = getRSSIasQuality(ap.rssi);
 
         if (_minimumQuality == -1 || _minimumQuality < quality) {
-          String item = FPSTR(HTTP_ITEM);
-          String rssiQ;
-          rssiQ += quality;
-          item.replace("{v}", WiFi.SSID(indices[i]));
-          item.replace("{r}", rssiQ);
-          if (WiFi.encryptionType(indices[i]) != ENC_TYPE_NONE) {
-            item.replace("{i}", "l");
-          } else {
-            item.replace("{i}", "");
-          }
-          //DEBUG_WM(item);
-          page += item;
+          char rssiQ[5];
+          snprintf(rssiQ, sizeof(rssiQ), "%d", quality);
+          const char* values[] = {
+            ap.ssid.c_str(),
+            rssiQ,
+            ap.encrypted ? "l" : ""
+          };
+          pageWriteTemplate_P(HTTP_ITEM, "vri", values);
           delay(0);
-        } else {
-          DEBUG_WM(F("Skipping due to quality"));
         }
-
       }
-      page += "<br/>";
+      pageWrite("<br/>");
     }
   }
 
-  page += FPSTR(HTTP_FORM_START);
-  char parLength[2];
+  pageWrite_P(HTTP_FORM_START);
+  char parLength[6];
   // add the extra parameters to the form
   for (int i = 0; i < _paramsCount; i++) {
     if (_params[i] == NULL) {
       break;
     }
 
-    String pitem = FPSTR(HTTP_FORM_PARAM);
     if (_params[i]->getID() != NULL) {
-      pitem.replace("{i}", _params[i]->getID());
-      pitem.replace("{n}", _params[i]->getID());
-      pitem.replace("{p}", _params[i]->getPlaceholder());
-      snprintf(parLength, 2, "%d", _params[i]->getValueLength());
-      pitem.replace("{l}", parLength);
-      pitem.replace("{v}", _params[i]->getValue());
-      pitem.replace("{c}", _params[i]->getCustomHTML());
+      snprintf(parLength, sizeof(parLength), "%d", _params[i]->getValueLength());
+      const char* values[] = {
+        _params[i]->getID(),
+        _params[i]->getID(),
+        _params[i]->getPlaceholder(),
+        parLength,
+        _params[i]->getValue(),
+        _params[i]->getCustomHTML()
+      };
+      pageWriteTemplate_P(HTTP_FORM_PARAM, "inplvc", values);
     } else {
-      pitem = _params[i]->getCustomHTML();
+      pageWrite(_params[i]->getCustomHTML());
     }
-
-    page += pitem;
   }
   if (_params[0] != NULL) {
-    page += "<br/>";
+    pageWrite("<br/>");
   }
 
   if (_sta_static_ip) {
-
-    String item = FPSTR(HTTP_FORM_PARAM);
-    item.replace("{i}", "ip");
-    item.replace("{n}", "ip");
-    item.replace("{p}", "Static IP");
-    item.replace("{l}", "15");
-    item.replace("{v}", _sta_static_ip.toString());
-
-    page += item;
-
-    item = FPSTR(HTTP_FORM_PARAM);
-    item.replace("{i}", "gw");
-    item.replace("{n}", "gw");
-    item.replace("{p}", "Static Gateway");
-    item.replace("{l}", "15");
-    item.replace("{v}", _sta_static_gw.toString());
-
-    page += item;
-
-    item = FPSTR(HTTP_FORM_PARAM);
-    item.replace("{i}", "sn");
-    item.replace("{n}", "sn");
-    item.replace("{p}", "Subnet");
-    item.replace("{l}", "15");
-    item.replace("{v}", _sta_static_sn.toString());
-
-    page += item;
-
-    page += "<br/>";
+    pageWriteStaticIP("ip", "Static IP", _sta_static_ip);
+    pageWriteStaticIP("gw", "Static Gateway", _sta_static_gw);
+    pageWriteStaticIP("sn", "Subnet", _sta_static_sn);
+    pageWrite("<br/>");
   }
 
-  page += FPSTR(HTTP_FORM_END);
-  page += FPSTR(HTTP_SCAN_LINK);
-
-  page += FPSTR(HTTP_END);
-
-  server->send(200, "text/html", page);
+  pageWrite_P(HTTP_FORM_END);
+  pageWrite_P(HTTP_SCAN_LINK);
+  pageEnd();
 
 
   DEBUG_WM(F("Sent config page"));
@@ -577,16 +764,9 @@ void WiFiManager::handleWifiSave() {
     optionalIPFromString(&_sta_static_sn, sn.c_str());
   }
 
-  String page = FPSTR(HTTP_HEAD);
-  page.replace("{v}", "Credentials Saved");
-  page += FPSTR(HTTP_SCRIPT);
-  page += FPSTR(HTTP_STYLE);
-  page += _customHeadElement;
-  page += FPSTR(HTTP_HEAD_END);
-  page += FPSTR(HTTP_SAVED);
-  page += FPSTR(HTTP_END);
-
-  server->send(200, "text/html", page);
+  pageBegin("Credentials Saved");
+  pageWrite_P(HTTP_SAVED);
+  pageEnd();
 
   DEBUG_WM(F("Sent wifi save page"));
 
@@ -597,38 +777,23 @@ void WiFiManager::handleWifiSave() {
 void WiFiManager::handleInfo() {
   DEBUG_WM(F("Info"));
 
-  String page = FPSTR(HTTP_HEAD);
-  page.replace("{v}", "Info");
-  page += FPSTR(HTTP_SCRIPT);
-  page += FPSTR(HTTP_STYLE);
-  page += _customHeadElement;
-  page += FPSTR(HTTP_HEAD_END);
-  page += F("<dl>");
-  page += F("<dt>Chip ID</dt><dd>");
-  page += ESP.getChipId();
-  page += F("</dd>");
-  page += F("<dt>Flash Chip ID</dt><dd>");
-  page += ESP.getFlashChipId();
-  page += F("</dd>");
-  page += F("<dt>IDE Flash Size</dt><dd>");
-  page += ESP.getFlashChipSize();
-  page += F(" bytes</dd>");
-  page += F("<dt>Real Flash Size</dt><dd>");
-  page += ESP.getFlashChipRealSize();
-  page += F(" bytes</dd>");
-  page += F("<dt>Soft AP IP</dt><dd>");
-  page += WiFi.softAPIP().toString();
-  page += F("</dd>");
-  page += F("<dt>Soft AP MAC</dt><dd>");
-  page += WiFi.softAPmacAddress();
-  page += F("</dd>");
-  page += F("<dt>Station MAC</dt><dd>");
-  page += WiFi.macAddress();
-  page += F("</dd>");
-  page += F("</dl>");
-  page += FPSTR(HTTP_END);
-
-  server->send(200, "text/html", page);
+  pageBegin("Info");
+  pageWrite_P(PSTR("<dl><dt>Chip ID</dt><dd>"));
+  pageWrite(ESP.getChipId());
+  pageWrite_P(PSTR("</dd><dt>Flash Chip ID</dt><dd>"));
+  pageWrite(ESP.getFlashChipId());
+  pageWrite_P(PSTR("</dd><dt>IDE Flash Size</dt><dd>"));
+  pageWrite(ESP.getFlashChipSize());
+  pageWrite_P(PSTR(" bytes</dd><dt>Real Flash Size</dt><dd>"));
+  pageWrite(ESP.getFlashChipRealSize());
+  pageWrite_P(PSTR(" bytes</dd><dt>Soft AP IP</dt><dd>"));
+  pageWrite(WiFi.softAPIP().toString().c_str());
+  pageWrite_P(PSTR("</dd><dt>Soft AP MAC</dt><dd>"));
+  pageWrite(WiFi.softAPmacAddress().c_str());
+  pageWrite_P(PSTR("</dd><dt>Station MAC</dt><dd>"));
+  pageWrite(WiFi.macAddress().c_str());
+  pageWrite_P(PSTR("</dd></dl>"));
+  pageEnd();
 
   DEBUG_WM(F("Sent info page"));
 }
@@ -637,15 +802,9 @@ void WiFiManager::handleInfo() {
 void WiFiManager::handleReset() {
   DEBUG_WM(F("Reset"));
 
-  String page = FPSTR(HTTP_HEAD);
-  page.replace("{v}", "Info");
-  page += FPSTR(HTTP_SCRIPT);
-  page += FPSTR(HTTP_STYLE);
-  page += _customHeadElement;
-  page += FPSTR(HTTP_HEAD_END);
-  page += F("Module will reset in a few seconds.");
-  page += FPSTR(HTTP_END);
-  server->send(200, "text/html", page);
+  pageBegin("Info");
+  pageWrite_P(PSTR("Module will reset in a few seconds."));
+  pageEnd();
 
   DEBUG_WM(F("Sent reset page"));
   delay(5000);
@@ -687,6 +846,13 @@ void WiFiManager::handleNotFound() {
 }
 
 
+/** Static assets, gzipped at build time by extras/gzip.js */
+void WiFiManager::handleAsset(PGM_P contentType, const uint8_t* content, size_t length) {
+  server->sendHeader("Content-Encoding", "gzip");
+  server->sendHeader("Cache-Control", "max-age=86400");
+  server->send_P(200, contentType, (PGM_P)content, length);
+}
+
 /** Redirect to captive portal if we got a request for another domain. Return true in that case so the page handler do not try to handle the request again. */
 boolean WiFiManager::captivePortal() {
   if (!isIp(server->hostHeader()) ) {
@@ -704,6 +870,11 @@ void WiFiManager::setAPCallback( void (*func)(WiFiManager* myWiFiManager) ) {
   _apcallback = func;
 }
 
+//portal web server callback
+void WiFiManager::setWebServerCallback( void (*func)(ESP8266WebServer*) ) {
+  _webservercallback = func;
+}
+
 //start up save config callback
 void WiFiManager::setSaveConfigCallback( void (*func)(void) ) {
   _savecallback = func;
@@ -719,7 +890,158 @@ void WiFiManager::setRemoveDuplicateAPs(boolean removeDuplicates) {
   _removeDuplicateAPs = removeDuplicates;
 }
 
+void WiFiManager::setScanCacheTTL(unsigned long seconds) {
+  _scanCacheTTL = seconds * 1000;
+}
 
+/** Start a background scan, results are picked up by updateScanCache() */
+void WiFiManager::startScan() {
+  if (_scanRunning) {
+    return;
+  }
+  DEBUG_WM(F("Scan started"));
+  WiFi.scanNetworks(true);
+  _scanRunning = true;
+}
+
+/** Copy the results of a finished scan, sorted by RSSI and without duplicates */
+void WiFiManager::updateScanCache() {
+  if (!_scanRunning) {
+    return;
+  }
+  int n = WiFi.scanComplete();
+  if (n == WIFI_SCAN_RUNNING) {
+    return;
+  }
+  _scanRunning = false;
+  if (n < 0) {
+    DEBUG_WM(F("Scan failed"));
+    return;
+  }
+  DEBUG_WM(F("Scan done"));
+
+  _scanEntries.reset(new ScanEntry_t[n > 0 ? n : 1]);
+  _scanOrder.reset(new int[n > 0 ? n : 1]);
+  ScanEntry_t* e = _scanEntries.get();
+  int* order = _scanOrder.get();
+  for (int i = 0; i < n; i++) {
+    e[i].ssid = WiFi.SSID(i);
+    e[i].rssi = WiFi.RSSI(i);
+    e[i].encrypted = WiFi.encryptionType(i) != ENC_TYPE_NONE;
+    order[i] = i;
+  }
+  WiFi.scanDelete();
+
+  // remove duplicates : group by SSID with the strongest first, keep the first of each group
+  if (_removeDuplicateAPs) {
+    std::sort(order, order + n, [e](int a, int b) {
+      int c = strcmp(e[a].ssid.c_str(), e[b].ssid.c_str());
+      return c != 0 ? c < 0 : e[a].rssi > e[b].rssi;
+    });
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+      if (m == 0 || e[order[i]].ssid != e[order[m - 1]].ssid) {
+        order[m++] = order[i];
+      }
+    }
+    n = m;
+  }
+  std::sort(order, order + n, [e](int a, int b) {
+    return e[a].rssi > e[b].rssi;
+  });
+
+  _scanCount = n;
+  _scanValid = true;
+  _scanTime = millis();
+}
+
+void WiFiManager::clearScanCache() {
+  // a running scan cannot be cancelled, its results are freed by the next scan
+  _scanRunning = false;
+  WiFi.scanDelete();
+  _scanEntries.reset();
+  _scanOrder.reset();
+  _scanCount = 0;
+  _scanValid = false;
+}
+
+
+
+/** Start a chunked html page, the head is streamed with the given title */
+void WiFiManager::pageBegin(const char* title) {
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, "text/html", "");
+  _pageLen = 0;
+
+  const char* values[] = { title };
+  pageWriteTemplate_P(HTTP_HEAD, "v", values);
+  pageWrite_P(HTTP_ASSETS);
+  pageWrite(_customHeadElement);
+  pageWrite_P(HTTP_HEAD_END);
+}
+
+void WiFiManager::pageEnd() {
+  pageWrite_P(HTTP_END);
+  pageFlush();
+  server->sendContent(""); // last chunk
+}
+
+void WiFiManager::pageFlush() {
+  if (_pageLen > 0) {
+    // pgm reads also work on ram on the esp8266, this avoids a String copy
+    server->sendContent_P(_page, _pageLen);
+    _pageLen = 0;
+  }
+}
+
+void WiFiManager::pagePut(char c) {
+  if (_pageLen == WIFI_MANAGER_PAGE_CHUNK) {
+    pageFlush();
+  }
+  _page[_pageLen++] = c;
+}
+
+void WiFiManager::pageWrite(const char* s) {
+  while (*s) {
+    pagePut(*s++);
+  }
+}
+
+void WiFiManager::pageWrite(uint32_t v) {
+  char num[11];
+  ultoa(v, num, 10);
+  pageWrite(num);
+}
+
+void WiFiManager::pageWrite_P(PGM_P s) {
+  char c;
+  while ((c = pgm_read_byte(s++)) != 0) {
+    pagePut(c);
+  }
+}
+
+/** Stream a PROGMEM template, {k} is replaced by values[i] where keys[i] == k */
+void WiFiManager::pageWriteTemplate_P(PGM_P tpl, const char* keys, const char* const* values) {
+  char c;
+  while ((c = pgm_read_byte(tpl++)) != 0) {
+    if (c == '{') {
+      char key = pgm_read_byte(tpl);
+      const char* k = key != 0 ? strchr(keys, key) : NULL;
+      if (k != NULL && pgm_read_byte(tpl + 1) == '}') {
+        pageWrite(values[k - keys]);
+        tpl += 2;
+        continue;
+      }
+    }
+    pagePut(c);
+  }
+}
+
+void WiFiManager::pageWriteStaticIP(const char* id, const char* placeholder, IPAddress ip) {
+  String v = ip.toString();
+  const char* values[] = { id, id, placeholder, "15", v.c_str(), "" };
+  pageWriteTemplate_P(HTTP_FORM_PARAM, "inplvc", values);
+}
 
 template <typename Generic>
 void WiFiManager::DEBUG_WM(Generic text) {
@@ -16,15 +16,16 @@
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #include <DNSServer.h>
+#include <EEPROM.h>
 #include <memory>
+#include "WiFiManagerAssets.h"
 
 extern "C" {
   #include "user_interface.h"
 }
 
 const char HTTP_HEAD[] PROGMEM            = "<!DOCTYPE html><html lang=\"en\"><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1, user-scalable=no\"/><title>{v}</title>";
-const char HTTP_STYLE[] PROGMEM           = "<style>.c{text-align: center;} div,input{padding:5px;font-size:1em;} input{width:95%;} body{text-align: center;font-family:verdana;} button{border:0;border-radius:0.3rem;background-color:#1fa3ec;color:#fff;line-height:2.4rem;font-size:1.2rem;width:100%;} .q{float: right;width: 64px;text-align: right;} .l{background: url(\"data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAACAAAAAgCAMAAABEpIrGAAAALVBMVEX///8EBwfBwsLw8PAzNjaCg4NTVVUjJiZDRUUUFxdiZGSho6OSk5Pg4eFydHTCjaf3AAAAZElEQVQ4je2NSw7AIAhEBamKn97/uMXEGBvozkWb9C2Zx4xzWykBhFAeYp9gkLyZE0zIMno9n4g19hmdY39scwqVkOXaxph0ZCXQcqxSpgQpONa59wkRDOL93eAXvimwlbPbwwVAegLS1HGfZAAAAABJRU5ErkJggg==\") no-repeat left center;background-size: 1em;}</style>";
-const char HTTP_SCRIPT[] PROGMEM          = "<script>function c(l){document.getElementById('s').value=l.innerText||l.textContent;document.getElementById('p').focus();}</script>";
+const char HTTP_ASSETS[] PROGMEM          = "<link rel=\"stylesheet\" href=\"/wm.css\"><script src=\"/wm.js\"></script>";
 const char HTTP_HEAD_END[] PROGMEM        = "</head><body><div style='text-align:left;display:inline-block;min-width:260px;'>";
 const char HTTP_PORTAL_OPTIONS[] PROGMEM  = "<form action=\"/wifi\" method=\"get\"><button>Configure WiFi</button></form><br/><form action=\"/0wifi\" method=\"get\"><button>Configure WiFi (No Scan)</button></form><br/><form action=\"/i\" method=\"get\"><button>Info</button></form><br/><form action=\"/r\" method=\"post\"><button>Reset</button></form>";
 const char HTTP_ITEM[] PROGMEM            = "<div><a href='#p' onclick='c(this)'>{v}</a>&nbsp;<span class='q {i}'>{r}%</span></div>";
@@ -36,6 +37,15 @@ const char HTTP_SAVED[] PROGMEM           = "<div>Credentials Saved<br />Trying
 const char HTTP_END[] PROGMEM             = "</div></body></html>";
 
 #define WIFI_MANAGER_MAX_PARAMS 10
+#define WIFI_MANAGER_PAGE_CHUNK 256
+//offset of the connection cache in RTC user memory, in 4 bytes blocks
+#ifndef WIFI_MANAGER_RTC_OFFSET
+#define WIFI_MANAGER_RTC_OFFSET 0
+#endif
+//offset of the connection cache in the EEPROM sector, in bytes
+#ifndef WIFI_MANAGER_EEPROM_OFFSET
+#define WIFI_MANAGER_EEPROM_OFFSET 0
+#endif
 
 class WiFiManagerParameter {
   public:
@@ -73,12 +83,32 @@ class WiFiManager
     boolean       startConfigPortal(char const *apName, char const *apPassword = NULL);
     boolean       startCustomConfigPortal();
 
+    //if set to false, startConfigPortal returns at once and the portal is run
+    //by calling process() from the main loop
+    void          setConfigPortalBlocking(boolean shouldBlock);
+    //runs one step of a non blocking config portal, returns true once it has closed
+    boolean       process();
+    boolean       isConfigPortalActive();
+
     // get the AP name of the config portal, so it can be used in the callback
     String        getConfigPortalSSID();
     //String        getSSID();
 
     void          resetSettings();
 
+    //starts reconnecting to the saved network, first with the cached BSSID, channel
+    //and lease of the last connection (no scan, no DHCP), then the usual way.
+    //Does not block, processReconnect() has to be called from the main loop
+    boolean       reconnect();
+    //runs one step of the reconnection, returns true once connected
+    boolean       processReconnect();
+    boolean       isReconnecting();
+    //remembers BSSID, channel and lease of the current connection in RTC memory,
+    //and in flash when they changed so that they outlive a power cycle
+    void          saveConnectionCache();
+    //sets how long the cached connection is tried before falling back, in seconds
+    void          setFastConnectTimeout(unsigned long seconds);
+
     //sets timeout before webserver loop ends and exits even if there has been no setup.
     //usefully for devices that failed to connect at some point and got stuck in a webserver loop
     //in seconds setConfigPortalTimeout is a new name for setTimeout
@@ -98,6 +128,8 @@ class WiFiManager
     void          setSTAStaticIPConfig(IPAddress ip, IPAddress gw, IPAddress sn);
     //called when AP mode and config portal is started
     void          setAPCallback( void (*func)(WiFiManager*) );
+    //called when the portal web server is set up, to add pages before it starts
+    void          setWebServerCallback( void (*func)(ESP8266WebServer*) );
     //called when settings have been changed and connection was successful
     void          setSaveConfigCallback( void (*func)(void) );
     //adds a custom parameter
@@ -110,6 +142,8 @@ class WiFiManager
     void          setCustomHeadElement(const char* element);
     //if this is true, remove duplicated Access Points - defaut true
     void          setRemoveDuplicateAPs(boolean removeDuplicates);
+    //scan results are reused for this long before a new background scan - default 10s
+    void          setScanCacheTTL(unsigned long seconds);
 
   private:
     std::unique_ptr<DNSServer>        dnsServer;
@@ -121,6 +155,11 @@ class WiFiManager
     //const String  HTTP_HEAD = "<!DOCTYPE html><html lang=\"en\"><head><meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"/><title>{v}</title>";
 
     void          setupConfigPortal();
+    boolean       processConfigPortal();
+    void          stopConfigPortal();
+    void          startScan();
+    void          updateScanCache();
+    void          clearScanCache();
     void          startWPS();
 
     const char*   _apName                 = "no-net";
@@ -130,6 +169,29 @@ class WiFiManager
     unsigned long _configPortalTimeout    = 0;
     unsigned long _connectTimeout         = 0;
     unsigned long _configPortalStart      = 0;
+    unsigned long _connectStart           = 0;
+    unsigned long _fastConnectTimeout     = 2000;
+    boolean       _configPortalIsBlocking = true;
+    boolean       _configPortalActive     = false;
+    boolean       _connecting             = false;
+    boolean       _connectBegun           = false;
+    boolean       _reconnecting           = false;
+    boolean       _fastReconnect          = false;
+    unsigned long _reconnectStart         = 0;
+
+    typedef struct {
+      String        ssid;
+      int32_t       rssi;
+      boolean       encrypted;
+    } ScanEntry_t;
+
+    std::unique_ptr<ScanEntry_t[]> _scanEntries;
+    std::unique_ptr<int[]>         _scanOrder;   //sorted by RSSI, without duplicates if asked
+    int           _scanCount              = 0;
+    boolean       _scanValid              = false;
+    boolean       _scanRunning            = false;
+    unsigned long _scanTime               = 0;
+    unsigned long _scanCacheTTL           = 10000;
 
     IPAddress     _ap_static_ip;
     IPAddress     _ap_static_gw;
@@ -152,6 +214,24 @@ class WiFiManager
     int           status = WL_IDLE_STATUS;
     int           connectWifi(String ssid, String pass);
     uint8_t       waitForConnectResult();
+    uint8_t       waitForConnectResult(unsigned long timeout);
+    void          beginReconnect(String ssid, String pass);
+
+    typedef struct {
+      uint32_t crc;
+      uint8_t  bssid[6];
+      uint8_t  channel;
+      uint8_t  reserved;
+      uint32_t ip;
+      uint32_t gw;
+      uint32_t sn;
+    } ConnectionCache_t;
+
+    boolean       readConnectionCache(ConnectionCache_t* cache);
+    boolean       validConnectionCache(ConnectionCache_t* cache);
+    void          writeConnectionCache(ConnectionCache_t* cache);
+    void          clearConnectionCache();
+    uint32_t      connectionCacheCRC(const ConnectionCache_t* cache);
 
     void          handleRoot();
     void          handleWifi(boolean scan);
@@ -159,9 +239,23 @@ class WiFiManager
     void          handleInfo();
     void          handleReset();
     void          handleNotFound();
+    void          handleAsset(PGM_P contentType, const uint8_t* content, size_t length);
     void          handle204();
     boolean       captivePortal();
 
+    //pages are streamed in chunks instead of being built in a String
+    void          pageBegin(const char* title);
+    void          pageEnd();
+    void          pageFlush();
+    void          pagePut(char c);
+    void          pageWrite(const char* s);
+    void          pageWrite(uint32_t v);
+    void          pageWrite_P(PGM_P s);
+    void          pageWriteTemplate_P(PGM_P tpl, const char* keys, const char* const* values);
+    void          pageWriteStaticIP(const char* id, const char* placeholder, IPAddress ip);
+    char          _page[WIFI_MANAGER_PAGE_CHUNK];
+    size_t        _pageLen                = 0;
+
     // DNS server
     const byte    DNS_PORT = 53;
 
@@ -175,6 +269,7 @@ class WiFiManager
 
     void (*_apcallback)(WiFiManager*) = NULL;
     void (*_savecallback)(void) = NULL;
+    void (*_webservercallback)(ESP8266WebServer*) = NULL;
 
     WiFiManagerParameter* _params[WIFI_MANAGER_MAX_PARAMS];
 
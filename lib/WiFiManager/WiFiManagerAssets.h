@@ -0,0 +1,53 @@
+// Generated by extras/gzip.js from extras/WiFiManager.template.html, do not edit
+
+#ifndef WiFiManagerAssets_h
+#define WiFiManagerAssets_h
+
+// HTTP_STYLE : 661 bytes, 499 gzipped
+const uint8_t WM_STYLE_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x52, 0x5d, 0x6f, 0xaa, 0x40,
+  0x10, 0xfd, 0x2b, 0xa6, 0x37, 0x4d, 0xee, 0x4d, 0x8a, 0xa2, 0xa2, 0x2d, 0x6c, 0xfa, 0xb0, 0x58,
+  0x6a, 0xb5, 0x7e, 0x5b, 0xa8, 0xe5, 0x6d, 0x61, 0x97, 0x65, 0x05, 0x76, 0x71, 0x5d, 0x05, 0x35,
+  0xfc, 0xf7, 0xc6, 0x6a, 0x52, 0x1f, 0xee, 0xdb, 0x9c, 0x39, 0x73, 0x26, 0x67, 0x32, 0xa7, 0x1e,
+  0x9e, 0x14, 0x29, 0x95, 0x86, 0x52, 0x46, 0xb9, 0x15, 0x12, 0xae, 0x88, 0x04, 0x15, 0x66, 0xfb,
+  0x07, 0xc6, 0xf3, 0x9d, 0x3a, 0xe5, 0x08, 0x63, 0xc6, 0xa9, 0xd5, 0xc9, 0x4b, 0x10, 0x09, 0xae,
+  0xb4, 0x2d, 0x3b, 0x12, 0xab, 0x49, 0x32, 0x50, 0x5d, 0x06, 0x0a, 0x86, 0x55, 0x6c, 0x99, 0x9d,
+  0x7b, 0x50, 0x05, 0x02, 0x1f, 0xfe, 0xb3, 0xed, 0x47, 0x16, 0xa1, 0x8c, 0xa5, 0x07, 0x6b, 0x4f,
+  0x24, 0x46, 0x1c, 0x81, 0x2a, 0xd8, 0x29, 0x25, 0xf8, 0x29, 0x10, 0x12, 0x13, 0x69, 0xe9, 0xe0,
+  0x52, 0x68, 0x12, 0x61, 0xb6, 0xdb, 0x5a, 0x7a, 0xbd, 0x2d, 0x49, 0x06, 0x02, 0x14, 0x26, 0x54,
+  0x8a, 0x1d, 0xc7, 0x5a, 0x28, 0x52, 0x21, 0xad, 0x3f, 0xcd, 0x08, 0xb5, 0x49, 0x08, 0xae, 0x28,
+  0x8a, 0x22, 0x90, 0x32, 0x4e, 0xb4, 0x98, 0x30, 0x1a, 0x2b, 0xab, 0x55, 0x37, 0xce, 0xb2, 0x1b,
+  0x9f, 0xf5, 0xd6, 0xb9, 0x71, 0xf1, 0xd8, 0xd4, 0xf5, 0x7b, 0x50, 0xd5, 0xea, 0x9b, 0x53, 0x94,
+  0x0a, 0xa4, 0x2c, 0x79, 0xd6, 0x5c, 0xb9, 0xae, 0x91, 0x97, 0xe0, 0xc6, 0xfa, 0x85, 0xab, 0x6a,
+  0xf5, 0xf4, 0xf4, 0x6b, 0xc2, 0xda, 0xc9, 0xf4, 0xef, 0x1d, 0x46, 0x0a, 0x59, 0x2c, 0x43, 0x94,
+  0x34, 0x72, 0x4e, 0x41, 0x80, 0xb6, 0xa4, 0x6b, 0x3c, 0x30, 0xcf, 0x9e, 0x2e, 0x0a, 0xfd, 0xbd,
+  0x4f, 0x05, 0x84, 0x10, 0x4e, 0x96, 0x6e, 0xec, 0xb8, 0x14, 0x42, 0xd8, 0x3b, 0x43, 0x48, 0x7b,
+  0x70, 0x0c, 0x21, 0xb4, 0x9d, 0x7c, 0x20, 0xfb, 0xe7, 0xc6, 0xc8, 0xb3, 0xc7, 0x9e, 0xb3, 0x6a,
+  0x34, 0x1a, 0x4f, 0x8e, 0x5d, 0x44, 0x76, 0xb1, 0x1d, 0x15, 0x4f, 0x33, 0x78, 0x9c, 0xac, 0x51,
+  0x8f, 0x1a, 0x93, 0x0f, 0xcf, 0x73, 0xd7, 0x43, 0xe6, 0xbf, 0x2c, 0x5c, 0xd7, 0x7d, 0x2d, 0x31,
+  0xf3, 0xfb, 0xcb, 0x58, 0x74, 0xa7, 0xcb, 0xa4, 0x33, 0xa3, 0x06, 0x79, 0x3d, 0xe0, 0xb7, 0x8f,
+  0xde, 0x1a, 0x45, 0xed, 0xf3, 0x2e, 0xdf, 0x49, 0x9d, 0xb9, 0x37, 0x37, 0xd6, 0xa4, 0x35, 0x59,
+  0x16, 0x8f, 0x70, 0x00, 0x63, 0xc7, 0x46, 0xd9, 0x3b, 0x37, 0x1f, 0x1b, 0xbb, 0xf1, 0xca, 0xe9,
+  0xdb, 0x7b, 0x71, 0x4c, 0x3e, 0x03, 0xb3, 0xd7, 0xf2, 0x4b, 0xa3, 0x3c, 0x7e, 0x1e, 0x12, 0x3b,
+  0x7e, 0x85, 0xe4, 0x2b, 0x37, 0x69, 0x32, 0x3a, 0xf8, 0x8e, 0x7e, 0x1c, 0x8c, 0xb9, 0x30, 0xb9,
+  0x41, 0x9b, 0x66, 0x9c, 0xe1, 0xaf, 0xb6, 0xb9, 0x0d, 0x8b, 0x8d, 0x97, 0x4c, 0x57, 0xa8, 0xcc,
+  0x63, 0xdd, 0xef, 0xad, 0xe6, 0xe1, 0xa6, 0x5c, 0xe6, 0x74, 0x9e, 0x4f, 0x27, 0xa8, 0x63, 0x16,
+  0xc9, 0xe2, 0x65, 0x3a, 0x32, 0xdb, 0x04, 0xae, 0xf6, 0x2c, 0x2b, 0xd2, 0x60, 0x16, 0x14, 0x85,
+  0x07, 0x09, 0x1d, 0x2d, 0x9b, 0x6f, 0xfd, 0xc8, 0xff, 0x39, 0xd9, 0x1e, 0x2e, 0xdc, 0x8e, 0x23,
+  0x93, 0x21, 0xa5, 0xf4, 0xf9, 0xf9, 0xee, 0x1f, 0x17, 0x9a, 0x24, 0x39, 0x41, 0xaa, 0x96, 0x92,
+  0x48, 0xd5, 0xae, 0xe1, 0xb8, 0x79, 0xf1, 0x6f, 0xb2, 0xbe, 0x01, 0x8d, 0x24, 0x9c, 0xae, 0x95,
+  0x02, 0x00, 0x00,
+};
+
+// HTTP_SCRIPT : 114 bytes, 109 gzipped
+const uint8_t WM_SCRIPT_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4b, 0x2b, 0xcd, 0x4b, 0x2e, 0xc9,
+  0xcc, 0xcf, 0x53, 0x48, 0xd6, 0xc8, 0xd1, 0xac, 0x4e, 0xc9, 0x4f, 0x2e, 0xcd, 0x4d, 0xcd, 0x2b,
+  0xd1, 0x4b, 0x4f, 0x2d, 0x71, 0xcd, 0x49, 0x05, 0x31, 0x9d, 0x2a, 0x3d, 0x53, 0x34, 0xd4, 0x8b,
+  0xd5, 0x35, 0xf5, 0xca, 0x12, 0x73, 0x4a, 0x53, 0x6d, 0x73, 0xf4, 0x32, 0xf3, 0xf2, 0x52, 0x8b,
+  0x42, 0x52, 0x2b, 0x4a, 0x6a, 0x6a, 0x72, 0xf4, 0x4a, 0x52, 0x2b, 0x4a, 0x9c, 0xf3, 0xf3, 0x4a,
+  0x52, 0xf3, 0x4a, 0xac, 0x71, 0xea, 0x2e, 0x50, 0xd7, 0xd4, 0x4b, 0xcb, 0x4f, 0x2e, 0x2d, 0xd6,
+  0xd0, 0xb4, 0xae, 0x05, 0x00, 0x06, 0x53, 0xe7, 0x8e, 0x72, 0x00, 0x00, 0x00,
+};
+
+#endif
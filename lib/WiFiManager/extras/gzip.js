@@ -0,0 +1,48 @@
+'use strict';
+
+// Builds ../WiFiManagerAssets.h : the static portions of the portal (style
+// and script) gzipped into PROGMEM blobs, served with Content-Encoding: gzip
+// by WiFiManager. Run it after editing WiFiManager.template.html.
+
+const fs = require('fs');
+const zlib = require('zlib');
+
+const inFile = 'WiFiManager.template.html';
+const outFile = '../WiFiManagerAssets.h';
+
+// section in template, tag to strip, constant name
+const assets = [
+  ['HTTP_STYLE', 'style', 'WM_STYLE_GZ'],
+  ['HTTP_SCRIPT', 'script', 'WM_SCRIPT_GZ'],
+];
+
+console.log('parsing', inFile);
+const data = fs.readFileSync(inFile, 'utf8');
+
+let out = '// Generated by extras/gzip.js from extras/' + inFile + ', do not edit\n\n';
+out += '#ifndef WiFiManagerAssets_h\n#define WiFiManagerAssets_h\n\n';
+
+for (const [section, tag, constantName] of assets) {
+  const extractRE = new RegExp('<!-- ' + section + ' -->([\\s\\S]+)<!-- /' + section + ' -->', 'm');
+  let def = extractRE.exec(data)[1];
+  //minimise a bit, same as parse.js
+  def = def.replace(/\s+/g, ' ');
+  def = def.replace(/>\s+</g, '><');
+  def = def.trim();
+  def = def.replace(/(\w)\s(\W)|(\W)\s(\w)/g, '$1$2$3$4');
+  //only the content is served
+  def = def.replace(new RegExp('^<' + tag + '>\\s*'), '').replace(new RegExp('\\s*</' + tag + '>$'), '');
+
+  const gz = zlib.gzipSync(Buffer.from(def, 'utf8'), { level: 9 });
+  console.log(constantName, def.length, '->', gz.length, 'bytes');
+
+  out += '// ' + section + ' : ' + def.length + ' bytes, ' + gz.length + ' gzipped\n';
+  out += 'const uint8_t ' + constantName + '[] PROGMEM = {';
+  for (let i = 0; i < gz.length; i++) {
+    out += (i % 16 === 0 ? '\n  ' : ' ') + '0x' + gz[i].toString(16).padStart(2, '0') + ',';
+  }
+  out += '\n};\n\n';
+}
+
+out += '#endif\n';
+fs.writeFileSync(outFile, out);
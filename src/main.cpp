@@ -9,16 +9,44 @@
 #include <GPSManager.h>
 #include <LEDManager.h>
 #include <MessagesManager.h>
+#include <Profiler.h>
+#include <TrackHistory.h>
+#include <BlackBox.h>
+#include <BlackBoxServer.h>
+#include <Geofence.h>
+#include <GeofenceZones.h>
+#include <MotionPolicy.h>
+#include <libpomp.h>
 
 /* Settings */
 const bool DEBUG = true;
-const char FORMAT_MSG_GPS[] = "%lf%lf%f%f%f%f%f%f%lf";
-const char FORMAT_MSG_BARO[] = "%f%lf";
+const bool DEBUG_FIXES = false; // per fix log blocks the loop at high nav rates
+const char FORMAT_MSG_GPS[] = "%lf%lf%f%f%f%f%f%f%d%llu";
+const char FORMAT_MSG_BARO[] = "%f%llu";
+const char FORMAT_MSG_PROFILE[] = "%u%p%u"; // spans, varint count/totalUs/maxUs per span
+const uint32_t PROFILE_PERIOD = 1000; // [ms]
+const char FORMAT_MSG_HEALTH[] = "%u%u%u%u%u%u%u%d%u%u";
+const uint32_t HEALTH_PERIOD = 1000; // [ms]
+const uint8_t FEC_GROUP = 0; // parity message every n messages, 0 = off
+const char FORMAT_MSG_TRACK[] = "%u%d%p%u"; // points, base altitude [mm], TrackHistory::pack data
+const char FORMAT_MSG_GEOFENCE[] = "%u%u%u"; // zone id, GeofenceEventType_t, iTOW [ms]
+const float TRACK_TOLERANCE = 5; // [m]
+const uint32_t TRACK_FLUSH_PERIOD = 100; // [ms] keeps the live stream first once back online
+const int TRACK_FLUSH_SIZE = 200; // [bytes] per message, FEC protected
+const float MOTION_SPEED = 500; // [mm/s] above the reported speed accuracy
+const float MOTION_DISTANCE = 5000; // [mm] above the reported position accuracy
+const uint32_t MOTION_STILL_DELAY = 3000; // [ms] full rate after the last motion
+const uint32_t MOTION_KEEPALIVE = 10000; // [ms] one fix that often when still
+const uint32_t BLACKBOX_SLOW_PERIOD = 1000000; // [us] logged that often when parked or the ground gets the stream
 const int THRESHOLD_HORIZONTAL_ACC = 20e3; // [mm]
 const int TRIGGER_WIFI = 14;
 const int LED_PIN = 5; // 5 or 16
+const uint32_t GPS_BAUD = 921600; // negotiated, lowered if the link degrades
+const uint16_t GPS_NAV_PERIOD = 40; // [ms] 25 Hz, 200 for the former 5 Hz
 const char* host = "192.168.42.1";
 const uint32_t port = 5152;
+const char* backupHost = NULL; // second ground station, same port
+const uint32_t BACKUP_MIN_INTERVAL = 0; // [ms] 0 forwards every message
 
 WiFiManager wifiManager;
 LEDManager led(LED_PIN);
@@ -28,9 +56,26 @@ BaroData_t baroData;
 
 GPSManager gps;
 GPSData_t gpsData;
+TrackHistory track;
+uint32_t trackTimer = 0;
+MotionPolicy motion;
+
+FlashStorage flashStorage;
+BlackBox blackBox(flashStorage);
+BlackBoxServer blackBoxServer(blackBox, flashStorage);
 
 MessagesManager msg;
 
+uint32_t profileTimer = 0;
+
+HealthData_t healthData;
+uint32_t healthTimer = 0;
+uint32_t loopCount = 0;
+uint32_t loopMaxTime = 0;
+uint32_t reconnectCount = 0;
+bool wifiUp = false;           // msg initialized for the current connection
+bool wifiReconnecting = false;
+
 template <typename Generic>
 void debugLog(Generic text) {
   if (DEBUG) {
@@ -38,32 +83,53 @@ void debugLog(Generic text) {
   }
 }
 
+void attachBlackBox(ESP8266WebServer* server)
+{
+  blackBoxServer.attach(server);
+}
+
 void setWiFi()
 {
   if (digitalRead(TRIGGER_WIFI) == LOW) {
     debugLog("Button pushed\n");
-    led.blink(1,0);
-    delay(500);
+    // Flight logs are downloaded from the portal soft-AP
+    wifiManager.setWebServerCallback(attachBlackBox);
     wifiManager.setMinimumSignalQuality(50);
-    if(!wifiManager.startCustomConfigPortal())
-    {
+    // Portal is run from loop() so sensors keep sampling meanwhile
+    wifiManager.setConfigPortalBlocking(false);
+    wifiManager.startCustomConfigPortal();
+  }
+}
+
+void processConfigPortal()
+{
+  if (wifiManager.process()) {
+    if (WiFi.status() != WL_CONNECTED) {
       debugLog("Failed to connect\n");
     }
-    msg.init(host,port);
-    while(WiFi.status() != WL_CONNECTED) {
-      delay(100);
-    }
-    led.blink(0,0);
+    // checkWifiStatus() sets the messages up once connected
   }
 }
+
 void checkWifiStatus()
 {
-  if (WiFi.status() != WL_CONNECTED) {
-    WiFi.begin();
-    while(WiFi.status() != WL_CONNECTED) {
-      delay(100); // on veut rester bloqué si on perd la connexion
+  // One step at a time, the loop goes on recording the track meanwhile
+  wifiManager.processReconnect();
+  if (WiFi.status() == WL_CONNECTED) {
+    if (!wifiUp) {
+      wifiUp = true;
+      wifiReconnecting = false;
+      wifiManager.saveConnectionCache();
+      msg.init();
     }
-    msg.init(host,port);
+    return;
+  }
+  wifiUp = false;
+  // Once given up, the station keeps retrying on its own
+  if (!wifiReconnecting) {
+    wifiReconnecting = true;
+    reconnectCount++;
+    wifiManager.reconnect();
   }
 }
 
@@ -72,74 +138,230 @@ void sendAllMessages()
   if(gps.isReady())
   {
     gpsData = gps.getData();
+    GeofenceEvent_t event;
+    while (geofence.popEvent(&event)) {
+      msg.send(MSG_GEOFENCE, FORMAT_MSG_GEOFENCE, (uint32_t) event.id, (uint32_t) event.type, (uint32_t) event.iTOW);
+    }
+    // Parked, only keepalives go out
+    bool sendFix = motion.shouldSend(gpsData);
+    // Full rate in the black box only when moving out of reach : it keeps
+    // 38 s of that against 16 min at the slow rate, which wears the flash 25
+    // times less
+    bool logAll = !motion.isStationary() && WiFi.status() != WL_CONNECTED;
+    blackBox.setDecimation(logAll ? 0 : BLACKBOX_SLOW_PERIOD);
+    int rawLength;
+    const byte* raw = gps.getRawPVT(&rawLength);
+    blackBox.appendPVT(gpsData.time, raw, rawLength);
+    // Simplified track of the outage, the backlog only holds the last fixes
+    if (WiFi.status() != WL_CONNECTED) {
+      track.add(gpsData);
+    }
 
-    msg.send(MSG_GPS,
-      FORMAT_MSG_GPS,
-      gpsData.latitude/1e7,
-      gpsData.longitude/1e7,
-      gpsData.altitude/1000.0,
-      gpsData.horizontalAcc/1000.0,
-      gpsData.verticalAcc/1000.0,
-      gpsData.northSpeed/1000.0,
-      gpsData.eastSpeed/1000.0,
-      gpsData.downSpeed/1000.0,
-      gpsData.numberSV);
-    debugLog("GPS  : lat=");
-    debugLog(gpsData.latitude/1e7);
-    debugLog("deg lon=");
-    debugLog(gpsData.longitude/1e7);
-    debugLog("deg height=");
-    debugLog(gpsData.altitude);
-    debugLog("mm hAcc=");
-    debugLog(gpsData.horizontalAcc);
-    debugLog("mm vAcc=");
-    debugLog(gpsData.verticalAcc);
-    debugLog("mm velN=");
-    debugLog(gpsData.northSpeed);
-    debugLog("mm/s velE=");
-    debugLog(gpsData.eastSpeed);
-    debugLog("mm/s velD=");
-    debugLog(gpsData.downSpeed);
-    debugLog("mm/s");
-    debugLog(" numSV=");
-    debugLog(gpsData.numberSV);
-    debugLog("\n");
+    if (sendFix) {
+      msg.send(MSG_GPS,
+        FORMAT_MSG_GPS,
+        gpsData.latitude/1e7,
+        gpsData.longitude/1e7,
+        gpsData.altitude/1000.0,
+        gpsData.horizontalAcc/1000.0,
+        gpsData.verticalAcc/1000.0,
+        gpsData.northSpeed/1000.0,
+        gpsData.eastSpeed/1000.0,
+        gpsData.downSpeed/1000.0,
+        gpsData.numberSV,
+        gpsData.time);
+    }
+    if (DEBUG_FIXES) {
+      debugLog("GPS  : lat=");
+      debugLog(gpsData.latitude/1e7);
+      debugLog("deg lon=");
+      debugLog(gpsData.longitude/1e7);
+      debugLog("deg height=");
+      debugLog(gpsData.altitude);
+      debugLog("mm hAcc=");
+      debugLog(gpsData.horizontalAcc);
+      debugLog("mm vAcc=");
+      debugLog(gpsData.verticalAcc);
+      debugLog("mm velN=");
+      debugLog(gpsData.northSpeed);
+      debugLog("mm/s velE=");
+      debugLog(gpsData.eastSpeed);
+      debugLog("mm/s velD=");
+      debugLog(gpsData.downSpeed);
+      debugLog("mm/s");
+      debugLog(" numSV=");
+      debugLog(gpsData.numberSV);
+      debugLog("\n");
+    }
 
     baroData = baro.getData();
+    blackBox.appendBaro(baroData.time, baroData.pressureFiltered);
 
-    msg.send(MSG_BARO,
-      FORMAT_MSG_BARO,
-      (float) baroData.pressureFiltered, // TODO : avoid cast
-      (float) baroData.timestamp);
-    debugLog("BARO : pressure =");
-    debugLog(baroData.pressureFiltered);
-    debugLog("Pa timestamp = ");
-    debugLog(baroData.timestamp);
-    debugLog("\n");
+    if (sendFix) {
+      msg.send(MSG_BARO,
+        FORMAT_MSG_BARO,
+        (float) baroData.pressureFiltered, // TODO : avoid cast
+        baroData.time);
+    }
+    if (DEBUG_FIXES) {
+      debugLog("BARO : pressure =");
+      debugLog(baroData.pressureFiltered);
+      debugLog("Pa time = ");
+      debugLog((uint32_t) (baroData.time / 1000));
+      debugLog("\n");
+    }
 
     gps.prepareNextMeasure();
-    baro.updateTimestamp();
   }
 }
 
+void flushTrack()
+{
+  if (track.size() == 0 || WiFi.status() != WL_CONNECTED
+      || millis() - trackTimer < TRACK_FLUSH_PERIOD) {
+    return;
+  }
+  trackTimer = millis();
+
+  static uint8_t packed[TRACK_FLUSH_SIZE];
+  size_t count = 0;
+  size_t len = track.pack(packed, sizeof(packed), &count);
+
+  msg.send(MSG_TRACK,
+    FORMAT_MSG_TRACK,
+    (uint32_t) count,
+    (int32_t) track.getBaseAltitude(),
+    packed,
+    (uint32_t) len);
+  track.consume(count);
+}
+
+void sendProfile()
+{
+  if (millis() - profileTimer < PROFILE_PERIOD) {
+    return;
+  }
+  profileTimer = millis();
+
+  ProfileSummary_t summary[PROFILE_SPAN_COUNT];
+  uint32_t values[PROFILE_SPAN_COUNT * 3];
+  uint8_t packed[PROFILE_SPAN_COUNT * 3 * 5];
+  size_t count = profiler.takeSummary(summary, PROFILE_SPAN_COUNT);
+
+  for (size_t i = 0; i < count; i++) {
+    values[3*i] = summary[i].count;
+    values[3*i+1] = summary[i].totalUs;
+    values[3*i+2] = summary[i].maxUs;
+  }
+  size_t len = pomp_varint_encode_u32_array(values, 3*count, packed);
+  msg.send(MSG_PROFILE, FORMAT_MSG_PROFILE, (uint32_t) count, packed, (uint32_t) len);
+}
+
+void sendHealth()
+{
+  uint32_t elapsed = millis() - healthTimer;
+  if (elapsed < HEALTH_PERIOD) {
+    return;
+  }
+  healthTimer = millis();
+
+  GPSStats_t gpsStats = gps.getStats();
+
+  healthData.loopRate = (uint32_t) ((uint64_t) loopCount * 1000 / elapsed);
+  healthData.maxLoopTime = loopMaxTime;
+  healthData.freeHeap = ESP.getFreeHeap();
+  healthData.maxFreeBlock = ESP.getMaxFreeBlockSize();
+  healthData.uartOverruns = gpsStats.uartOverruns;
+  healthData.checksumFailures = gpsStats.checksumFailures;
+  healthData.sendFailures = msg.getSendFailures();
+  healthData.rssi = WiFi.RSSI();
+  healthData.reconnects = reconnectCount;
+  healthData.gpsConfig = gps.getConfigStatus();
+  loopCount = 0;
+  loopMaxTime = 0;
+
+  msg.send(MSG_HEALTH,
+    FORMAT_MSG_HEALTH,
+    (uint32_t) healthData.loopRate,
+    (uint32_t) healthData.maxLoopTime,
+    (uint32_t) healthData.freeHeap,
+    (uint32_t) healthData.maxFreeBlock,
+    (uint32_t) healthData.uartOverruns,
+    (uint32_t) healthData.checksumFailures,
+    (uint32_t) healthData.sendFailures,
+    (int32_t) healthData.rssi,
+    (uint32_t) healthData.reconnects,
+    (uint32_t) healthData.gpsConfig);
+}
+
 void setup() {
-  Serial.begin(230400);   // Setup GPS connection
-  Serial.swap();
+  gps.init(GPS_BAUD);     // Setup GPS connection
+  gps.setNavRate(GPS_NAV_PERIOD);
+  gps.flash();            // Sent once the link is up, result in MSG_HEALTH
   Serial1.begin(230400);  // Setup UART-USB connection
   debugLog("******* BOOT *******\n");
-  pinMode(LED_PIN, OUTPUT);
+  led.init();
   pinMode(TRIGGER_WIFI,INPUT_PULLUP);
   Wire.begin(4,12);       // Setup Baro connection
   Wire.setClock(400000);
-  //TODO : validate gps.flash();
   baro.init();
+  if (!blackBox.init()) {
+    debugLog("Black box unavailable\n");
+  }
+  if (!geofence.init(GEOFENCE_ZONES, GEOFENCE_ZONE_COUNT, GEOFENCE_VERTICES)) {
+    debugLog("Geofence index does not fit\n");
+  }
+  msg.setFEC(FEC_GROUP);
+  track.setTolerance(TRACK_TOLERANCE,TRACK_TOLERANCE);
+  motion.setSpeedThreshold(MOTION_SPEED);
+  motion.setDistanceThreshold(MOTION_DISTANCE);
+  motion.setStillDelay(MOTION_STILL_DELAY);
+  motion.setKeepalive(MOTION_KEEPALIVE);
+  msg.addDestination(host,port);
+  if (backupHost != NULL) {
+    msg.addDestination(backupHost,port,BACKUP_MIN_INTERVAL);
+  }
   setWiFi();
 }
 
 void loop() {
-  checkWifiStatus();
-  baro.process();
-  gps.process();
-  sendAllMessages();
-  led.status(WiFi.status() == WL_CONNECTED,gpsData.horizontalAcc < THRESHOLD_HORIZONTAL_ACC);
+  PROFILE_SCOPE(PROFILE_LOOP);
+  uint32_t loopStart = micros();
+  if (wifiManager.isConfigPortalActive()) {
+    processConfigPortal();
+  } else {
+    checkWifiStatus();
+  }
+  {
+    PROFILE_SCOPE(PROFILE_BARO);
+    baro.process();
+  }
+  {
+    PROFILE_SCOPE(PROFILE_GPS);
+    gps.process();
+  }
+  {
+    PROFILE_SCOPE(PROFILE_SEND_ALL);
+    sendAllMessages();
+  }
+  flushTrack();
+  sendProfile();
+  sendHealth();
+  msg.process();
+  blackBox.process();
+  blackBoxServer.process();
+  if (wifiManager.isConfigPortalActive()) {
+    led.setPattern(LED_PATTERN_ON);
+  } else if (wifiReconnecting) {
+    led.setPattern(LED_PATTERN_WIFI_RECONNECTING);
+  } else if (msg.isBacklogFull()) {
+    led.setPattern(LED_PATTERN_BUFFER_OVERFLOW);
+  } else {
+    led.status(WiFi.status() == WL_CONNECTED,gpsData.horizontalAcc < THRESHOLD_HORIZONTAL_ACC);
+  }
+  uint32_t loopTime = micros() - loopStart;
+  if (loopTime > loopMaxTime) {
+    loopMaxTime = loopTime;
+  }
+  loopCount++;
 }
@@ -0,0 +1,45 @@
+#ifndef AllocCounter_h
+#define AllocCounter_h
+
+#include <stdlib.h>
+
+/* Heap calls of the test and the library objects it links, libstdc++ aside :
+ * the test is linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free */
+static size_t allocCount = 0;   /* malloc and calloc */
+static size_t reallocCount = 0;
+static size_t freeCount = 0;    /* Non NULL only */
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+void __real_free(void* p);
+
+void* __wrap_malloc(size_t size)
+{
+  allocCount++;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+  allocCount++;
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* p, size_t size)
+{
+  reallocCount++;
+  return __real_realloc(p, size);
+}
+
+void __wrap_free(void* p)
+{
+  if (p != NULL) {
+    freeCount++;
+  }
+  __real_free(p);
+}
+}
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef FakeReceiver_h
+#define FakeReceiver_h
+
+#include <Arduino.h>
+
+/* u-blox receiver at the other end of Serial : answers the CFG frames of the
+ * host and sends a NAV-PVT every navPeriod. Frames only get through when both
+ * ends use the same rate, anything else is garbage. Above maxBaud the link
+ * corrupts one byte in 64. */
+class FakeReceiver {
+public:
+  uint32_t baud;
+  uint32_t maxBaud;     /* Fastest rate the link holds */
+  uint16_t navPeriod;   /* [ms] */
+  uint32_t iTOW;        /* [ms] of the next NAV-PVT */
+  bool silent;          /* CFG frames are not answered */
+  int nakId;            /* CFG id answered with a NAK, -1 for none */
+  int ignore;           /* Next CFG frames lost, the host has to send them again */
+
+  FakeReceiver()
+  {
+    baud = 9600;
+    maxBaud = 2000000;
+    navPeriod = 200;
+    iTOW = 100000000;
+    silent = false;
+    nakId = -1;
+    ignore = 0;
+    _seen = 0;
+    _nextPVT = 0;
+    _seed = 1;
+    // Nothing left from a previous receiver
+    Serial.tx.clear();
+    Serial.txBaud.clear();
+  }
+
+  /* One millisecond of the receiver */
+  void step()
+  {
+    fakeMicros += 1000;
+    readHost();
+    if (millis() >= _nextPVT) {
+      uint8_t pvt[92] = {0};
+      memcpy(pvt, &iTOW, 4);
+      send(0x01, 0x07, pvt, sizeof(pvt));
+      iTOW += navPeriod;
+      _nextPVT = millis() + navPeriod;
+    }
+  }
+
+  /* Epochs the receiver computes but never sends */
+  void skip(int epochs)
+  {
+    iTOW += epochs * navPeriod;
+  }
+
+  void send(uint8_t cls, uint8_t id, const uint8_t* payload, int len)
+  {
+    uint8_t frame[8 + 256];
+    uint8_t a = 0;
+    uint8_t b = 0;
+
+    frame[0] = 0xB5;
+    frame[1] = 0x62;
+    frame[2] = cls;
+    frame[3] = id;
+    frame[4] = len & 0xFF;
+    frame[5] = len >> 8;
+    memcpy(frame + 6, payload, len);
+    for (int i = 2; i < 6 + len; i++) {
+      a += frame[i];
+      b += a;
+    }
+    frame[6 + len] = a;
+    frame[7 + len] = b;
+    if (Serial.baud != baud) {
+      for (int i = 0; i < 8 + len; i++) {
+        frame[i] = noise();
+      }
+    }
+    corrupt(frame, 8 + len);
+    Serial.receive(frame, 8 + len);
+  }
+
+private:
+  size_t _seen;
+  unsigned long _nextPVT;
+  uint32_t _seed;
+
+  /* Line errors of a rate the link does not hold, true if any */
+  bool corrupt(uint8_t* frame, int len)
+  {
+    bool corrupted = false;
+    if (baud <= maxBaud) {
+      return false;
+    }
+    for (int i = 0; i < len; i++) {
+      if (noise() % 64 == 0) {
+        frame[i] ^= noise() | 1;
+        corrupted = true;
+      }
+    }
+    return corrupted;
+  }
+
+  uint8_t noise()
+  {
+    // xorshift32
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return _seed;
+  }
+
+  void readHost()
+  {
+    const std::vector<uint8_t>& tx = Serial.tx;
+    while (_seen + 8 <= tx.size()) {
+      const uint8_t* frame = &tx[_seen];
+      int len = frame[4] | (frame[5] << 8);
+      if (frame[0] != 0xB5 || frame[1] != 0x62) {
+        _seen++;
+        continue;
+      }
+      if (_seen + 8 + len > tx.size()) {
+        return;
+      }
+      uint8_t copy[8 + 256];
+      memcpy(copy, frame, 8 + len);
+      bool ok = Serial.txBaud[_seen] == baud && !corrupt(copy, 8 + len);
+      _seen += 8 + len;
+      if (ok && frame[2] == 0x06) {
+        handleCfg(frame[3], frame + 6, len);
+      }
+    }
+  }
+
+  void handleCfg(uint8_t id, const uint8_t* payload, int len)
+  {
+    if (id == 0x00 && len == 0) {
+      // CFG-PRT poll
+      uint8_t prt[20] = {1};
+      memcpy(prt + 8, &baud, 4);
+      send(0x06, 0x00, prt, sizeof(prt));
+      return;
+    }
+    if (id == 0x00 && len == 20) {
+      // CFG-PRT : the answer would go out at the old rate, the host is gone
+      memcpy(&baud, payload + 8, 4);
+      return;
+    }
+    if (ignore > 0) {
+      ignore--;
+      return;
+    }
+    if (silent) {
+      return;
+    }
+    uint8_t ack[2] = {0x06, id};
+    bool ok = id != nakId;
+    if (ok && id == 0x08) {
+      navPeriod = payload[0] | (payload[1] << 8);
+    }
+    send(0x05, ok ? 0x01 : 0x00, ack, sizeof(ack));
+  }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include <Arduino.h>
+
+unsigned long fakeMicros = 0;
+int pinLevel[32];
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+HardwareSerial::HardwareSerial()
+{
+  baud = 0;
+  rxSize = 256;
+  _rxHead = 0;
+  _overrun = false;
+}
+
+void HardwareSerial::begin(unsigned long b)
+{
+  baud = b;
+  _rx.clear();
+  _rxHead = 0;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len)
+{
+  tx.insert(tx.end(), data, data + len);
+  txBaud.insert(txBaud.end(), len, baud);
+  return len;
+}
+
+int HardwareSerial::available()
+{
+  return _rx.size() - _rxHead;
+}
+
+int HardwareSerial::read()
+{
+  if (_rxHead == _rx.size()) {
+    return -1;
+  }
+  int b = _rx[_rxHead++];
+  if (_rxHead == _rx.size()) {
+    _rx.clear();
+    _rxHead = 0;
+  }
+  return b;
+}
+
+bool HardwareSerial::hasOverrun()
+{
+  bool overrun = _overrun;
+  _overrun = false;
+  return overrun;
+}
+
+void HardwareSerial::receive(const uint8_t* data, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    if ((size_t)available() >= rxSize) {
+      _overrun = true;
+      continue;
+    }
+    _rx.push_back(data[i]);
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+/* Host stand-ins for the parts of the ESP8266 core the libraries use. Time
+ * only moves when a test advances fakeMicros. */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "WString.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+/* Flash reads are plain reads on the host */
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+
+/* Hardware random number generator */
+#define RANDOM_REG32 ((uint32_t)rand())
+
+inline char* ultoa(unsigned long v, char* s, int radix)
+{
+  char tmp[33];
+  int n = 0;
+  do {
+    int d = v % radix;
+    tmp[n++] = d < 10 ? '0' + d : 'a' + d - 10;
+    v /= radix;
+  } while (v != 0);
+  for (int i = 0; i < n; i++) {
+    s[i] = tmp[n - 1 - i];
+  }
+  s[n] = 0;
+  return s;
+}
+
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+extern unsigned long fakeMicros;
+inline unsigned long micros() { return fakeMicros; }
+inline unsigned long millis() { return fakeMicros / 1000; }
+inline void delay(unsigned long ms) { fakeMicros += ms * 1000; }
+inline void yield() {}
+
+extern int pinLevel[32];
+inline void pinMode(int, int) {}
+inline void digitalWrite(int pin, int level) { pinLevel[pin] = level; }
+
+/* UART with a bounded RX buffer : bytes received while it is full are lost
+ * and flag an overrun, as on the chip */
+class HardwareSerial {
+public:
+  HardwareSerial();
+  void begin(unsigned long baud);
+  void swap() {}
+  void flush() {}
+  size_t write(const uint8_t* data, size_t len);
+  size_t write(uint8_t b) { return write(&b, 1); }
+  int available();
+  int read();
+  bool hasOverrun();
+  /* Debug output is dropped */
+  template <typename T>
+  size_t print(const T&) { return 0; }
+  template <typename T>
+  size_t println(const T&) { return 0; }
+  /* Test side */
+  unsigned long baud;
+  size_t rxSize;
+  std::vector<uint8_t> tx;
+  std::vector<unsigned long> txBaud; /* Rate each byte went out at */
+  void receive(const uint8_t* data, size_t len);
+private:
+  std::vector<uint8_t> _rx;
+  size_t _rxHead;
+  bool _overrun;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif
@@ -0,0 +1,4 @@
+#include <DNSServer.h>
+
+int DNSServer::pending = 0;
+int DNSServer::answered = 0;
@@ -0,0 +1,30 @@
+#ifndef DNSServer_h
+#define DNSServer_h
+
+#include <ESP8266WiFi.h>
+
+enum class DNSReplyCode { NoError = 0, ServerFailure = 2, NonExistentDomain = 3 };
+
+/* Captive DNS : queries are queued by the test, processNextRequest() answers
+ * one at most, as the core reads one packet per call */
+class DNSServer {
+public:
+  DNSServer() { _started = false; }
+  void setErrorReplyCode(const DNSReplyCode&) {}
+  bool start(const uint16_t&, const String&, const IPAddress&) { _started = true; return true; }
+  void stop() { _started = false; }
+  void processNextRequest()
+  {
+    if (_started && pending > 0) {
+      pending--;
+      answered++;
+    }
+  }
+  /* Test side */
+  static int pending;
+  static int answered;
+private:
+  bool _started;
+};
+
+#endif
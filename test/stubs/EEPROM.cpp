@@ -0,0 +1,33 @@
+#include <EEPROM.h>
+#include <algorithm>
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass()
+{
+  sector.assign(4096, 0xff);
+  commits = 0;
+  _dirty = false;
+}
+
+void EEPROMClass::begin(size_t size)
+{
+  _data.assign(sector.begin(), sector.begin() + size);
+  _dirty = false;
+}
+
+bool EEPROMClass::commit()
+{
+  if (_dirty) {
+    std::copy(_data.begin(), _data.end(), sector.begin());
+    commits++;
+    _dirty = false;
+  }
+  return true;
+}
+
+void EEPROMClass::end()
+{
+  commit();
+  _data.clear();
+}
@@ -0,0 +1,37 @@
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <Arduino.h>
+
+/* EEPROM emulated in a flash sector : begin() reads it in RAM, commit()
+ * erases and writes the sector back when something was put */
+class EEPROMClass {
+public:
+  EEPROMClass();
+  void begin(size_t size);
+  template <typename T>
+  T& get(int address, T& t)
+  {
+    memcpy(&t, _data.data() + address, sizeof(T));
+    return t;
+  }
+  template <typename T>
+  const T& put(int address, const T& t)
+  {
+    memcpy(_data.data() + address, &t, sizeof(T));
+    _dirty = true;
+    return t;
+  }
+  bool commit();
+  void end();
+  /* Test side : the sector is kept over reboots */
+  std::vector<uint8_t> sector;
+  int commits;
+private:
+  std::vector<uint8_t> _data;
+  bool _dirty;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,112 @@
+#include <ESP8266WebServer.h>
+
+ESP8266WebServer* ESP8266WebServer::instance = NULL;
+std::deque<ESP8266WebServer::Request_t> ESP8266WebServer::pending;
+std::vector<ESP8266WebServer::Response_t> ESP8266WebServer::responses;
+
+ESP8266WebServer::ESP8266WebServer(int port)
+{
+  _begun = false;
+  instance = this;
+}
+
+ESP8266WebServer::~ESP8266WebServer()
+{
+  if (instance == this) {
+    instance = NULL;
+  }
+}
+
+void ESP8266WebServer::on(const String& uri, THandlerFunction handler)
+{
+  _handlers.push_back(std::make_pair(uri, handler));
+}
+
+void ESP8266WebServer::handleClient()
+{
+  if (!_begun || pending.empty()) {
+    return;
+  }
+  _request = pending.front();
+  pending.pop_front();
+  _headers.clear();
+  Response_t response = { _request.uri, 0, "", "", "", 0 };
+  responses.push_back(response);
+
+  for (size_t i = 0; i < _handlers.size(); i++) {
+    if (_handlers[i].first == _request.uri) {
+      _handlers[i].second();
+      return;
+    }
+  }
+  if (_notFound) {
+    _notFound();
+  }
+}
+
+String ESP8266WebServer::arg(const String& name)
+{
+  for (size_t i = 0; i < _request.args.size(); i++) {
+    if (_request.args[i].first == name) {
+      return _request.args[i].second;
+    }
+  }
+  return String();
+}
+
+void ESP8266WebServer::sendHeader(const String& name, const String& value, bool first)
+{
+  std::string line = std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+  _headers = first ? line + _headers : _headers + line;
+}
+
+void ESP8266WebServer::send(int code, const char* type, const String& content)
+{
+  Response_t& r = responses.back();
+  r.code = code;
+  r.type = type;
+  r.headers = _headers;
+  r.body.append(content.c_str(), content.length());
+  r.sends++;
+}
+
+void ESP8266WebServer::send_P(int code, PGM_P type, PGM_P content, size_t len)
+{
+  Response_t& r = responses.back();
+  r.code = code;
+  r.type = type;
+  r.headers = _headers;
+  r.body.append(content, len);
+  r.sends++;
+}
+
+void ESP8266WebServer::sendContent(const String& content)
+{
+  sendContent_P(content.c_str(), content.length());
+}
+
+void ESP8266WebServer::sendContent_P(PGM_P content, size_t size)
+{
+  Response_t& r = responses.back();
+  r.body.append(content, size);
+  r.sends++;
+}
+
+/* uri?name=value&... */
+void ESP8266WebServer::request(const char* uri, const char* host)
+{
+  Request_t r;
+  std::string s(uri);
+  size_t q = s.find('?');
+  r.uri = s.substr(0, q).c_str();
+  r.host = host;
+  while (q != std::string::npos) {
+    size_t next = s.find('&', q + 1);
+    std::string pair = s.substr(q + 1, next == std::string::npos ? std::string::npos : next - q - 1);
+    size_t eq = pair.find('=');
+    r.args.push_back(std::make_pair(String(pair.substr(0, eq).c_str()),
+      String(eq == std::string::npos ? "" : pair.substr(eq + 1).c_str())));
+    q = next;
+  }
+  pending.push_back(r);
+}
@@ -0,0 +1,73 @@
+#ifndef ESP8266WebServer_h
+#define ESP8266WebServer_h
+
+#include <ESP8266WiFi.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+
+/* Web server fed by the test : requests are queued on the class, each
+ * handleClient() runs the handler of one at most, as the core serves one
+ * client per call. Responses are kept whole. */
+class ESP8266WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  typedef struct {
+    String uri;
+    String host;
+    std::vector<std::pair<String, String> > args;
+  } Request_t;
+
+  typedef struct {
+    String uri;
+    int code;
+    std::string type;
+    std::string headers;
+    std::string body;
+    size_t sends;             /* Writes to the client */
+  } Response_t;
+
+  ESP8266WebServer(int port);
+  ~ESP8266WebServer();
+  void begin() { _begun = true; }
+  void on(const String& uri, THandlerFunction handler);
+  void onNotFound(THandlerFunction handler) { _notFound = handler; }
+  void handleClient();
+
+  String uri() { return _request.uri; }
+  HTTPMethod method() { return HTTP_GET; }
+  String hostHeader() { return _request.host; }
+  String arg(const String& name);
+  String arg(int i) { return _request.args[i].second; }
+  String argName(int i) { return _request.args[i].first; }
+  int args() { return _request.args.size(); }
+  WiFiClient& client() { return _client; }
+
+  void sendHeader(const String& name, const String& value, bool first = false);
+  void setContentLength(size_t len) {}
+  void send(int code, const char* type, const String& content);
+  void send_P(int code, PGM_P type, PGM_P content, size_t len);
+  void sendContent(const String& content);
+  void sendContent_P(PGM_P content, size_t size);
+
+  /* Test side */
+  static ESP8266WebServer* instance;
+  static std::deque<Request_t> pending;
+  static std::vector<Response_t> responses;
+  static void request(const char* uri, const char* host = "192.168.4.1");
+private:
+  bool _begun;
+  std::vector<std::pair<String, THandlerFunction> > _handlers;
+  THandlerFunction _notFound;
+  Request_t _request;
+  std::string _headers;
+  WiFiClient _client;
+};
+
+#endif
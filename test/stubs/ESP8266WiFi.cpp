@@ -0,0 +1,224 @@
+#include <ESP8266WiFi.h>
+
+EspClass ESP;
+ESP8266WiFiClass WiFi;
+
+EspClass::EspClass()
+{
+  resets = 0;
+  boot(REASON_DEFAULT_RST);
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size)
+{
+  if (offset * 4 + size > sizeof(rtcMemory)) {
+    return false;
+  }
+  memcpy(data, (uint8_t*)rtcMemory + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size)
+{
+  if (offset * 4 + size > sizeof(rtcMemory)) {
+    return false;
+  }
+  memcpy((uint8_t*)rtcMemory + offset * 4, data, size);
+  return true;
+}
+
+void EspClass::boot(uint32_t reason)
+{
+  resetInfo.reason = reason;
+  if (reason == REASON_DEFAULT_RST) {
+    for (size_t i = 0; i < sizeof(rtcMemory) / 4; i++) {
+      rtcMemory[i] = rand();
+    }
+  }
+}
+
+ESP8266WiFiClass::ESP8266WiFiClass()
+{
+  scanMs = 2000;
+  associateMs = 300;
+  dhcpMs = 1000;
+  leaseIP = IPAddress(192, 168, 1, 42);
+  leaseGW = IPAddress(192, 168, 1, 1);
+  leaseSN = IPAddress(255, 255, 255, 0);
+  begins = 0;
+  scans = 0;
+  lookups = 0;
+  _mode = WIFI_STA;
+  _persistent = true;
+  _apIP = IPAddress(192, 168, 4, 1);
+  _static = false;
+  _scanStarted = false;
+  _scanDoneAt = 0;
+  boot();
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* pass, int32_t channel, const uint8_t* bssid)
+{
+  if (_persistent) {
+    _ssid = ssid;
+    _psk = pass != NULL ? pass : "";
+  }
+  begins++;
+  _locked = channel != 0 && bssid != NULL;
+  _ap = -1;
+  for (size_t i = 0; i < aps.size() && _ap < 0; i++) {
+    if (aps[i].ssid == ssid && (!_locked || (aps[i].channel == channel && memcmp(aps[i].bssid, bssid, 6) == 0))) {
+      _ap = i;
+    }
+  }
+  _connecting = true;
+  _connectAt = millis() + (_locked ? 0 : scanMs) + associateMs + (_static ? 0 : dhcpMs);
+  return status();
+}
+
+wl_status_t ESP8266WiFiClass::begin()
+{
+  String ssid = _ssid;
+  String psk = _psk;
+  return begin(ssid.c_str(), psk.c_str());
+}
+
+bool ESP8266WiFiClass::config(IPAddress ip, IPAddress gw, IPAddress sn)
+{
+  _static = ip != 0;
+  _ip = ip;
+  _gw = gw;
+  _sn = sn;
+  return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff)
+{
+  dropLink();
+  if (_persistent) {
+    _ssid = "";
+    _psk = "";
+  }
+  return true;
+}
+
+uint8_t ESP8266WiFiClass::waitForConnectResult()
+{
+  unsigned long start = millis();
+  while (status() == WL_DISCONNECTED && millis() - start < 10000) {
+    delay(100);
+  }
+  return status();
+}
+
+wl_status_t ESP8266WiFiClass::status()
+{
+  if (!_connecting) {
+    return WL_DISCONNECTED;
+  }
+  if (_ap < 0) {
+    // A locked station keeps looking for its BSSID
+    return !_locked && millis() >= _connectAt ? WL_NO_SSID_AVAIL : WL_DISCONNECTED;
+  }
+  return millis() >= _connectAt ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+uint8_t* ESP8266WiFiClass::BSSID()
+{
+  static uint8_t none[6];
+  return status() == WL_CONNECTED ? aps[_ap].bssid : none;
+}
+
+int32_t ESP8266WiFiClass::channel()
+{
+  return status() == WL_CONNECTED ? aps[_ap].channel : 0;
+}
+
+IPAddress ESP8266WiFiClass::localIP()
+{
+  if (status() != WL_CONNECTED) {
+    return IPAddress();
+  }
+  return _static ? _ip : leaseIP;
+}
+
+IPAddress ESP8266WiFiClass::gatewayIP()
+{
+  if (status() != WL_CONNECTED) {
+    return IPAddress();
+  }
+  return _static ? _gw : leaseGW;
+}
+
+IPAddress ESP8266WiFiClass::subnetMask()
+{
+  if (status() != WL_CONNECTED) {
+    return IPAddress();
+  }
+  return _static ? _sn : leaseSN;
+}
+
+int ESP8266WiFiClass::hostByName(const char* host, IPAddress& result)
+{
+  lookups++;
+  if (result.fromString(host)) {
+    return 1;
+  }
+  for (size_t i = 0; i < hosts.size(); i++) {
+    if (hosts[i].first == host) {
+      result = hosts[i].second;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int ESP8266WiFiClass::scanNetworks(bool async)
+{
+  scans++;
+  _scanStarted = true;
+  _scanDoneAt = millis() + scanMs;
+  if (async) {
+    return WIFI_SCAN_RUNNING;
+  }
+  delay(scanMs);
+  return aps.size();
+}
+
+int ESP8266WiFiClass::scanComplete()
+{
+  if (!_scanStarted) {
+    return WIFI_SCAN_FAILED;
+  }
+  return millis() < _scanDoneAt ? WIFI_SCAN_RUNNING : (int)aps.size();
+}
+
+void ESP8266WiFiClass::scanDelete()
+{
+  _scanStarted = false;
+}
+
+void ESP8266WiFiClass::dropLink()
+{
+  _connecting = false;
+}
+
+void ESP8266WiFiClass::boot()
+{
+  dropLink();
+  _static = false;
+  _scanStarted = false;
+  _persistent = true;
+}
+
+extern "C" bool wifi_station_disconnect(void)
+{
+  WiFi.dropLink();
+  return true;
+}
+
+extern "C" bool wifi_station_dhcpc_start(void)
+{
+  WiFi.dhcp();
+  return true;
+}
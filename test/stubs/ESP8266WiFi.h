@@ -0,0 +1,138 @@
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include <Arduino.h>
+#include <utility>
+#include <vector>
+#include "IPAddress.h"
+#include "user_interface.h"
+
+enum wl_status_t {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+};
+
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+
+enum { ENC_TYPE_TKIP = 2, ENC_TYPE_CCMP = 4, ENC_TYPE_WEP = 5, ENC_TYPE_NONE = 7, ENC_TYPE_AUTO = 8 };
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+/* Chip services : RTC user memory keeps its content over a deep sleep only,
+ * boot() sets the reset reason and scrambles it on a power on */
+class EspClass {
+public:
+  EspClass();
+  uint32_t getChipId() { return 0x00c0ffee; }
+  uint32_t getFlashChipId() { return 0x001440c8; }
+  uint32_t getFlashChipSize() { return 512 * 1024; }
+  uint32_t getFlashChipRealSize() { return 1024 * 1024; }
+  void reset() { resets++; }
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+  struct rst_info* getResetInfoPtr() { return &resetInfo; }
+  /* Test side */
+  struct rst_info resetInfo;
+  uint32_t rtcMemory[128];
+  int resets;
+  void boot(uint32_t reason);
+};
+
+extern EspClass ESP;
+
+/* Station and soft-AP over a simulated radio : a connection is up after a
+ * scan of every channel (skipped when begin() is given the channel and
+ * BSSID), the association and a DHCP exchange (skipped with a static
+ * config). Scan results come from aps, indexes are int instead of the
+ * uint8_t of the core so that hundreds of them can be fed. */
+class ESP8266WiFiClass {
+public:
+  typedef struct {
+    String ssid;
+    uint8_t bssid[6];
+    int32_t channel;
+    int32_t rssi;
+    uint8_t encryption;
+  } AccessPoint_t;
+
+  ESP8266WiFiClass();
+  bool mode(WiFiMode_t m) { _mode = m; return true; }
+  void persistent(bool persistent) { _persistent = persistent; }
+  bool softAPConfig(IPAddress ip, IPAddress gw, IPAddress sn) { _apIP = ip; return true; }
+  bool softAP(const char* ssid, const char* pass = NULL) { apSSID = ssid; return true; }
+  IPAddress softAPIP() { return _apIP; }
+  String softAPmacAddress() { return String("1a:fe:34:c0:ff:ee"); }
+  String macAddress() { return String("18:fe:34:c0:ff:ee"); }
+
+  wl_status_t begin(const char* ssid, const char* pass = NULL, int32_t channel = 0, const uint8_t* bssid = NULL);
+  wl_status_t begin();
+  bool config(IPAddress ip, IPAddress gw, IPAddress sn);
+  bool disconnect(bool wifiOff = false);
+  uint8_t waitForConnectResult();
+  wl_status_t status();
+  String SSID() const { return _ssid; }
+  String psk() const { return _psk; }
+  uint8_t* BSSID();
+  int32_t channel();
+  IPAddress localIP();
+  IPAddress gatewayIP();
+  IPAddress subnetMask();
+  bool beginWPSConfig() { return false; }
+  int hostByName(const char* host, IPAddress& result);
+
+  int scanNetworks(bool async = false);
+  int scanComplete();
+  void scanDelete();
+  String SSID(int i) { return aps[i].ssid; }
+  int32_t RSSI(int i) { return aps[i].rssi; }
+  uint8_t encryptionType(int i) { return aps[i].encryption; }
+
+  /* Test side */
+  std::vector<AccessPoint_t> aps;
+  unsigned long scanMs;       /* Every channel */
+  unsigned long associateMs;  /* Authentication, association and key exchange */
+  unsigned long dhcpMs;
+  IPAddress leaseIP;          /* What DHCP hands out */
+  IPAddress leaseGW;
+  IPAddress leaseSN;
+  String apSSID;
+  int begins;
+  int scans;
+  std::vector<std::pair<String, IPAddress> > hosts; /* What the DNS knows */
+  int lookups;
+  void dropLink();            /* Station disconnected */
+  void dhcp() { _static = false; }
+  void boot();                /* Saved credentials kept, the rest is lost */
+private:
+  WiFiMode_t _mode;
+  bool _persistent;
+  IPAddress _apIP;
+  String _ssid;
+  String _psk;
+  bool _static;
+  IPAddress _ip;
+  IPAddress _gw;
+  IPAddress _sn;
+  bool _connecting;
+  int _ap;                    /* Index in aps, -1 when none matches */
+  bool _locked;               /* Channel and BSSID given */
+  unsigned long _connectAt;   /* [ms] */
+  bool _scanStarted;
+  unsigned long _scanDoneAt;  /* [ms] */
+};
+
+extern ESP8266WiFiClass WiFi;
+
+class WiFiClient {
+public:
+  IPAddress localIP() { return WiFi.softAPIP(); }
+  void stop() {}
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include "WString.h"
+
+/* IPv4 address, first octet in the low byte as on the chip */
+class IPAddress {
+public:
+  IPAddress() : _address(0) {}
+  IPAddress(uint32_t address) : _address(address) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    : _address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+  operator uint32_t() const { return _address; }
+  String toString() const
+  {
+    char s[16];
+    snprintf(s, sizeof(s), "%u.%u.%u.%u", _address & 0xff, (_address >> 8) & 0xff,
+      (_address >> 16) & 0xff, _address >> 24);
+    return String(s);
+  }
+  bool fromString(const char* s)
+  {
+    unsigned int a, b, c, d;
+    if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+      return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+private:
+  uint32_t _address;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include <Ticker.h>
+
+Ticker* Ticker::_tickers[MAX_TICKERS];
+
+Ticker::Ticker()
+{
+  _period = 0;
+  _elapsed = 0;
+  _callback = 0;
+  _arg = 0;
+  for (int i = 0; i < MAX_TICKERS; i++) {
+    if (_tickers[i] == 0) {
+      _tickers[i] = this;
+      break;
+    }
+  }
+}
+
+Ticker::~Ticker()
+{
+  for (int i = 0; i < MAX_TICKERS; i++) {
+    if (_tickers[i] == this) {
+      _tickers[i] = 0;
+    }
+  }
+}
+
+void Ticker::advance(uint32_t ms)
+{
+  for (uint32_t t = 0; t < ms; t++) {
+    for (int i = 0; i < MAX_TICKERS; i++) {
+      Ticker* ticker = _tickers[i];
+      if (ticker != 0 && ticker->_callback != 0 && ++ticker->_elapsed >= ticker->_period) {
+        ticker->_elapsed = 0;
+        ticker->_callback(ticker->_arg);
+      }
+    }
+  }
+}
@@ -0,0 +1,31 @@
+#ifndef Ticker_h
+#define Ticker_h
+
+#include <stdint.h>
+
+/* Timer driven by the test : advance() fires the attached callbacks as the
+ * hardware timer would over that much time */
+class Ticker {
+public:
+  Ticker();
+  ~Ticker();
+  template <typename T>
+  void attach_ms(uint32_t ms, void (*callback)(T), T arg)
+  {
+    _period = ms;
+    _elapsed = 0;
+    _callback = (void (*)(void*))callback;
+    _arg = (void*)arg;
+  }
+  void detach() { _callback = 0; }
+  static void advance(uint32_t ms);
+private:
+  static const int MAX_TICKERS = 8;
+  static Ticker* _tickers[MAX_TICKERS];
+  uint32_t _period;
+  uint32_t _elapsed;
+  void (*_callback)(void*);
+  void* _arg;
+};
+
+#endif
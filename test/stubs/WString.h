@@ -0,0 +1,50 @@
+#ifndef WString_h
+#define WString_h
+
+#include <string.h>
+#include <string>
+
+/* The part of the Arduino String the libraries use, over std::string */
+class String {
+public:
+  String() {}
+  String(const char* s) : _s(s != NULL ? s : "") {}
+  String(char c) : _s(1, c) {}
+  String(int v) : _s(std::to_string(v)) {}
+  String(unsigned int v) : _s(std::to_string(v)) {}
+  String(long v) : _s(std::to_string(v)) {}
+  String(unsigned long v) : _s(std::to_string(v)) {}
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return _s.length(); }
+  char charAt(unsigned int i) const { return i < _s.length() ? _s[i] : 0; }
+  void toCharArray(char* buf, unsigned int size) const
+  {
+    if (size == 0) {
+      return;
+    }
+    size_t n = _s.length() < size - 1 ? _s.length() : size - 1;
+    memcpy(buf, _s.data(), n);
+    buf[n] = 0;
+  }
+  /* As on the core, a String that holds a buffer is true */
+  explicit operator bool() const { return true; }
+
+  String& operator+=(const String& s) { _s += s._s; return *this; }
+  String& operator+=(const char* s) { _s += s; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  String& operator+=(int v) { _s += std::to_string(v); return *this; }
+  String& operator+=(unsigned int v) { _s += std::to_string(v); return *this; }
+
+  friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+  friend String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+  bool operator==(const String& s) const { return _s == s._s; }
+  bool operator==(const char* s) const { return _s == s; }
+  bool operator!=(const String& s) const { return _s != s._s; }
+  bool operator!=(const char* s) const { return _s != s; }
+private:
+  std::string _s;
+};
+
+#endif
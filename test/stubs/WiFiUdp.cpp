@@ -0,0 +1,30 @@
+#include <WiFiUdp.h>
+
+bool WiFiUDP::record = true;
+std::vector<WiFiUDP::Datagram_t> WiFiUDP::sent;
+size_t WiFiUDP::packets = 0;
+size_t WiFiUDP::bytes = 0;
+
+int WiFiUDP::beginPacket(IPAddress address, uint16_t port)
+{
+  _packet.address = address;
+  _packet.port = port;
+  _packet.data.clear();
+  return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* data, size_t len)
+{
+  _packet.data.insert(_packet.data.end(), data, data + len);
+  return len;
+}
+
+int WiFiUDP::endPacket()
+{
+  packets++;
+  bytes += _packet.data.size();
+  if (record) {
+    sent.push_back(_packet);
+  }
+  return 1;
+}
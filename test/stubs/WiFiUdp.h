@@ -0,0 +1,29 @@
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include <ESP8266WiFi.h>
+
+/* UDP socket : every endPacket() is counted, and kept for the test while
+ * record is set */
+class WiFiUDP {
+public:
+  typedef struct {
+    IPAddress address;
+    uint16_t port;
+    std::vector<uint8_t> data;
+  } Datagram_t;
+
+  uint8_t begin(uint16_t port) { return 1; }
+  int beginPacket(IPAddress address, uint16_t port);
+  size_t write(const uint8_t* data, size_t len);
+  int endPacket();
+  /* Test side */
+  static bool record;
+  static std::vector<Datagram_t> sent;
+  static size_t packets;
+  static size_t bytes;
+private:
+  Datagram_t _packet;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef user_interface_h
+#define user_interface_h
+
+#include <stdint.h>
+
+/* SDK calls of the station, see ESP8266WiFi.h for the simulated one */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info {
+  uint32_t reason;
+};
+
+bool wifi_station_disconnect(void);
+bool wifi_station_dhcpc_start(void);
+
+#define ETS_UART_INTR_DISABLE()
+#define ETS_UART_INTR_ENABLE()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef test_h
+#define test_h
+
+#include <stdio.h>
+#include <time.h>
+
+/* Minimal checks for the host tests : a failed CHECK is printed and makes
+ * TEST_END() return non zero */
+static int testFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      testFailures++; \
+    } \
+  } while (0)
+
+/* [s] monotonic, for the figures the benchmarks print */
+static inline double testSeconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Tests built several ways name the build, see POMP_BUILD in the Makefile */
+#ifdef TEST_VARIANT
+#define TEST_NAME __FILE__ " (" TEST_VARIANT ")"
+#else
+#define TEST_NAME __FILE__
+#endif
+
+#define TEST_END() (printf("%s: %s\n", TEST_NAME, testFailures ? "FAILED" : "ok"), testFailures != 0)
+
+#endif
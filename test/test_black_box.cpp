@@ -0,0 +1,225 @@
+#include <BlackBox.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "test.h"
+
+static const char* IMAGE = "build/test_black_box.bin";
+static const uint32_t IMAGE_SIZE = 16 * BlackBoxStorage::SECTOR_SIZE;
+/* SPIFFS area of eagle.flash.512k128.ld, see platformio.ini */
+static const uint32_t REGION_SIZE = 128 * 1024;
+static const int NAV_RATE = 25; /* [Hz] */
+static const int PVT_SIZE = 92;
+static const uint32_t SLOW_PERIOD = 1000000; /* [us] BLACKBOX_SLOW_PERIOD of main.cpp */
+static const uint32_t ERASE_CYCLES = 100000; /* Flash endurance per sector */
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+/* Flash losing power : after tearAfter more writes, one write stops part way
+ * and nothing reaches the flash anymore */
+class TornStorage : public FileStorage {
+public:
+  int tearAfter;
+  bool dead;
+
+  TornStorage() : tearAfter(-1), dead(false) {}
+  bool write(uint32_t address, const void* data, uint32_t len)
+  {
+    if (dead) {
+      return true;
+    }
+    if (tearAfter == 0) {
+      uint32_t written = random32() % (len / 4) * 4;
+      dead = true;
+      return written == 0 || FileStorage::write(address, data, written);
+    }
+    if (tearAfter > 0) {
+      tearAfter--;
+    }
+    return FileStorage::write(address, data, len);
+  }
+  bool erase(uint32_t sector)
+  {
+    return dead || FileStorage::erase(sector);
+  }
+};
+
+/* Flash in RAM, counting the erases of each sector */
+class CountingStorage : public BlackBoxStorage {
+public:
+  std::vector<uint8_t> flash;
+  std::vector<uint32_t> erases;
+
+  CountingStorage(uint32_t size) : flash(size, 0xFF), erases(size / SECTOR_SIZE, 0) {}
+  uint32_t size() { return flash.size(); }
+  bool read(uint32_t address, void* data, uint32_t len)
+  {
+    if (address + len > flash.size()) {
+      return false;
+    }
+    memcpy(data, &flash[address], len);
+    return true;
+  }
+  bool write(uint32_t address, const void* data, uint32_t len)
+  {
+    if (address + len > flash.size()) {
+      return false;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+      flash[address + i] &= ((const uint8_t*)data)[i];
+    }
+    return true;
+  }
+  bool erase(uint32_t sector)
+  {
+    if (sector >= erases.size()) {
+      return false;
+    }
+    memset(&flash[sector * SECTOR_SIZE], 0xFF, SECTOR_SIZE);
+    erases[sector]++;
+    return true;
+  }
+};
+
+/* seconds of 25 Hz PVT and baro records logged with the given decimation :
+ * how far back the log goes, and how often each sector gets erased */
+static void retention(uint32_t decimation, int seconds, double minRetained)
+{
+  CountingStorage storage(REGION_SIZE);
+  BlackBox blackBox(storage);
+  uint8_t pvt[PVT_SIZE];
+  uint64_t start = 1000000000000ULL;
+
+  CHECK(blackBox.init());
+  blackBox.setDecimation(decimation);
+  memset(pvt, 0x5A, sizeof(pvt));
+  for (int n = 0; n < seconds * NAV_RATE; n++) {
+    uint64_t time = start + (uint64_t)n * 1000000 / NAV_RATE;
+    CHECK(blackBox.appendPVT(time, pvt, sizeof(pvt)));
+    CHECK(blackBox.appendBaro(time, 101325));
+    // The loop runs several times per epoch
+    for (int i = 0; i < 4; i++) {
+      blackBox.process();
+    }
+  }
+  blackBox.flush();
+  CHECK(blackBox.getDropped() == 0);
+
+  BlackBoxReader reader(storage);
+  BlackBoxRecord_t record;
+  uint64_t first = 0;
+  uint64_t last = 0;
+  uint64_t previous = 0;
+  uint32_t epochs = 0;
+  CHECK(reader.begin());
+  while (reader.next(&record)) {
+    if (record.type != BLACKBOX_PVT) {
+      continue;
+    }
+    uint64_t time;
+    memcpy(&time, record.data, sizeof(time));
+    first = epochs == 0 ? time : first;
+    CHECK(epochs == 0 || time - previous >= decimation);
+    previous = time;
+    last = time;
+    epochs++;
+  }
+  double retained = (last - first) / 1e6;
+  CHECK(decimation > 0 || last == start + (uint64_t)(seconds * NAV_RATE - 1) * 1000000 / NAV_RATE);
+  CHECK(retained >= minRetained);
+
+  // Sectors worn evenly, every one once per turn of the ring
+  uint32_t most = 0;
+  uint32_t least = UINT32_MAX;
+  for (size_t i = 0; i < storage.erases.size(); i++) {
+    most = storage.erases[i] > most ? storage.erases[i] : most;
+    least = storage.erases[i] < least ? storage.erases[i] : least;
+  }
+  CHECK(most - least <= 1);
+  double erasePeriod = (double)seconds / most;
+  printf("%2.0f Hz : %u epochs kept, %.1f s back, each sector erased every %.0f s, %u cycles in %.0f days\n",
+    decimation ? 1e6 / decimation : NAV_RATE, epochs, retained, erasePeriod, ERASE_CYCLES,
+    erasePeriod * ERASE_CYCLES / 86400);
+}
+
+/* Power lost at random points : after each restart every record read is
+ * intact and in order, flushed ones are there */
+static void powerLoss()
+{
+  uint32_t counter = 0;
+
+  // Records numbered by a counter
+  remove(IMAGE);
+  for (int run = 0; run < 200; run++) {
+    TornStorage storage;
+    CHECK(storage.open(IMAGE, IMAGE_SIZE));
+    BlackBox blackBox(storage);
+    CHECK(blackBox.init());
+
+    if (random32() % 2) {
+      storage.tearAfter = random32() % 20;
+    }
+    int records = random32() % 3000;
+    for (int i = 0; i < records; i++) {
+      uint8_t data[100];
+      uint8_t len = 4 + random32() % 96;
+      memset(data, counter & 0xFF, len);
+      memcpy(data, &counter, 4);
+      if (blackBox.append(BLACKBOX_PVT, data, len)) {
+        counter++;
+      }
+      if (random32() % 3 == 0) {
+        blackBox.process();
+      }
+    }
+    uint32_t flushed = 0;
+    if (random32() % 4 == 0 && storage.tearAfter == -1) {
+      blackBox.flush();
+      flushed = counter;
+    }
+    storage.close();
+
+    FileStorage image;
+    CHECK(image.open(IMAGE, IMAGE_SIZE));
+    BlackBoxReader reader(image);
+    BlackBoxRecord_t record;
+    long previous = -1;
+    CHECK(reader.begin());
+    while (reader.next(&record)) {
+      if (record.type == BLACKBOX_SESSION) {
+        continue;
+      }
+      uint32_t value;
+      memcpy(&value, record.data, 4);
+      for (int k = 4; k < record.len; k++) {
+        if (record.data[k] != (value & 0xFF)) {
+          CHECK(record.data[k] == (value & 0xFF));
+          break;
+        }
+      }
+      CHECK((long)value > previous);
+      previous = value;
+    }
+    CHECK(flushed == 0 || previous + 1 == (long)flushed);
+  }
+  remove(IMAGE);
+}
+
+int main()
+{
+  powerLoss();
+  // Epochs of half a page in 30 to 31 of the 32 sectors, the rest is kept
+  // erased ahead : 960 epochs at least
+  retention(0, 3600, 959 / (double)NAV_RATE);
+  // Parked or the ground gets the stream
+  retention(SLOW_PERIOD, 6 * 3600, 959);
+  return TEST_END();
+}
@@ -0,0 +1,283 @@
+#include <BlackBox.h>
+#include <BlackBoxExport.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "test.h"
+
+static const char* IMAGE = "build/test_black_box_export.bin";
+static const uint32_t IMAGE_SIZE = 1024 * 1024;
+static const int PVT_SIZE = 92;
+static const uint32_t CHUNK = 1024; /* As read from flash by BlackBoxServer */
+static const uint32_t RESUME_AT = 300000;
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static void range(const char* header, uint32_t size, BlackBoxRange_t expected, uint32_t first = 0, uint32_t last = 0)
+{
+  uint32_t f = 0xdead;
+  uint32_t l = 0xbeef;
+  BlackBoxRange_t res = blackBoxParseRange(header, size, &f, &l);
+  CHECK(res == expected);
+  if (res == expected && expected == BLACKBOX_RANGE_OK && (f != first || l != last)) {
+    printf("%s of %u : %u-%u instead of %u-%u\n", header, size, f, l, first, last);
+    CHECK(f == first && l == last);
+  }
+}
+
+static void ranges()
+{
+  range(NULL, 1000, BLACKBOX_RANGE_NONE);
+  range("items=0-10", 1000, BLACKBOX_RANGE_NONE);
+  range("bytes=0-99", 1000, BLACKBOX_RANGE_OK, 0, 99);
+  range("bytes=300-", 1000, BLACKBOX_RANGE_OK, 300, 999);
+  range("bytes=990-2000", 1000, BLACKBOX_RANGE_OK, 990, 999);
+  range("bytes=999-999", 1000, BLACKBOX_RANGE_OK, 999, 999);
+  range("bytes=1000-", 1000, BLACKBOX_RANGE_UNSATISFIABLE);
+  range("bytes=1000-1010", 1000, BLACKBOX_RANGE_UNSATISFIABLE);
+  // Suffix, longer than the resource : all of it
+  range("bytes=-100", 1000, BLACKBOX_RANGE_OK, 900, 999);
+  range("bytes=-5000", 1000, BLACKBOX_RANGE_OK, 0, 999);
+  range("bytes=-0", 1000, BLACKBOX_RANGE_UNSATISFIABLE);
+  range("bytes=-5", 0, BLACKBOX_RANGE_UNSATISFIABLE);
+  // Invalid ones are ignored : the whole log is sent
+  range("bytes=5-3", 1000, BLACKBOX_RANGE_NONE);
+  range("bytes=", 1000, BLACKBOX_RANGE_NONE);
+  range("bytes=-", 1000, BLACKBOX_RANGE_NONE);
+  range("bytes=abc-", 1000, BLACKBOX_RANGE_NONE);
+  range("bytes=10-20x", 1000, BLACKBOX_RANGE_NONE);
+  // Multi-range is not supported
+  range("bytes=0-9,20-29", 1000, BLACKBOX_RANGE_NONE);
+  range("bytes=-10,-20", 1000, BLACKBOX_RANGE_NONE);
+}
+
+static std::string readCsv(BlackBoxStorage& storage, size_t chunk)
+{
+  std::string csv;
+  std::vector<char> buffer(chunk);
+  BlackBoxReader reader(storage);
+  BlackBoxCsv export_(reader);
+  size_t len;
+
+  export_.begin();
+  while ((len = export_.read(buffer.data(), chunk)) > 0) {
+    csv.append(buffer.data(), len);
+  }
+  return csv;
+}
+
+/* Every record type, known or not, on lines of the header's column count */
+static void columns()
+{
+  FileStorage storage;
+  remove(IMAGE);
+  CHECK(storage.open(IMAGE, 16 * BlackBoxStorage::SECTOR_SIZE));
+  BlackBox blackBox(storage);
+  uint8_t pvt[PVT_SIZE];
+  for (int i = 0; i < PVT_SIZE; i++) {
+    pvt[i] = i * 37;
+  }
+  CHECK(blackBox.init());
+  CHECK(blackBox.appendPVT(1234567, pvt, sizeof(pvt)));
+  CHECK(blackBox.appendBaro(1234568, -101325));
+  CHECK(blackBox.appendPVT(1234569, pvt, 20));       /* Too short to be read */
+  CHECK(blackBox.append(BLACKBOX_BARO, pvt, 3));     /* Wrong size */
+  CHECK(blackBox.append(42, pvt, 10));               /* Type of a later firmware */
+  CHECK(blackBox.append(43, NULL, 0));
+  blackBox.flush();
+
+  // Whatever the chunk size
+  std::string csv = readCsv(storage, 1);
+  CHECK(csv == readCsv(storage, 7) && csv == readCsv(storage, 4096));
+
+  size_t lines = 0;
+  size_t columns = 0;
+  for (size_t start = 0; start < csv.size(); ) {
+    size_t end = csv.find('\n', start);
+    CHECK(end != std::string::npos);
+    std::string line = csv.substr(start, end - start);
+    size_t commas = 0;
+    for (size_t i = 0; i < line.size(); i++) {
+      commas += line[i] == ',';
+    }
+    columns = lines == 0 ? commas : columns;
+    if (commas != columns) {
+      printf("%zu columns instead of %zu : %s\n", commas + 1, columns + 1, line.c_str());
+    }
+    CHECK(commas == columns);
+    lines++;
+    start = end + 1;
+  }
+  CHECK(lines == 8);
+  CHECK(columns == 11);
+  CHECK(csv.find(",session,") != std::string::npos);
+  CHECK(csv.find(",pvt,1234567,") != std::string::npos);
+  CHECK(csv.find(",baro,1234568,,,,,,,,,-101325\n") != std::string::npos);
+  CHECK(csv.find(",42,") != std::string::npos && csv.find(",43,") != std::string::npos);
+  storage.close();
+  remove(IMAGE);
+}
+
+/* The flat image as /log.bin serves it, bytes first to last */
+static void slice(BlackBoxReader& reader, uint32_t first, uint32_t last, std::vector<uint8_t>& out)
+{
+  uint8_t page[BlackBoxStorage::PAGE_SIZE];
+  uint32_t offset = first;
+
+  while (offset <= last) {
+    uint32_t index = offset / BlackBoxStorage::PAGE_SIZE;
+    uint32_t at = offset % BlackBoxStorage::PAGE_SIZE;
+    uint32_t len = BlackBoxStorage::PAGE_SIZE - at;
+    len = len > CHUNK ? CHUNK : len;
+    len = len > last - offset + 1 ? last - offset + 1 : len;
+    CHECK(reader.readPage(index, page));
+    out.insert(out.end(), page + at, page + at + len);
+    offset += len;
+  }
+}
+
+/* A download back into flash, each page in its ring slot as bbx_dump -d sees it */
+class FlatStorage : public BlackBoxStorage {
+public:
+  std::vector<uint8_t> flash;
+
+  FlatStorage(const std::vector<uint8_t>& image, uint32_t firstPage)
+  {
+    uint32_t pages = image.size() / PAGE_SIZE;
+    uint32_t perSector = SECTOR_SIZE / PAGE_SIZE;
+    uint32_t count = (pages + perSector - 1) / perSector * perSector;
+    flash.assign(count * PAGE_SIZE, 0xFF);
+    for (uint32_t i = 0; i < pages; i++) {
+      memcpy(&flash[(firstPage + i) % count * PAGE_SIZE], &image[i * PAGE_SIZE], PAGE_SIZE);
+    }
+  }
+  uint32_t size() { return flash.size(); }
+  bool read(uint32_t address, void* data, uint32_t len)
+  {
+    memcpy(data, &flash[address], len);
+    return true;
+  }
+  bool write(uint32_t, const void*, uint32_t) { return false; }
+  bool erase(uint32_t) { return false; }
+};
+
+/* 1 MB flash image that has wrapped, downloaded in two parts : the resume
+ * gives back the image, and its CSV is the one of /log.csv */
+static void resume()
+{
+  remove(IMAGE);
+  {
+    FileStorage storage;
+    CHECK(storage.open(IMAGE, IMAGE_SIZE));
+    BlackBox blackBox(storage);
+    uint8_t pvt[PVT_SIZE];
+    CHECK(blackBox.init());
+    // 1.5 turns of the ring
+    for (uint32_t n = 0; n < IMAGE_SIZE / 122 * 3 / 2; n++) {
+      uint64_t time = 1000000000000ULL + (uint64_t)n * 40000;
+      for (int i = 0; i < PVT_SIZE; i++) {
+        pvt[i] = random32();
+      }
+      CHECK(blackBox.appendPVT(time, pvt, sizeof(pvt)));
+      CHECK(blackBox.appendBaro(time, 100000 + n % 1000));
+      blackBox.process();
+    }
+    blackBox.flush();
+    CHECK(blackBox.getDropped() == 0);
+  }
+
+  // What the server reads, without touching the image
+  FileStorage image;
+  CHECK(image.open(IMAGE, IMAGE_SIZE, true));
+  BlackBoxReader reader(image);
+  CHECK(reader.begin());
+  CHECK(reader.getFirstPage() > 0);
+  uint32_t size = reader.getPageCount() * BlackBoxStorage::PAGE_SIZE;
+  uint32_t etag = reader.getFirstPage();
+
+  std::vector<uint8_t> whole;
+  double start = testSeconds();
+  slice(reader, 0, size - 1, whole);
+  double binarySeconds = testSeconds() - start;
+
+  uint32_t first;
+  uint32_t last;
+  std::vector<uint8_t> download;
+  char header[32];
+  snprintf(header, sizeof(header), "bytes=0-%u", RESUME_AT);
+  CHECK(blackBoxParseRange(header, size, &first, &last) == BLACKBOX_RANGE_OK);
+  slice(reader, first, last, download);
+  snprintf(header, sizeof(header), "bytes=%zu-", download.size());
+  CHECK(blackBoxParseRange(header, size, &first, &last) == BLACKBOX_RANGE_OK && first == RESUME_AT + 1);
+  // If-Range : the log has not wrapped in between
+  CHECK(reader.begin() && reader.getFirstPage() == etag);
+  slice(reader, first, last, download);
+  CHECK(download == whole);
+
+  start = testSeconds();
+  std::string csv = readCsv(image, CHUNK);
+  double csvSeconds = testSeconds() - start;
+  FlatStorage downloaded(download, etag);
+  CHECK(readCsv(downloaded, CHUNK) == csv);
+
+  // Opened read only, the image is left as it was
+  CHECK(!image.write(0, whole.data(), BlackBoxStorage::PAGE_SIZE) && !image.erase(0));
+  image.close();
+  FILE* file = fopen(IMAGE, "rb");
+  fseek(file, 0, SEEK_END);
+  CHECK(ftell(file) == (long)IMAGE_SIZE);
+  fclose(file);
+
+  printf("1 MB image, %u pages from %u : /log.bin %.0f MB/s, /log.csv %.0f MB/s (%zu bytes)\n",
+    reader.getPageCount(), etag, size / binarySeconds / 1e6, csv.size() / csvSeconds / 1e6, csv.size());
+  remove(IMAGE);
+}
+
+/* bbx_dump on an image shorter than the size given : read as erased past
+ * the end, the file is not grown */
+static void readOnlyShort()
+{
+  remove(IMAGE);
+  {
+    FileStorage storage;
+    CHECK(storage.open(IMAGE, 4 * BlackBoxStorage::SECTOR_SIZE));
+    BlackBox blackBox(storage);
+    CHECK(blackBox.init());
+    CHECK(blackBox.appendBaro(1, 2));
+    blackBox.flush();
+  }
+  FileStorage image;
+  uint8_t page[BlackBoxStorage::PAGE_SIZE];
+  CHECK(image.open(IMAGE, 16 * BlackBoxStorage::SECTOR_SIZE, true));
+  CHECK(image.read(8 * BlackBoxStorage::SECTOR_SIZE, page, sizeof(page)));
+  CHECK(page[0] == 0xFF && page[sizeof(page) - 1] == 0xFF);
+  CHECK(readCsv(image, CHUNK).find(",baro,1,") != std::string::npos);
+  image.close();
+  FILE* file = fopen(IMAGE, "rb");
+  fseek(file, 0, SEEK_END);
+  CHECK(ftell(file) == (long)(4 * BlackBoxStorage::SECTOR_SIZE));
+  fclose(file);
+
+  // Missing : not created
+  remove(IMAGE);
+  CHECK(!image.open(IMAGE, IMAGE_SIZE, true));
+  CHECK(fopen(IMAGE, "rb") == NULL);
+}
+
+int main()
+{
+  ranges();
+  columns();
+  resume();
+  readOnlyShort();
+  return TEST_END();
+}
@@ -0,0 +1,170 @@
+#include <MessagesManager.h>
+#include <Profiler.h>
+#include <Types.h>
+#include <WiFiUdp.h>
+#include <pomp_priv.h>
+#include "test.h"
+#include "AllocCounter.h"
+
+/* As in main.cpp */
+static const char FORMAT_MSG_BARO[] = "%f%llu";
+static const int NAV_RATE = 25; /* [Hz] */
+static const int MESSAGES = 1000;
+static const int BENCHMARK_MESSAGES = 200000;
+
+static const char* HOSTS[MessagesManager::MAX_DESTINATIONS] = {
+  "ground.local", "192.168.1.20", "laptop.local", "10.0.0.7"
+};
+
+static void online()
+{
+  ESP8266WiFiClass::AccessPoint_t home = {"home", {0x10, 0x20, 0x30, 0x40, 0x50, 0x60}, 6, -55, ENC_TYPE_CCMP};
+  WiFi.aps.push_back(home);
+  WiFi.hosts.push_back(std::make_pair(String("ground.local"), IPAddress(192, 168, 1, 10)));
+  WiFi.hosts.push_back(std::make_pair(String("laptop.local"), IPAddress(192, 168, 1, 11)));
+  WiFi.begin("home", "secret");
+  delay(WiFi.scanMs + WiFi.associateMs + WiFi.dhcpMs);
+}
+
+static void sendBaro(MessagesManager& msg, int n)
+{
+  msg.send(MSG_BARO, FORMAT_MSG_BARO, 101325.0f - n % 100, (unsigned long long) n * 40000);
+}
+
+/* Every destination gets the same bytes, encoded once per message */
+static void fanOut(int count)
+{
+  MessagesManager msg;
+  for (int i = 0; i < count; i++) {
+    CHECK(msg.addDestination(HOSTS[i], 5152 + i) == i);
+  }
+  msg.init();
+  ProfileSummary_t summary[PROFILE_SPAN_COUNT];
+  profiler.takeSummary(summary, PROFILE_SPAN_COUNT);
+  WiFiUDP::sent.clear();
+  for (int n = 0; n < MESSAGES; n++) {
+    sendBaro(msg, n);
+  }
+  profiler.takeSummary(summary, PROFILE_SPAN_COUNT);
+  CHECK(summary[PROFILE_ENCODE].count == MESSAGES);
+  CHECK(WiFiUDP::sent.size() == (size_t)MESSAGES * count);
+  for (size_t i = 0; i < WiFiUDP::sent.size(); i++) {
+    const WiFiUDP::Datagram_t& d = WiFiUDP::sent[i];
+    int destination = i % count;
+    IPAddress address;
+    WiFi.hostByName(HOSTS[destination], address);
+    CHECK(d.address == address && d.port == 5152 + destination);
+    CHECK(d.data == WiFiUDP::sent[i - destination].data);
+  }
+  WiFiUDP::sent.clear();
+}
+
+/* A host the DNS does not know yet is skipped, looked up again every
+ * RESOLVE_INTERVAL from process() */
+static void unresolved()
+{
+  MessagesManager msg;
+  msg.addDestination("ground.local", 5152);
+  msg.addDestination("late.local", 5153);
+  int lookups = WiFi.lookups;
+  msg.init();
+  CHECK(WiFi.lookups == lookups + 2);
+
+  WiFiUDP::sent.clear();
+  for (int n = 0; n < 10 * NAV_RATE; n++) {
+    sendBaro(msg, n);
+    msg.process();
+    delay(1000 / NAV_RATE);
+  }
+  CHECK(WiFiUDP::sent.size() == 10 * NAV_RATE);
+  for (size_t i = 0; i < WiFiUDP::sent.size(); i++) {
+    CHECK(WiFiUDP::sent[i].port == 5152);
+  }
+  // Nothing more until the interval is over
+  CHECK(WiFi.lookups == lookups + 2);
+
+  WiFi.hosts.push_back(std::make_pair(String("late.local"), IPAddress(192, 168, 1, 12)));
+  delay(30000);
+  msg.process();
+  CHECK(WiFi.lookups == lookups + 3);
+  WiFiUDP::sent.clear();
+  sendBaro(msg, 0);
+  CHECK(WiFiUDP::sent.size() == 2 && WiFiUDP::sent[1].address == IPAddress(192, 168, 1, 12));
+  WiFi.hosts.pop_back();
+  WiFiUDP::sent.clear();
+}
+
+/* A rate limited destination skips messages, a disabled one gets none */
+static void rateAndEnable()
+{
+  MessagesManager msg;
+  int all = msg.addDestination("ground.local", 5152);
+  int slow = msg.addDestination("192.168.1.20", 5153, 1000);
+  int off = msg.addDestination("laptop.local", 5154);
+  CHECK(msg.addDestination("10.0.0.7", 5155) == 3);
+  CHECK(msg.addDestination("10.0.0.8", 5156) == -1);
+  msg.setDestinationEnabled(off, false);
+  msg.init();
+
+  WiFiUDP::sent.clear();
+  const int seconds = 10;
+  for (int n = 0; n < seconds * NAV_RATE; n++) {
+    sendBaro(msg, n);
+    delay(1000 / NAV_RATE);
+  }
+  size_t perPort[4] = {0, 0, 0, 0};
+  for (size_t i = 0; i < WiFiUDP::sent.size(); i++) {
+    perPort[WiFiUDP::sent[i].port - 5152]++;
+  }
+  CHECK(perPort[all] == seconds * NAV_RATE);
+  CHECK(perPort[slow] == seconds);
+  CHECK(perPort[off] == 0);
+  CHECK(perPort[3] == seconds * NAV_RATE);
+
+  msg.setDestinationEnabled(off, true);
+  WiFiUDP::sent.clear();
+  sendBaro(msg, 0);
+  CHECK(WiFiUDP::sent.size() == 4 && WiFiUDP::sent[off].port == 5154);
+  WiFiUDP::sent.clear();
+}
+
+/* Send cost against the destination count : the encode is paid once */
+static void benchmark()
+{
+  WiFiUDP::record = false;
+  for (int count = 1; count <= MessagesManager::MAX_DESTINATIONS; count++) {
+    MessagesManager msg;
+    for (int i = 0; i < count; i++) {
+      msg.addDestination(HOSTS[i], 5152 + i);
+    }
+    msg.init();
+    sendBaro(msg, 0);
+    ProfileSummary_t summary[PROFILE_SPAN_COUNT];
+    profiler.takeSummary(summary, PROFILE_SPAN_COUNT);
+    size_t allocs = allocCount;
+    double start = testSeconds();
+    for (int n = 0; n < BENCHMARK_MESSAGES; n++) {
+      sendBaro(msg, n);
+    }
+    double elapsed = testSeconds() - start;
+    profiler.takeSummary(summary, PROFILE_SPAN_COUNT);
+    CHECK(allocCount == allocs);
+    CHECK(summary[PROFILE_ENCODE].count == BENCHMARK_MESSAGES);
+    printf("%d destinations : %.0f ns per message, encode %.0f ns, %zu allocations\n",
+      count, elapsed * 1e9 / BENCHMARK_MESSAGES, summary[PROFILE_ENCODE].totalUs * 1e3 / BENCHMARK_MESSAGES,
+      allocCount - allocs);
+  }
+  WiFiUDP::record = true;
+}
+
+int main()
+{
+  online();
+  for (int count = 1; count <= MessagesManager::MAX_DESTINATIONS; count++) {
+    fanOut(count);
+  }
+  unresolved();
+  rateAndEnable();
+  benchmark();
+  return TEST_END();
+}
@@ -0,0 +1,200 @@
+#include <FecDecoder.h>
+#include <MessagesManager.h>
+#include <Types.h>
+#include <WiFiUdp.h>
+#include <libpomp.h>
+#include <pomp_priv.h>
+#include <map>
+#include <math.h>
+#include "test.h"
+
+/* As in main.cpp */
+static const char FORMAT_MSG_GPS[] = "%lf%lf%f%f%f%f%f%f%d%llu";
+static const char FORMAT_MSG_BARO[] = "%f%llu";
+static const char FORMAT_MSG_HEALTH[] = "%u%u%u%u%u%u%u%d%u%u";
+static const int MESSAGES = 50000;
+static const int ENCODE_MESSAGES = 500000;
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static void online()
+{
+  ESP8266WiFiClass::AccessPoint_t home = {"home", {0x10, 0x20, 0x30, 0x40, 0x50, 0x60}, 6, -55, ENC_TYPE_CCMP};
+  WiFi.aps.push_back(home);
+  WiFi.begin("home", "secret");
+  delay(WiFi.scanMs + WiFi.associateMs + WiFi.dhcpMs);
+}
+
+/* The 25 Hz mix : GPS and BARO in turn, a HEALTH every 50 */
+static void stream(MessagesManager& msg, int count)
+{
+  for (int n = 0; n < count; n++) {
+    if (n % 50 == 49) {
+      msg.send(MSG_HEALTH, FORMAT_MSG_HEALTH, (uint32_t) 25, (uint32_t) 18000, (uint32_t) 31000 - n % 500,
+        (uint32_t) 12000, (uint32_t) 0, (uint32_t) n / 5000, (uint32_t) 3, (int32_t) -67, (uint32_t) 2, (uint32_t) 0x3f);
+    } else if (n % 2 == 0) {
+      msg.send(MSG_GPS, FORMAT_MSG_GPS, 45.6 + n * 1e-7, 5.8, 1000.5f + n % 13, 1.5f, -2.5f, 0.25f, 2.0f, 3.0f,
+        (int32_t) 3, (unsigned long long) n * 20000);
+    } else {
+      msg.send(MSG_BARO, FORMAT_MSG_BARO, 101325.0f - n % 100, (unsigned long long) n * 20000);
+    }
+  }
+}
+
+static void header(const WiFiUDP::Datagram_t& d, uint32_t* msgid, uint32_t* seq)
+{
+  struct pomp_decoder dec = POMP_DECODER_INITIALIZER;
+  uint32_t session;
+  CHECK(pomp_decoder_init_with_data(&dec, d.data.data(), d.data.size(), msgid) == (int)d.data.size());
+  CHECK(pomp_decoder_read_u32(&dec, &session) == 0 && pomp_decoder_read_u32(&dec, seq) == 0);
+  pomp_decoder_clear(&dec);
+}
+
+/* Datagrams of MESSAGES messages sent with FEC groups of k */
+static std::vector<WiFiUDP::Datagram_t> capture(uint8_t k)
+{
+  MessagesManager msg;
+  msg.addDestination("192.168.42.1", 5152);
+  msg.init();
+  msg.setFEC(k);
+  WiFiUDP::sent.clear();
+  stream(msg, MESSAGES);
+  std::vector<WiFiUDP::Datagram_t> sent;
+  sent.swap(WiFiUDP::sent);
+  return sent;
+}
+
+typedef struct {
+  uint32_t lost;      /* Numbered messages */
+  uint32_t rebuilt;
+  uint32_t wrong;     /* Rebuilt but not as sent */
+} Delivery_t;
+
+/* Every datagram lost with the given probability, or the numbered messages
+ * whose seq % k == drop when drop >= 0 */
+static Delivery_t deliver(const std::vector<WiFiUDP::Datagram_t>& sent, double loss, int k = 0, int drop = -1)
+{
+  Delivery_t d = {0, 0, 0};
+  std::map<uint32_t, size_t> bySeq;
+  FecDecoder fec;
+  uint8_t out[FecDecoder::MAX_SIZE];
+
+  for (size_t i = 0; i < sent.size(); i++) {
+    uint32_t msgid, seq;
+    header(sent[i], &msgid, &seq);
+    if (msgid != MSG_FEC) {
+      bySeq[seq] = i;
+    }
+    bool lost = drop >= 0 ? msgid != MSG_FEC && (int)(seq % k) == drop : random32() < loss * 4294967296.0;
+    if (lost) {
+      d.lost += msgid != MSG_FEC;
+      continue;
+    }
+    size_t len = fec.receive(sent[i].data.data(), sent[i].data.size(), out);
+    if (len > 0) {
+      uint32_t rebuiltId, rebuiltSeq;
+      WiFiUDP::Datagram_t r;
+      r.data.assign(out, out + len);
+      header(r, &rebuiltId, &rebuiltSeq);
+      d.rebuilt++;
+      d.wrong += bySeq.count(rebuiltSeq) == 0 || sent[bySeq[rebuiltSeq]].data != r.data;
+    }
+  }
+  CHECK(fec.getRecovered() == d.rebuilt);
+  return d;
+}
+
+static size_t totalBytes(const std::vector<WiFiUDP::Datagram_t>& sent)
+{
+  size_t bytes = 0;
+  for (size_t i = 0; i < sent.size(); i++) {
+    bytes += sent[i].data.size();
+  }
+  return bytes;
+}
+
+/* A single loss per group is always rebuilt, two never are */
+static void singleLoss()
+{
+  std::vector<WiFiUDP::Datagram_t> sent = capture(8);
+  CHECK(sent.size() == MESSAGES + MESSAGES / 8);
+  Delivery_t d = deliver(sent, 0, 8, 3);
+  CHECK(d.lost == MESSAGES / 8 && d.rebuilt == d.lost && d.wrong == 0);
+
+  std::vector<WiFiUDP::Datagram_t> twice;
+  for (size_t i = 0; i < sent.size(); i++) {
+    uint32_t msgid, seq;
+    header(sent[i], &msgid, &seq);
+    if (msgid == MSG_FEC || seq % 8 != 5) {
+      twice.push_back(sent[i]);
+    }
+  }
+  d = deliver(twice, 0, 8, 3);
+  CHECK(d.rebuilt == 0);
+
+  // Without FEC nothing comes back
+  d = deliver(capture(0), 0, 8, 3);
+  CHECK(d.lost == MESSAGES / 8 && d.rebuilt == 0);
+}
+
+/* Recovery against overhead under independent random loss : a lost message
+ * comes back when the k - 1 others and the parity of its group arrive */
+static void randomLoss()
+{
+  const uint8_t ks[] = {2, 4, 8, 16};
+  const double losses[] = {0.01, 0.05, 0.1, 0.2};
+  size_t plain = totalBytes(capture(0));
+
+  for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+    std::vector<WiFiUDP::Datagram_t> sent = capture(ks[i]);
+    double overhead = (double)totalBytes(sent) / plain - 1;
+    for (size_t j = 0; j < sizeof(losses) / sizeof(losses[0]); j++) {
+      Delivery_t d = deliver(sent, losses[j]);
+      double recovered = (double)d.rebuilt / d.lost;
+      double expected = pow(1 - losses[j], ks[i]);
+      CHECK(d.wrong == 0);
+      CHECK(fabs(recovered - expected) < 0.06);
+      printf("k %2d, overhead %5.1f %%, loss %4.1f %% : %5.1f %% recovered (expected %5.1f %%), residual loss %5.2f %%\n",
+        ks[i], overhead * 100, losses[j] * 100, recovered * 100, expected * 100,
+        (double)(d.lost - d.rebuilt) * 100 / MESSAGES);
+    }
+  }
+}
+
+/* Cost on the device side : the parity is one XOR pass over each message,
+ * plus an encoded MSG_FEC every k */
+static void encodeCost()
+{
+  const uint8_t ks[] = {0, 4, 16};
+  WiFiUDP::record = false;
+  for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+    MessagesManager msg;
+    msg.addDestination("192.168.42.1", 5152);
+    msg.init();
+    msg.setFEC(ks[i]);
+    size_t packets = WiFiUDP::packets;
+    double start = testSeconds();
+    stream(msg, ENCODE_MESSAGES);
+    double elapsed = testSeconds() - start;
+    CHECK(WiFiUDP::packets - packets == (size_t)ENCODE_MESSAGES + (ks[i] ? ENCODE_MESSAGES / ks[i] : 0));
+    printf("k %2d : %.0f ns per message sent\n", ks[i], elapsed * 1e9 / ENCODE_MESSAGES);
+  }
+  WiFiUDP::record = true;
+}
+
+int main()
+{
+  online();
+  singleLoss();
+  randomLoss();
+  encodeCost();
+  return TEST_END();
+}
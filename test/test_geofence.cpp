@@ -0,0 +1,185 @@
+#include <Geofence.h>
+#include <GeofenceZones.h>
+#include <math.h>
+#include <set>
+#include <vector>
+#include "test.h"
+
+static const int32_t AREA_LAT = 455000000;  /* [1e-7 deg] south west corner */
+static const int32_t AREA_LON = 57000000;
+static const int32_t AREA_SIZE = 5000000;   /* 0.5 deg, about 50 km */
+static const int32_t UNITS_PER_M = 90;      /* 1e-7 deg of latitude */
+static const int FIXES = 100000;
+static const double STEP = 50;              /* [m] between fixes */
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+typedef struct {
+  std::vector<GeofenceZone_t> zones;
+  std::vector<GeofencePoint_t> vertices;
+  std::vector<GeofencePoint_t> low;   /* Bounding boxes */
+  std::vector<GeofencePoint_t> high;
+} Site_t;
+
+/* Star shaped polygons, concave, 200 m to 2 km across */
+static Site_t makeSite(int count)
+{
+  Site_t site;
+  for (int z = 0; z < count; z++) {
+    GeofenceZone_t zone = {(uint16_t)(100 + z), (uint16_t)site.vertices.size(), (uint16_t)(3 + random32() % 14)};
+    int32_t lat = AREA_LAT + random32() % AREA_SIZE;
+    int32_t lon = AREA_LON + random32() % AREA_SIZE;
+    double radius = (100 + random32() % 900) * UNITS_PER_M;
+    GeofencePoint_t low = {INT32_MAX, INT32_MAX};
+    GeofencePoint_t high = {INT32_MIN, INT32_MIN};
+    for (int i = 0; i < zone.count; i++) {
+      double angle = 2 * M_PI * (i + (random32() % 800) / 1000.0) / zone.count;
+      double r = radius * (0.4 + (random32() % 600) / 1000.0);
+      GeofencePoint_t p = {lat + (int32_t)(r * sin(angle)), lon + (int32_t)(r * cos(angle) / cos(45.5 * M_PI / 180))};
+      site.vertices.push_back(p);
+      low.lat = p.lat < low.lat ? p.lat : low.lat;
+      low.lon = p.lon < low.lon ? p.lon : low.lon;
+      high.lat = p.lat > high.lat ? p.lat : high.lat;
+      high.lon = p.lon > high.lon ? p.lon : high.lon;
+    }
+    site.zones.push_back(zone);
+    site.low.push_back(low);
+    site.high.push_back(high);
+  }
+  return site;
+}
+
+/* Winding number, written apart from Geofence::contains */
+static bool insideReference(const Site_t& site, int z, int32_t lat, int32_t lon)
+{
+  const GeofenceZone_t& zone = site.zones[z];
+  int winding = 0;
+
+  if (lat < site.low[z].lat || lat > site.high[z].lat || lon < site.low[z].lon || lon > site.high[z].lon) {
+    return false;
+  }
+  for (int i = 0; i < zone.count; i++) {
+    const GeofencePoint_t& a = site.vertices[zone.first + i];
+    const GeofencePoint_t& b = site.vertices[zone.first + (i + 1) % zone.count];
+    int64_t side = ((int64_t)b.lon - a.lon) * ((int64_t)lat - a.lat) - ((int64_t)lon - a.lon) * ((int64_t)b.lat - a.lat);
+    if (a.lat <= lat && b.lat > lat && side > 0) {
+      winding++;
+    } else if (a.lat > lat && b.lat <= lat && side < 0) {
+      winding--;
+    }
+  }
+  return winding != 0;
+}
+
+/* Glider wandering over the area, turning now and then */
+static std::vector<GeofencePoint_t> makeFlight()
+{
+  std::vector<GeofencePoint_t> fixes;
+  double lat = AREA_LAT + AREA_SIZE / 2;
+  double lon = AREA_LON + AREA_SIZE / 2;
+  double heading = 0;
+  for (int i = 0; i < FIXES; i++) {
+    if (random32() % 50 == 0) {
+      heading += (random32() % 1000 / 1000.0 - 0.5) * M_PI;
+    }
+    lat += STEP * UNITS_PER_M * cos(heading);
+    lon += STEP * UNITS_PER_M * sin(heading) / cos(45.5 * M_PI / 180);
+    // Back into the area
+    if (lat < AREA_LAT || lat > AREA_LAT + AREA_SIZE || lon < AREA_LON || lon > AREA_LON + AREA_SIZE) {
+      heading += M_PI;
+    }
+    GeofencePoint_t p = {(int32_t)lat, (int32_t)lon};
+    fixes.push_back(p);
+  }
+  return fixes;
+}
+
+/* Events of the indexed search against every zone tested at every fix */
+static void compare(int count)
+{
+  Site_t site = makeSite(count);
+  std::vector<GeofencePoint_t> fixes = makeFlight();
+  Geofence fence;
+  CHECK(fence.init(site.zones.data(), site.zones.size(), site.vertices.data()));
+
+  std::set<uint16_t> inside;
+  uint32_t events = 0;
+  uint32_t mismatches = 0;
+  for (size_t i = 0; i < fixes.size(); i++) {
+    fence.update(fixes[i].lat, fixes[i].lon, i * 40);
+    GeofenceEvent_t event;
+    while (fence.popEvent(&event)) {
+      CHECK(event.iTOW == i * 40);
+      if (event.type == GEOFENCE_ENTER) {
+        CHECK(inside.insert(event.id).second);
+      } else {
+        CHECK(inside.erase(event.id) == 1);
+      }
+      events++;
+    }
+    std::set<uint16_t> expected;
+    for (int z = 0; z < count; z++) {
+      if (insideReference(site, z, fixes[i].lat, fixes[i].lon)) {
+        expected.insert(site.zones[z].id);
+      }
+    }
+    mismatches += expected != inside;
+  }
+  CHECK(mismatches == 0);
+  CHECK(fence.getDroppedEvents() == 0);
+  CHECK(events > 0);
+
+  // Same flight timed alone, against testing every zone
+  Geofence timed;
+  timed.init(site.zones.data(), site.zones.size(), site.vertices.data());
+  double start = testSeconds();
+  for (size_t i = 0; i < fixes.size(); i++) {
+    timed.update(fixes[i].lat, fixes[i].lon, i * 40);
+    GeofenceEvent_t event;
+    while (timed.popEvent(&event)) {
+    }
+  }
+  double indexed = testSeconds() - start;
+  Geofence all;
+  all.init(site.zones.data(), site.zones.size(), site.vertices.data());
+  uint32_t hits = 0;
+  start = testSeconds();
+  for (size_t i = 0; i < fixes.size(); i++) {
+    for (int z = 0; z < count; z++) {
+      hits += all.contains(z, fixes[i].lat, fixes[i].lon);
+    }
+  }
+  double brute = testSeconds() - start;
+  CHECK(hits > 0);
+  printf("%4d zones : %u events, %.2f tests per fix, %.1fM fixes/s indexed, %.2fM fixes/s testing every zone\n",
+    count, events, (double)timed.getTests() / fixes.size(), fixes.size() / indexed / 1e6, fixes.size() / brute / 1e6);
+}
+
+/* The shipped table is empty unless built with GEOFENCE_EXAMPLE_ZONES */
+static void defaults()
+{
+  Geofence fence;
+  GeofenceEvent_t event;
+  CHECK(GEOFENCE_ZONE_COUNT == 0);
+  CHECK(fence.init(GEOFENCE_ZONES, GEOFENCE_ZONE_COUNT, GEOFENCE_VERTICES));
+  fence.update(456005000, 58010000, 0);
+  CHECK(!fence.popEvent(&event) && fence.getTests() == 0);
+}
+
+int main()
+{
+  defaults();
+  int counts[] = {10, 100, 1000};
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+    compare(counts[i]);
+  }
+  return TEST_END();
+}
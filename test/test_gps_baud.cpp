@@ -0,0 +1,71 @@
+#include <GPSManager.h>
+#include "FakeReceiver.h"
+#include "test.h"
+
+static void run(GPSManager& gps, FakeReceiver& receiver, unsigned long ms)
+{
+  for (unsigned long t = 0; t < ms; t++) {
+    receiver.step();
+    gps.process();
+    gps.prepareNextMeasure();
+  }
+}
+
+/* Receiver found at start, brought to the best rate both the host and the
+ * link allow */
+static void negotiate(uint32_t start, uint32_t target, uint32_t limit, uint32_t expected)
+{
+  GPSManager gps;
+  FakeReceiver receiver;
+
+  receiver.baud = start;
+  receiver.maxBaud = limit;
+  gps.init(target);
+  run(gps, receiver, 30000);
+  CHECK(gps.isLinkUp());
+  CHECK(gps.getBaud() == expected);
+  CHECK(receiver.baud == expected);
+  printf("receiver at %u, host up to %u, link up to %u : %u\n", start, target, limit, gps.getBaud());
+}
+
+int main()
+{
+  negotiate(9600, 921600, 2000000, 921600);
+  negotiate(230400, 921600, 2000000, 921600);
+  negotiate(921600, 115200, 2000000, 115200);
+  negotiate(38400, 921600, 460800, 460800);
+  negotiate(115200, 921600, 500000, 460800);
+
+  // Link degrading while locked : down to a rate it holds, and locked again
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    receiver.baud = 230400;
+    gps.init(921600);
+    run(gps, receiver, 15000);
+    CHECK(gps.isLinkUp() && gps.getBaud() == 921600);
+    receiver.maxBaud = 300000;
+    // Each try depends on a CFG-PRT going through the failing link
+    run(gps, receiver, 60000);
+    CHECK(gps.isLinkUp());
+    CHECK(gps.getBaud() == 230400);
+    CHECK(receiver.baud == 230400);
+    printf("link degraded to 300000 : %u\n", gps.getBaud());
+  }
+
+  // Receiver reset to its default rate : found again
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    receiver.baud = 230400;
+    gps.init(460800);
+    run(gps, receiver, 10000);
+    CHECK(gps.isLinkUp() && gps.getBaud() == 460800);
+    receiver.baud = 9600;
+    run(gps, receiver, 30000);
+    CHECK(gps.isLinkUp());
+    CHECK(gps.getBaud() == 460800 && receiver.baud == 460800);
+  }
+
+  return TEST_END();
+}
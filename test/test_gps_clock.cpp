@@ -0,0 +1,117 @@
+#include <GPSClock.h>
+#include <stdlib.h>
+#include <math.h>
+#include "test.h"
+
+static const int64_t LEAP_US = 18000000;
+
+typedef struct {
+  unsigned long iTOW;
+  long nano;
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+} Solution_t;
+
+/* NAV-PVT fields of a GPS time [us since 1980-01-06] */
+static Solution_t solution(uint64_t gps)
+{
+  Solution_t s;
+  uint64_t utc = gps - LEAP_US;
+  // civil from days, days since 1970-01-01
+  int64_t z = (int64_t)(utc / 86400000000ULL) + 3657 + 719468;
+  int64_t era = z / 146097;
+  unsigned doe = (unsigned)(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  s.day = doy - (153 * mp + 2) / 5 + 1;
+  s.month = mp < 10 ? mp + 3 : mp - 9;
+  s.year = yoe + era * 400 + (s.month <= 2);
+  s.iTOW = (gps % GPS_WEEK_US + 500) / 1000;
+  s.nano = (long)(utc % 1000000) * 1000;
+  if (s.nano >= 500000000) {
+    s.nano -= 1000000000;
+  }
+  return s;
+}
+
+static uint64_t epoch(uint64_t gps)
+{
+  Solution_t s = solution(gps);
+  return GPSClock::epochTime(s.iTOW, s.nano, s.year, s.month, s.day, GPS_VALID_DATE_TIME);
+}
+
+static double uniform()
+{
+  return rand() / (double)RAND_MAX;
+}
+
+/* 10 min at 25 Hz across a week rollover, fixes read latency plus up to
+ * jitter late, probed between fixes once settled. Returns the worst error. */
+static double track(double ppm, double jitter, int32_t* drift)
+{
+  GPSClock clock;
+  const double latency = 10000;
+  uint64_t start = 2389 * GPS_WEEK_US + GPS_WEEK_US - 60000000ULL;
+  double worst = 0;
+
+  srand(1);
+  for (int i = 0; i < 25 * 600; i++) {
+    uint64_t t = start + (uint64_t)i * 40000;
+    Solution_t s = solution(t);
+    double local = 1e8 + (t - start) * (1 + ppm * 1e-6) + latency + uniform() * jitter;
+    clock.discipline((uint64_t)local, s.iTOW, s.nano, s.year, s.month, s.day, GPS_VALID_DATE_TIME);
+    if (i > 25 * 60) {
+      double dt = rand() % 40000;
+      double probe = 1e8 + (t + dt - start) * (1 + ppm * 1e-6);
+      double error = (double)(int64_t)(clock.toGPS((uint64_t)probe) - (t + (uint64_t)dt)) + latency;
+      worst = fmax(worst, fabs(error));
+    }
+  }
+  *drift = clock.getDrift();
+  return worst;
+}
+
+int main()
+{
+  // Epoch, week rollover, and the UTC date lagging GPS time around midnight
+  CHECK(epoch(86400000000ULL) == 86400000000ULL);
+  CHECK(epoch(2389 * GPS_WEEK_US) == 2389 * GPS_WEEK_US);
+  CHECK(epoch(2389 * GPS_WEEK_US + 5000000) == 2389 * GPS_WEEK_US + 5000000);
+  CHECK(epoch(2389 * GPS_WEEK_US - 40000) == 2389 * GPS_WEEK_US - 40000);
+  CHECK(epoch(2400 * GPS_WEEK_US + 86400000000ULL * 3 + 123456789) == 2400 * GPS_WEEK_US + 86400000000ULL * 3 + 123456789);
+  CHECK(GPSClock::epochTime(1000, 0, 2026, 10, 19, 0x01) == 0);
+
+  // Within the read jitter plus 1 ms. A fast oscillator is slowed down, the
+  // drift estimate is only as good as the jitter lets it be
+  const double cases[][2] = { {50, 3000}, {200, 3000}, {-100, 3000}, {50, 10000} };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    int32_t drift;
+    double worst = track(cases[i][0], cases[i][1], &drift);
+    CHECK(worst <= cases[i][1] + 1000);
+    CHECK(fabs(drift + cases[i][0] * 1000) <= fabs(cases[i][0]) * 250);
+    printf("%+.0f ppm, %.0f us jitter : max error %.0f us, drift %d ppb\n", cases[i][0], cases[i][1], worst, drift);
+  }
+
+  // A fix read late once is ignored, a jump that stays steps the clock
+  {
+    GPSClock clock;
+    uint64_t t = 2389 * GPS_WEEK_US;
+    for (int i = 0; i < 250; i++, t += 40000) {
+      Solution_t s = solution(t);
+      clock.discipline(t, s.iTOW, s.nano, s.year, s.month, s.day, GPS_VALID_DATE_TIME);
+    }
+    Solution_t s = solution(t);
+    clock.discipline(t + 100000, s.iTOW, s.nano, s.year, s.month, s.day, GPS_VALID_DATE_TIME);
+    CHECK(llabs((int64_t)(clock.toGPS(t + 40000) - (t + 40000))) < 100);
+    for (int i = 0; i < GPSClock::STEP_COUNT; i++) {
+      t += 40000;
+      s = solution(t);
+      clock.discipline(t - 1000000, s.iTOW, s.nano, s.year, s.month, s.day, GPS_VALID_DATE_TIME);
+    }
+    CHECK(llabs((int64_t)(clock.toGPS(t - 1000000) - t)) < 100);
+  }
+
+  return TEST_END();
+}
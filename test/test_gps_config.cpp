@@ -0,0 +1,114 @@
+#include <GPSManager.h>
+#include "FakeReceiver.h"
+#include "test.h"
+
+static const int CFG_MESSAGES = 5; /* flash() : NAV5, NAVX5, RATE, MSG, CFG */
+
+static void run(GPSManager& gps, FakeReceiver& receiver, unsigned long ms)
+{
+  for (unsigned long t = 0; t < ms; t++) {
+    receiver.step();
+    gps.process();
+    gps.prepareNextMeasure();
+  }
+}
+
+/* CFG frames the host sent with that id, -1 for all but CFG-PRT */
+static int sent(int id)
+{
+  int count = 0;
+  for (size_t i = 0; i + 8 <= Serial.tx.size(); i++) {
+    const uint8_t* frame = &Serial.tx[i];
+    if (frame[0] == 0xB5 && frame[1] == 0x62 && frame[2] == 0x06
+        && (id < 0 ? frame[3] != 0x00 : frame[3] == id)) {
+      count++;
+      i += 7 + (frame[4] | (frame[5] << 8));
+    }
+  }
+  return count;
+}
+
+static void start(GPSManager& gps, FakeReceiver& receiver)
+{
+  receiver.baud = 230400;
+  gps.init(230400);
+  run(gps, receiver, 500);
+}
+
+int main()
+{
+  // Every message ACKed
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    start(gps, receiver);
+    CHECK(gps.isLinkUp());
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_IDLE);
+    gps.flash();
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_BUSY);
+    run(gps, receiver, 100);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_DONE);
+    CHECK(sent(-1) == CFG_MESSAGES);
+  }
+
+  // One NAK fails the batch, the other messages still go through
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    receiver.nakId = 0x23;
+    start(gps, receiver);
+    gps.flash();
+    run(gps, receiver, 100);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_FAILED);
+    CHECK(sent(-1) == CFG_MESSAGES);
+  }
+
+  // Silent receiver : every message tried GPS_CONFIG_RETRIES times
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    receiver.silent = true;
+    start(gps, receiver);
+    gps.flash();
+    run(gps, receiver, GPS_CONFIG_ACK_TIMEOUT * GPS_CONFIG_RETRIES - 100);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_BUSY);
+    run(gps, receiver, 200);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_FAILED);
+    CHECK(sent(-1) == CFG_MESSAGES * GPS_CONFIG_RETRIES);
+  }
+
+  // Lost frames are sent again
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    receiver.ignore = 2;
+    start(gps, receiver);
+    gps.flash();
+    run(gps, receiver, 100);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_BUSY);
+    run(gps, receiver, GPS_CONFIG_ACK_TIMEOUT);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_DONE);
+    CHECK(sent(-1) == CFG_MESSAGES + 2);
+  }
+
+  // Queued at boot, held until the link is up, CFG-RATE of setNavRate() sent once
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    receiver.baud = 9600;
+    gps.init(9600);
+    gps.setNavRate(40);
+    gps.flash();
+    run(gps, receiver, 100);
+    CHECK(!gps.isLinkUp());
+    CHECK(sent(-1) == 0);
+    run(gps, receiver, 10000);
+    CHECK(gps.isLinkUp());
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_DONE);
+    CHECK(sent(-1) == CFG_MESSAGES);
+    CHECK(sent(0x08) == 1);
+    CHECK(receiver.navPeriod == 40);
+  }
+
+  return TEST_END();
+}
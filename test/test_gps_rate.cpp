@@ -0,0 +1,99 @@
+#include <GPSManager.h>
+#include "FakeReceiver.h"
+#include "test.h"
+
+/* Main loop every loopMs, each fix taken when consume is set */
+static int run(GPSManager& gps, FakeReceiver& receiver, unsigned long ms, unsigned long loopMs = 1, bool consume = true)
+{
+  int fixes = 0;
+  for (unsigned long t = 1; t <= ms; t++) {
+    receiver.step();
+    if (t % loopMs == 0) {
+      gps.process();
+      if (consume && gps.isReady()) {
+        fixes++;
+        gps.prepareNextMeasure();
+      }
+    }
+  }
+  return fixes;
+}
+
+/* Receiver at the first rate tried, switched to 921600 */
+static void start(GPSManager& gps, FakeReceiver& receiver)
+{
+  receiver.baud = 230400;
+  gps.init(921600);
+  gps.setNavRate(40);
+  gps.flash();
+}
+
+int main()
+{
+  // 25 Hz once CFG-RATE is ACKed, the 200 ms epochs before are not drops
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    start(gps, receiver);
+    run(gps, receiver, 3000);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_DONE);
+    CHECK(receiver.navPeriod == 40);
+    GPSStats_t stats = gps.getStats();
+    CHECK(stats.droppedEpochs == 0);
+
+    int fixes = run(gps, receiver, 10000);
+    CHECK(fixes >= 249 && fixes <= 251);
+    stats = gps.getStats();
+    CHECK(stats.droppedEpochs == 0);
+    CHECK(stats.overwrittenEpochs == 0);
+    CHECK(stats.uartOverruns == 0);
+    CHECK(stats.checksumFailures == 0);
+
+    // Epochs the receiver skipped
+    for (int i = 0; i < 5; i++) {
+      receiver.skip(i + 1);
+      run(gps, receiver, 1000);
+    }
+    stats = gps.getStats();
+    CHECK(stats.droppedEpochs == 15);
+
+    // Loop slower than the nav rate : fixes replaced before being taken
+    fixes = run(gps, receiver, 1000, 60);
+    stats = gps.getStats();
+    CHECK(fixes >= 16 && fixes <= 17);
+    CHECK(fixes + stats.overwrittenEpochs >= 24 && fixes + stats.overwrittenEpochs <= 26);
+    CHECK(stats.droppedEpochs == 15);
+    CHECK(stats.uartOverruns == 0);
+  }
+
+  // Loop stalled long enough for the RX buffer to fill up
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    start(gps, receiver);
+    run(gps, receiver, 3000);
+    GPSStats_t before = gps.getStats();
+    run(gps, receiver, 300, 300);
+    run(gps, receiver, 1000);
+    GPSStats_t stats = gps.getStats();
+    CHECK(stats.uartOverruns == before.uartOverruns + 1);
+    CHECK(stats.droppedEpochs > before.droppedEpochs);
+    printf("300 ms stall : %lu overrun, %lu epochs lost\n",
+      stats.uartOverruns - before.uartOverruns, stats.droppedEpochs - before.droppedEpochs);
+  }
+
+  // CFG-RATE refused : still 5 Hz, and counted as such
+  {
+    GPSManager gps;
+    FakeReceiver receiver;
+    receiver.nakId = 0x08;
+    start(gps, receiver);
+    run(gps, receiver, 3000);
+    CHECK(gps.getConfigStatus() == GPS_CONFIG_FAILED);
+    int fixes = run(gps, receiver, 10000);
+    CHECK(fixes >= 49 && fixes <= 51);
+    CHECK(gps.getStats().droppedEpochs == 0);
+  }
+
+  return TEST_END();
+}
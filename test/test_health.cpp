@@ -0,0 +1,135 @@
+#include <MessagesManager.h>
+#include <Profiler.h>
+#include <Types.h>
+#include <WiFiUdp.h>
+#include <libpomp.h>
+#include <pomp_priv.h>
+#include <pomp_varint.h>
+#include "test.h"
+#include "AllocCounter.h"
+
+/* As in main.cpp */
+static const char FORMAT_MSG_GPS[] = "%lf%lf%f%f%f%f%f%f%d%llu";
+static const char FORMAT_MSG_BARO[] = "%f%llu";
+static const char FORMAT_MSG_PROFILE[] = "%u%p%u";
+static const char FORMAT_MSG_HEALTH[] = "%u%u%u%u%u%u%u%d%u%u";
+static const int NAV_RATE = 25; /* [Hz] */
+
+/* Encoding may take 1 % of each second on the device. The host is taken as
+ * 100 times faster than the 80 MHz LX106, which leaves 100 us of host time
+ * per second of telemetry; the device reports the real figure in the encode
+ * span of MSG_PROFILE. */
+static const double ENCODE_BUDGET_US = 100;
+static const int SECONDS = 20000;
+
+static void online(MessagesManager& msg)
+{
+  ESP8266WiFiClass::AccessPoint_t home = {"home", {0x10, 0x20, 0x30, 0x40, 0x50, 0x60}, 6, -55, ENC_TYPE_CCMP};
+  WiFi.aps.push_back(home);
+  WiFi.begin("home", "secret");
+  delay(WiFi.scanMs + WiFi.associateMs + WiFi.dhcpMs);
+  msg.addDestination("192.168.42.1", 5152);
+  msg.init();
+}
+
+static HealthData_t sampleHealth(uint32_t i)
+{
+  HealthData_t h = {2400 + i % 100, 18000 + i % 7, 31000 - i % 500, 12000, i / 1000, i / 5000, 3, -67, 2, 0x3f};
+  return h;
+}
+
+static void sendHealth(MessagesManager& msg, const HealthData_t& h)
+{
+  msg.send(MSG_HEALTH,
+    FORMAT_MSG_HEALTH,
+    (uint32_t) h.loopRate,
+    (uint32_t) h.maxLoopTime,
+    (uint32_t) h.freeHeap,
+    (uint32_t) h.maxFreeBlock,
+    (uint32_t) h.uartOverruns,
+    (uint32_t) h.checksumFailures,
+    (uint32_t) h.sendFailures,
+    (int32_t) h.rssi,
+    (uint32_t) h.reconnects,
+    (uint32_t) h.gpsConfig);
+}
+
+static void roundTrip(MessagesManager& msg)
+{
+  HealthData_t h = sampleHealth(123456);
+  WiFiUDP::sent.clear();
+  sendHealth(msg, h);
+  CHECK(WiFiUDP::sent.size() == 1);
+
+  const WiFiUDP::Datagram_t& d = WiFiUDP::sent[0];
+  struct pomp_decoder dec = POMP_DECODER_INITIALIZER;
+  uint32_t msgid = 0;
+  uint32_t session, seq;
+  uint32_t v[10];
+  int32_t rssi;
+  CHECK(pomp_decoder_init_with_data(&dec, d.data.data(), d.data.size(), &msgid) == (int)d.data.size());
+  CHECK(msgid == MSG_HEALTH);
+  CHECK(pomp_decoder_read(&dec, "%u%u%u%u%u%u%u%u%u%d%u%u", &session, &seq,
+    &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &rssi, &v[8], &v[9]) == 0);
+  CHECK(v[0] == h.loopRate && v[1] == h.maxLoopTime && v[2] == h.freeHeap && v[3] == h.maxFreeBlock);
+  CHECK(v[4] == h.uartOverruns && v[5] == h.checksumFailures && v[6] == h.sendFailures);
+  CHECK(rssi == h.rssi && v[8] == h.reconnects && v[9] == h.gpsConfig);
+  printf("MSG_HEALTH : %zu bytes\n", d.data.size());
+  WiFiUDP::sent.clear();
+}
+
+/* SECONDS of the 25 Hz stream with its 1 Hz health and profile messages */
+static void budget(MessagesManager& msg)
+{
+  uint32_t values[PROFILE_SPAN_COUNT * 3];
+  uint8_t packed[sizeof(values) / 4 * 5];
+  ProfileSummary_t summary[PROFILE_SPAN_COUNT];
+  uint64_t healthNs = 0;
+  size_t allocs = allocCount;
+
+  WiFiUDP::record = false;
+  profiler.takeSummary(summary, PROFILE_SPAN_COUNT);
+  uint64_t encodeUs = 0;
+  uint32_t encodeMaxUs = 0;
+  for (int s = 0; s < SECONDS; s++) {
+    for (int i = 0; i < NAV_RATE; i++) {
+      uint32_t n = s * NAV_RATE + i;
+      msg.send(MSG_GPS, FORMAT_MSG_GPS, 45.6 + n * 1e-7, 5.8, 1000.5f, 1.5f, -2.5f, 0.25f, 2.0f, 3.0f,
+        (int32_t) 3, (unsigned long long) n * 40000);
+      msg.send(MSG_BARO, FORMAT_MSG_BARO, 101325.0f - n % 100, (unsigned long long) n * 40000);
+    }
+    for (int i = 0; i < PROFILE_SPAN_COUNT * 3; i++) {
+      values[i] = s * 31 + i;
+    }
+    size_t len = pomp_varint_encode_u32_array(values, PROFILE_SPAN_COUNT * 3, packed);
+    msg.send(MSG_PROFILE, FORMAT_MSG_PROFILE, (uint32_t) PROFILE_SPAN_COUNT, packed, (uint32_t) len);
+    ProfileTime_t start = Profiler::now();
+    sendHealth(msg, sampleHealth(s));
+    healthNs += Profiler::now() - start;
+
+    // Encode spans only, the UDP stand-in is not the device stack
+    if (s % 100 == 99) {
+      profiler.takeSummary(summary, PROFILE_SPAN_COUNT);
+      encodeUs += summary[PROFILE_ENCODE].totalUs;
+      encodeMaxUs = summary[PROFILE_ENCODE].maxUs > encodeMaxUs ? summary[PROFILE_ENCODE].maxUs : encodeMaxUs;
+    }
+  }
+  WiFiUDP::record = true;
+
+  double perSecond = (double)encodeUs / SECONDS;
+  CHECK(allocCount == allocs);
+  CHECK(WiFiUDP::packets >= (size_t)SECONDS * (2 * NAV_RATE + 2));
+  CHECK(perSecond < ENCODE_BUDGET_US);
+  printf("%d messages/s : encode %.1f us per second of telemetry (budget %.0f), %u us worst message, "
+    "MSG_HEALTH %.0f ns sent, %zu allocations\n",
+    2 * NAV_RATE + 2, perSecond, ENCODE_BUDGET_US, encodeMaxUs, (double)healthNs / SECONDS, allocCount - allocs);
+}
+
+int main()
+{
+  MessagesManager msg;
+  online(msg);
+  roundTrip(msg);
+  budget(msg);
+  return TEST_END();
+}
@@ -0,0 +1,73 @@
+#include <LEDManager.h>
+#include <vector>
+#include "test.h"
+
+static const int PIN = 5;
+
+/* Durations [ms] of the successive LED levels over ms, starting with the
+ * level at the first change */
+static std::vector<int> levels(uint32_t ms, int* first)
+{
+  std::vector<int> durations;
+  int level = pinLevel[PIN];
+  int length = 0;
+
+  *first = -1;
+  for (uint32_t t = 0; t < ms; t++) {
+    Ticker::advance(1);
+    if (pinLevel[PIN] != level) {
+      if (*first < 0) {
+        *first = pinLevel[PIN];
+      } else {
+        durations.push_back(length);
+      }
+      level = pinLevel[PIN];
+      length = 0;
+    }
+    length++;
+  }
+  return durations;
+}
+
+int main()
+{
+  LEDManager led(PIN);
+  int first;
+  led.init();
+
+  // Two blinks, then a pause
+  led.setPattern(LED_PATTERN_WIFI_RECONNECTING);
+  std::vector<int> d = levels(3000, &first);
+  CHECK(first == HIGH);
+  CHECK(d.size() >= 6);
+  CHECK(d[0] == 100 && d[1] == 200 && d[2] == 100 && d[3] == 1000);
+  CHECK(d[4] == 100 && d[5] == 200);
+
+  // Same pattern every loop does not restart it
+  for (int i = 0; i < 50; i++) {
+    led.setPattern(LED_PATTERN_WIFI_RECONNECTING);
+    Ticker::advance(1);
+  }
+  d = levels(3000, &first);
+  CHECK(d.size() >= 4 && d[0] + d[1] + d[2] + d[3] == 1400);
+
+  // Steady states, applied on the next tick
+  led.status(true, true);
+  levels(LEDManager::TICK_MS, &first);
+  CHECK(pinLevel[PIN] == HIGH);
+  d = levels(2000, &first);
+  CHECK(first == -1 && pinLevel[PIN] == HIGH);
+  led.status(false, false);
+  levels(LEDManager::TICK_MS, &first);
+  CHECK(pinLevel[PIN] == LOW);
+
+  // Blinking forever
+  led.status(true, false);
+  d = levels(5000, &first);
+  CHECK(d.size() >= 3 && d[0] == 1000 && d[1] == 1000 && d[2] == 1000);
+  led.status(false, true);
+  d = levels(1000, &first);
+  CHECK(d.size() >= 3 && d[1] == 100 && d[2] == 100);
+
+  return TEST_END();
+}
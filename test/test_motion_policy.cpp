@@ -0,0 +1,203 @@
+#include <MotionPolicy.h>
+#include <MessagesManager.h>
+#include <Types.h>
+#include <WiFiUdp.h>
+#include <math.h>
+#include "test.h"
+
+/* As in main.cpp */
+static const char FORMAT_MSG_GPS[] = "%lf%lf%f%f%f%f%f%f%d%llu";
+static const char FORMAT_MSG_BARO[] = "%f%llu";
+static const float MOTION_SPEED = 500;
+static const float MOTION_DISTANCE = 5000;
+static const uint32_t MOTION_STILL_DELAY = 3000;
+static const uint32_t MOTION_KEEPALIVE = 10000;
+static const int NAV_RATE = 25; /* [Hz] */
+static const uint64_t EPOCH = 1000000 / NAV_RATE; /* [us] */
+static const double MOVING = 1000; /* [mm/s] true speed no fix may be held back at */
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static double gauss()
+{
+  double u = (random32() + 1.0) / 4294967297.0;
+  double v = random32() / 4294967296.0;
+  return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+/* Receiver output around a true state : position noise wandering slowly,
+ * white velocity noise, accuracies as a u-blox reports them outdoors */
+typedef struct {
+  uint64_t time;    /* [us] */
+  double north;     /* [mm] true position */
+  double east;
+  double up;
+  double velN;      /* [mm/s] true velocity */
+  double velE;
+  double velD;
+  double noiseN;    /* [mm] */
+  double noiseE;
+  double noiseU;
+} Truth_t;
+
+static GPSData_t observe(Truth_t& t)
+{
+  GPSData_t data = {};
+  t.noiseN = 0.99 * t.noiseN + gauss() * 50;
+  t.noiseE = 0.99 * t.noiseE + gauss() * 50;
+  t.noiseU = 0.99 * t.noiseU + gauss() * 100;
+  data.time = t.time;
+  data.iTOW = t.time / 1000;
+  data.latitude = 456000000 + (t.north + t.noiseN) / 11.1319;
+  data.longitude = 58000000 + (t.east + t.noiseE) / (11.1319 * cos(45.6 * M_PI / 180));
+  data.altitude = 1000000 + t.up + t.noiseU;
+  data.northSpeed = t.velN + gauss() * 100;
+  data.eastSpeed = t.velE + gauss() * 100;
+  data.downSpeed = t.velD + gauss() * 150;
+  data.horizontalAcc = 2000;
+  data.verticalAcc = 3500;
+  data.speedAcc = 300;
+  data.numberSV = 14;
+  data.isReady = true;
+  return data;
+}
+
+typedef enum {
+  PHASE_PARKED,   /* On the ground, switched on */
+  PHASE_GROUND,   /* Carried to take-off : walks and stops */
+  PHASE_CREEP,    /* Drifting slower than the speed threshold */
+  PHASE_FLIGHT
+} Phase_t;
+
+typedef struct {
+  uint32_t fixes;
+  uint32_t sent;
+  uint32_t heldMoving;    /* Fixes moving at MOVING or more not sent */
+  uint64_t maxGap;        /* [us] between sent fixes */
+  size_t bytes;           /* MSG_GPS and MSG_BARO */
+  uint64_t firstSent;     /* [us] first fix sent after the start */
+} Run_t;
+
+/* seconds of phase, MSG_GPS and MSG_BARO sent as main.cpp does */
+static Run_t run(MotionPolicy& motion, MessagesManager& msg, Truth_t& t, Phase_t phase, int seconds)
+{
+  Run_t r = {0, 0, 0, 0, 0, 0};
+  uint64_t start = t.time;
+  uint64_t lastSent = t.time;
+  double heading = 0;
+  size_t bytes = WiFiUDP::bytes;
+
+  for (int i = 0; i < seconds * NAV_RATE; i++) {
+    double s = i / (double)NAV_RATE;
+    double speed = 0;
+    if (phase == PHASE_GROUND) {
+      // 20 s walking, 30 s standing
+      speed = fmod(s, 50) < 20 ? 1200 : 0;
+      heading += 0.01;
+    } else if (phase == PHASE_CREEP) {
+      speed = 200;
+    } else if (phase == PHASE_FLIGHT) {
+      speed = 12000;
+      heading += fmod(s, 60) < 30 ? 2 * M_PI / 20 / NAV_RATE : 0;
+    }
+    t.velN = speed * cos(heading);
+    t.velE = speed * sin(heading);
+    t.velD = phase == PHASE_FLIGHT ? -1000 * sin(s / 7) : 0;
+    t.north += t.velN / NAV_RATE;
+    t.east += t.velE / NAV_RATE;
+    t.up -= t.velD / NAV_RATE;
+    t.time += EPOCH;
+
+    GPSData_t data = observe(t);
+    r.fixes++;
+    if (motion.shouldSend(data)) {
+      msg.send(MSG_GPS, FORMAT_MSG_GPS, data.latitude / 1e7, data.longitude / 1e7, data.altitude / 1000.0,
+        data.horizontalAcc / 1000.0, data.verticalAcc / 1000.0, data.northSpeed / 1000.0, data.eastSpeed / 1000.0,
+        data.downSpeed / 1000.0, data.numberSV, (unsigned long long) data.time);
+      msg.send(MSG_BARO, FORMAT_MSG_BARO, 101325.0f - (float)t.up / 84, (unsigned long long) data.time);
+      r.firstSent = r.sent == 0 ? t.time - start : r.firstSent;
+      r.maxGap = t.time - lastSent > r.maxGap ? t.time - lastSent : r.maxGap;
+      lastSent = t.time;
+      r.sent++;
+    } else if (speed >= MOVING) {
+      r.heldMoving++;
+    }
+  }
+  r.maxGap = t.time - lastSent > r.maxGap ? t.time - lastSent : r.maxGap;
+  r.bytes = WiFiUDP::bytes - bytes;
+  return r;
+}
+
+static void report(const char* name, const Run_t& r, int seconds)
+{
+  double all = (double)r.bytes / r.sent * r.fixes;
+  printf("%-8s : %5u of %5u fixes sent, longest gap %5.2f s, %6.1f kB/h (%6.1f kB/h sending every fix)\n",
+    name, r.sent, r.fixes, r.maxGap / 1e6, r.bytes * 3600.0 / seconds / 1000, all * 3600 / seconds / 1000);
+}
+
+int main()
+{
+  ESP8266WiFiClass::AccessPoint_t home = {"home", {0x10, 0x20, 0x30, 0x40, 0x50, 0x60}, 6, -55, ENC_TYPE_CCMP};
+  WiFi.aps.push_back(home);
+  WiFi.begin("home", "secret");
+  delay(WiFi.scanMs + WiFi.associateMs + WiFi.dhcpMs);
+  WiFiUDP::record = false;
+  MessagesManager msg;
+  msg.addDestination("192.168.42.1", 5152);
+  msg.init();
+
+  MotionPolicy motion;
+  motion.setSpeedThreshold(MOTION_SPEED);
+  motion.setDistanceThreshold(MOTION_DISTANCE);
+  motion.setStillDelay(MOTION_STILL_DELAY);
+  motion.setKeepalive(MOTION_KEEPALIVE);
+  Truth_t t = {};
+  t.time = 1000000000000ULL;
+
+  // An hour parked : keepalives only, never more than the period apart
+  const int parked = 3600;
+  Run_t r = run(motion, msg, t, PHASE_PARKED, parked);
+  CHECK(motion.isStationary());
+  CHECK(r.maxGap <= (uint64_t)MOTION_KEEPALIVE * 1000 + EPOCH);
+  CHECK(r.sent <= parked * 1000 / MOTION_KEEPALIVE + MOTION_STILL_DELAY * NAV_RATE / 1000 + 1);
+  report("parked", r, parked);
+
+  // Walking to take-off : every step sent, the first one at once, stops
+  // fall back to keepalives after the still delay
+  const int ground = 1800;
+  r = run(motion, msg, t, PHASE_GROUND, ground);
+  CHECK(r.heldMoving == 0);
+  CHECK(r.firstSent == EPOCH);
+  CHECK(r.sent < r.fixes * 3 / 4);
+  report("ground", r, ground);
+
+  // Slower than the speed threshold : the distance catches it every
+  // (threshold + hAcc) / speed, 35 s, each time with a still delay at full rate
+  Run_t still = run(motion, msg, t, PHASE_PARKED, 60);
+  CHECK(motion.isStationary() && still.heldMoving == 0);
+  r = run(motion, msg, t, PHASE_CREEP, 120);
+  CHECK(r.sent >= 3 * MOTION_STILL_DELAY * NAV_RATE / 1000);
+  CHECK(r.maxGap <= (uint64_t)MOTION_KEEPALIVE * 1000 + EPOCH);
+  report("creep", r, 120);
+
+  // Flying : nothing held back, whatever the turns and climbs
+  const int flight = 3600;
+  r = run(motion, msg, t, PHASE_FLIGHT, flight);
+  CHECK(r.heldMoving == 0 && r.sent == r.fixes);
+  CHECK(r.maxGap == EPOCH);
+  report("flight", r, flight);
+
+  // Landed : stationary again after the still delay
+  r = run(motion, msg, t, PHASE_PARKED, 60);
+  CHECK(motion.isStationary());
+  CHECK(r.sent <= MOTION_STILL_DELAY * NAV_RATE / 1000 + 60 * 1000 / MOTION_KEEPALIVE + 2);
+  return TEST_END();
+}
@@ -0,0 +1,143 @@
+#include <libpomp.h>
+#include <pomp_priv.h>
+#include <string.h>
+#include <vector>
+#include "test.h"
+#include "AllocCounter.h"
+
+static const int WORKLOAD_MESSAGES = 500000;
+
+static uint8_t pattern(size_t i)
+{
+  return (uint8_t)(i * 31 + 7);
+}
+
+static bool holdsPattern(struct pomp_buffer* buf, size_t len)
+{
+  std::vector<uint8_t> out(len);
+  size_t pos = 0;
+  if (pomp_buffer_read(buf, &pos, out.data(), len) < 0) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    if (out[i] != pattern(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void spill()
+{
+  size_t allocs = allocCount;
+  size_t frees = freeCount;
+  struct pomp_buffer* buf = pomp_buffer_new(0);
+  size_t pos = 0;
+
+  // Up to the inline size : the structure is the only allocation
+  CHECK(buf->data == buf->inlinedata);
+  CHECK(buf->capacity == POMP_BUFFER_INLINE_SIZE);
+  for (size_t i = 0; i < POMP_BUFFER_INLINE_SIZE; i++) {
+    CHECK(pomp_buffer_writeb(buf, &pos, pattern(i)) == 0);
+  }
+  CHECK(buf->data == buf->inlinedata);
+  CHECK(allocCount == allocs + 1);
+
+  // One byte more spills to the heap, content kept across the boundary
+  CHECK(pomp_buffer_writeb(buf, &pos, pattern(POMP_BUFFER_INLINE_SIZE)) == 0);
+  CHECK(buf->data != buf->inlinedata);
+  CHECK(buf->capacity == POMP_BUFFER_ALIGN_ALLOC_SIZE(POMP_BUFFER_INLINE_SIZE + 1));
+  CHECK(allocCount == allocs + 2);
+  CHECK(holdsPattern(buf, POMP_BUFFER_INLINE_SIZE + 1));
+
+  // Growing on the heap reallocates
+  uint8_t big[1000];
+  for (size_t i = 0; i < sizeof(big); i++) {
+    big[i] = pattern(pos + i);
+  }
+  CHECK(pomp_buffer_write(buf, &pos, big, sizeof(big)) == 0);
+  CHECK(reallocCount == 1);
+  CHECK(holdsPattern(buf, pos));
+
+  // Reading past the end fails
+  size_t end = pos;
+  uint8_t b;
+  CHECK(pomp_buffer_readb(buf, &end, &b) < 0);
+
+  // Shrinking under the inline size moves the data back and frees the heap
+  CHECK(pomp_buffer_set_capacity(buf, 64) == -EINVAL);
+  CHECK(pomp_buffer_set_len(buf, 60) == 0);
+  CHECK(pomp_buffer_set_capacity(buf, 64) == 0);
+  CHECK(buf->data == buf->inlinedata);
+  CHECK(buf->capacity == POMP_BUFFER_INLINE_SIZE);
+  CHECK(freeCount == frees + 1);
+  CHECK(holdsPattern(buf, 60));
+
+  // A shared buffer is read only
+  pomp_buffer_ref(buf);
+  pos = 60;
+  CHECK(pomp_buffer_writeb(buf, &pos, 0) == -EPERM);
+  CHECK(pomp_buffer_set_capacity(buf, 1000) == -EPERM);
+  pomp_buffer_unref(buf);
+
+  // Spill again, then everything goes with the last reference
+  CHECK(pomp_buffer_set_capacity(buf, 1000) == 0);
+  CHECK(buf->data != buf->inlinedata);
+  CHECK(holdsPattern(buf, 60));
+  pomp_buffer_unref(buf);
+  CHECK(allocCount - allocs == freeCount - frees);
+
+  // Copies of small data stay inline
+  buf = pomp_buffer_new_with_data(big, 100);
+  CHECK(buf->data == buf->inlinedata && buf->len == 100);
+  pomp_buffer_unref(buf);
+  buf = pomp_buffer_new_with_data(big, sizeof(big));
+  CHECK(buf->data != buf->inlinedata && buf->len == sizeof(big));
+  CHECK(memcmp(buf->data, big, sizeof(big)) == 0);
+  pomp_buffer_unref(buf);
+}
+
+/* Encode then decode messages, a new pomp_msg each time as the decoder hands
+ * out : allocations and time per message */
+static void workload(const char* name, size_t payload, size_t expectedAllocs)
+{
+  std::vector<uint8_t> blob(payload);
+  size_t allocs = allocCount;
+  double start = testSeconds();
+  bool same = true;
+
+  for (size_t i = 0; i < blob.size(); i++) {
+    blob[i] = pattern(i);
+  }
+  for (int i = 0; i < WORKLOAD_MESSAGES; i++) {
+    struct pomp_msg* msg = pomp_msg_new();
+    pomp_msg_write(msg, 1, "%u%u%lf%lf%f%p%u", 7u, (uint32_t)i, 45.6, 5.8, 1000.0f, (void*)blob.data(), (uint32_t)blob.size());
+    uint32_t session;
+    uint32_t seq;
+    double lat;
+    double lon;
+    float alt;
+    void* data;
+    unsigned int len;
+    pomp_msg_read(msg, "%u%u%lf%lf%f%p%u", &session, &seq, &lat, &lon, &alt, &data, &len);
+    same = same && seq == (uint32_t)i && len == payload && memcmp(data, blob.data(), len) == 0;
+    pomp_msg_destroy(msg);
+  }
+  double elapsed = testSeconds() - start;
+  double perMessage = (double)(allocCount - allocs) / WORKLOAD_MESSAGES;
+
+  CHECK(same);
+  CHECK(perMessage == expectedAllocs);
+  printf("%s (%zu bytes of payload) : %.0f allocations per message, %.0f ns/message\n",
+    name, payload, perMessage, elapsed * 1e9 / WORKLOAD_MESSAGES);
+}
+
+int main()
+{
+  spill();
+  // Device : MSG_GPS sized, the message and its buffer structure only
+  workload("device", 16, 2);
+  // Ground : larger than the inline storage, data spills to the heap
+  workload("ground", 1024, 3);
+  return TEST_END();
+}
@@ -0,0 +1,200 @@
+#include <libpomp.h>
+#include <pomp_priv.h>
+#include <string.h>
+#include <vector>
+#include "test.h"
+#include "AllocCounter.h"
+
+/* Same layout as MSG_GPS : session, sequence, FORMAT_MSG_GPS */
+static const char FORMAT_GPS[] = "%u%u%lf%lf%f%f%f%f%f%f%d%llu";
+static const int CAPTURE_MESSAGES = 200000;
+
+typedef struct {
+  uint32_t session;
+  uint32_t seq;
+  double latitude;
+  double longitude;
+  float altitude;
+  float northSpeed;
+  float eastSpeed;
+  float downSpeed;
+  float hAccuracy;
+  float vAccuracy;
+  int32_t fixType;
+  uint64_t time;
+} Gps_t;
+
+static Gps_t sample(uint32_t i)
+{
+  Gps_t gps = {7, i, 45.6 + i * 1e-7, 5.8 - i * 1e-7, 1000.5f + i % 100, 1.5f, -2.5f, 0.25f, 2, 3, (int32_t)(i % 4), 1000000ull * i};
+  return gps;
+}
+
+static bool sameGps(const Gps_t& a, const Gps_t& b)
+{
+  return a.session == b.session && a.seq == b.seq && a.latitude == b.latitude && a.longitude == b.longitude
+    && a.altitude == b.altitude && a.northSpeed == b.northSpeed && a.eastSpeed == b.eastSpeed
+    && a.downSpeed == b.downSpeed && a.hAccuracy == b.hAccuracy && a.vAccuracy == b.vAccuracy
+    && a.fixType == b.fixType && a.time == b.time;
+}
+
+static void roundTrip()
+{
+  // Every type the encoder writes, read back in place
+  struct pomp_msg* msg = pomp_msg_new();
+  uint8_t blob[300];
+  for (size_t i = 0; i < sizeof(blob); i++) {
+    blob[i] = (uint8_t)(i * 7);
+  }
+  CHECK(pomp_msg_write(msg, 42, "%hhd%hhu%hd%hu%d%u%lld%llu%s%p%u%f%lf",
+    (int8_t)-100, (uint8_t)200, (int16_t)-30000, (uint16_t)60000, -2000000000, 4000000000u,
+    -(1ll << 60), 1ull << 63, "tracker", (void*)blob, (uint32_t)sizeof(blob), 1.25f, -3.5e100) == 0);
+
+  const void* data;
+  size_t len;
+  pomp_buffer_get_cdata(pomp_msg_get_buffer(msg), &data, &len, NULL);
+
+  struct pomp_decoder dec = POMP_DECODER_INITIALIZER;
+  uint32_t msgid = 0;
+  int8_t i8;
+  uint8_t u8;
+  int16_t i16;
+  uint16_t u16;
+  int32_t i32;
+  uint32_t u32;
+  long long i64;
+  unsigned long long u64;
+  char* str;
+  void* buf;
+  unsigned int bufLen;
+  float f32;
+  double f64;
+  CHECK(pomp_decoder_init_with_data(&dec, data, len + 10, &msgid) == (int)len);
+  CHECK(msgid == 42);
+  CHECK(pomp_decoder_read(&dec, "%hhd%hhu%hd%hu%d%u%lld%llu%ms%p%u%f%lf",
+    &i8, &u8, &i16, &u16, &i32, &u32, &i64, &u64, &str, &buf, &bufLen, &f32, &f64) == 0);
+  CHECK(i8 == -100 && u8 == 200 && i16 == -30000 && u16 == 60000);
+  CHECK(i32 == -2000000000 && u32 == 4000000000u);
+  CHECK(i64 == -(1ll << 60) && u64 == 1ull << 63);
+  CHECK(strcmp(str, "tracker") == 0);
+  CHECK(bufLen == sizeof(blob) && memcmp(buf, blob, sizeof(blob)) == 0);
+  CHECK(f32 == 1.25f && f64 == -3.5e100);
+  // No copy : strings and buffers point into the received data
+  CHECK((const uint8_t*)str > (const uint8_t*)data && (const uint8_t*)str < (const uint8_t*)data + len);
+  CHECK((const uint8_t*)buf > (const uint8_t*)data && (const uint8_t*)buf < (const uint8_t*)data + len);
+  // Past the end
+  CHECK(pomp_decoder_read_u8(&dec, &u8) < 0);
+  pomp_decoder_clear(&dec);
+
+  // The message API reads through the same decoder
+  CHECK(pomp_msg_read(msg, "%hhd%hhu", &i8, &u8) == 0 && i8 == -100 && u8 == 200);
+  // Types are checked against the data
+  CHECK(pomp_msg_read(msg, "%hhu", &u8) < 0);
+
+  // Header checks
+  std::vector<uint8_t> copy((const uint8_t*)data, (const uint8_t*)data + len);
+  CHECK(pomp_decoder_init_with_data(&dec, copy.data(), POMP_PROT_HEADER_SIZE - 1, NULL) == -EAGAIN);
+  CHECK(pomp_decoder_init_with_data(&dec, copy.data(), len - 1, NULL) == -EAGAIN);
+  copy[0] = 'X';
+  CHECK(pomp_decoder_init_with_data(&dec, copy.data(), len, NULL) == -EINVAL);
+  copy[0] = 'P';
+  copy[8] = 4;
+  copy[9] = copy[10] = copy[11] = 0;
+  CHECK(pomp_decoder_init_with_data(&dec, copy.data(), len, NULL) == -EINVAL);
+
+  // A field cut by the message size is refused
+  copy.assign((const uint8_t*)data, (const uint8_t*)data + len);
+  uint32_t size = 20;
+  memcpy(&copy[8], &size, 4);
+  CHECK(pomp_decoder_init_with_data(&dec, copy.data(), len, NULL) == 20);
+  CHECK(pomp_decoder_read(&dec, "%hhd%hhu%hd%hu%d%u%lld", &i8, &u8, &i16, &u16, &i32, &u32, &i64) < 0);
+  pomp_msg_destroy(msg);
+}
+
+static std::vector<uint8_t> capture()
+{
+  std::vector<uint8_t> stream;
+  struct pomp_msg* msg = pomp_msg_new();
+
+  for (int i = 0; i < CAPTURE_MESSAGES; i++) {
+    Gps_t g = sample(i);
+    const void* data;
+    size_t len;
+    pomp_msg_clear(msg);
+    pomp_msg_write(msg, 1, FORMAT_GPS, g.session, g.seq, g.latitude, g.longitude, g.altitude, g.northSpeed,
+      g.eastSpeed, g.downSpeed, g.hAccuracy, g.vAccuracy, g.fixType, (unsigned long long)g.time);
+    pomp_buffer_get_cdata(pomp_msg_get_buffer(msg), &data, &len, NULL);
+    stream.insert(stream.end(), (const uint8_t*)data, (const uint8_t*)data + len);
+  }
+  pomp_msg_destroy(msg);
+  return stream;
+}
+
+static void benchmark()
+{
+  // Large capture decoded twice : the stream decoder copying each message
+  // into a pomp_msg, then the decoder reading the capture in place
+  std::vector<uint8_t> stream = capture();
+  Gps_t g;
+  unsigned long long time;
+  int copied = 0;
+  int inPlace = 0;
+  bool same = true;
+
+  struct pomp_prot* prot = pomp_prot_new();
+  size_t allocs = allocCount;
+  double start = testSeconds();
+  size_t off = 0;
+  while (off < stream.size()) {
+    struct pomp_msg* msg = NULL;
+    ssize_t n = pomp_prot_decode_msg(prot, stream.data() + off, stream.size() - off, &msg);
+    if (n <= 0) {
+      break;
+    }
+    off += n;
+    if (msg != NULL) {
+      pomp_msg_read(msg, FORMAT_GPS, &g.session, &g.seq, &g.latitude, &g.longitude, &g.altitude, &g.northSpeed,
+        &g.eastSpeed, &g.downSpeed, &g.hAccuracy, &g.vAccuracy, &g.fixType, &time);
+      g.time = time;
+      same = same && sameGps(g, sample(copied));
+      copied++;
+      pomp_prot_release_msg(prot, msg);
+    }
+  }
+  double copyTime = testSeconds() - start;
+  size_t copyAllocs = allocCount - allocs;
+  pomp_prot_destroy(prot);
+
+  allocs = allocCount;
+  start = testSeconds();
+  off = 0;
+  while (off < stream.size()) {
+    struct pomp_decoder dec = POMP_DECODER_INITIALIZER;
+    int n = pomp_decoder_init_with_data(&dec, stream.data() + off, stream.size() - off, NULL);
+    if (n <= 0) {
+      break;
+    }
+    off += n;
+    pomp_decoder_read(&dec, FORMAT_GPS, &g.session, &g.seq, &g.latitude, &g.longitude, &g.altitude, &g.northSpeed,
+      &g.eastSpeed, &g.downSpeed, &g.hAccuracy, &g.vAccuracy, &g.fixType, &time);
+    g.time = time;
+    same = same && sameGps(g, sample(inPlace));
+    inPlace++;
+  }
+  double inPlaceTime = testSeconds() - start;
+  size_t inPlaceAllocs = allocCount - allocs;
+
+  CHECK(copied == CAPTURE_MESSAGES);
+  CHECK(inPlace == CAPTURE_MESSAGES);
+  CHECK(same);
+  CHECK(inPlaceAllocs == 0);
+  printf("%d messages, %zu bytes : copy %.0f ns/message (%zu allocations), in place %.0f ns/message (%zu allocations)\n",
+    CAPTURE_MESSAGES, stream.size(), copyTime * 1e9 / copied, copyAllocs, inPlaceTime * 1e9 / inPlace, inPlaceAllocs);
+}
+
+int main()
+{
+  roundTrip();
+  benchmark();
+  return TEST_END();
+}
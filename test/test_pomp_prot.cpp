@@ -0,0 +1,204 @@
+#include <libpomp.h>
+#include <pomp_priv.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "test.h"
+#include "AllocCounter.h"
+
+static const char FORMAT[] = "%u%u%lf%lf%f";
+static const int STREAM_MESSAGES = 2000000;
+static const int BATCH = 16;
+
+static std::vector<uint8_t> encode(int count)
+{
+  std::vector<uint8_t> stream;
+  struct pomp_msg* msg = pomp_msg_new();
+
+  for (int i = 0; i < count; i++) {
+    const void* data;
+    size_t len;
+    pomp_msg_clear(msg);
+    pomp_msg_write(msg, 1, FORMAT, 7u, (uint32_t)i, 45.6, 5.8, 1000.0f);
+    pomp_buffer_get_cdata(pomp_msg_get_buffer(msg), &data, &len, NULL);
+    stream.insert(stream.end(), (const uint8_t*)data, (const uint8_t*)data + len);
+  }
+  pomp_msg_destroy(msg);
+  return stream;
+}
+
+static uint32_t seqOf(struct pomp_msg* msg)
+{
+  uint32_t session = 0;
+  uint32_t seq = 0;
+  pomp_msg_read(msg, "%u%u", &session, &seq);
+  return seq;
+}
+
+/* Decode up to count messages from the stream, fed chunk bytes at a time */
+static size_t decode(struct pomp_prot* prot, const std::vector<uint8_t>& stream, size_t* off,
+  std::vector<struct pomp_msg*>& out, size_t count, size_t chunk)
+{
+  while (out.size() < count && *off < stream.size()) {
+    struct pomp_msg* msg = NULL;
+    size_t len = stream.size() - *off < chunk ? stream.size() - *off : chunk;
+    ssize_t n = pomp_prot_decode_msg(prot, stream.data() + *off, len, &msg);
+    if (n <= 0) {
+      break;
+    }
+    *off += n;
+    if (msg != NULL) {
+      out.push_back(msg);
+    }
+  }
+  return out.size();
+}
+
+static void pool()
+{
+  std::vector<uint8_t> stream = encode(64);
+  std::vector<struct pomp_msg*> held;
+  size_t off = 0;
+  struct pomp_prot* prot = pomp_prot_new();
+
+  // Pre-sized pool : holding up to its size costs no allocation
+  CHECK(pomp_prot_set_pool(prot, 8, 256) == 0);
+  size_t allocs = allocCount;
+  CHECK(decode(prot, stream, &off, held, 8, 7) == 8);
+  CHECK(allocCount == allocs);
+  for (size_t i = 0; i < held.size(); i++) {
+    CHECK(seqOf(held[i]) == i);
+  }
+
+  // Released messages come back with their buffer
+  std::vector<struct pomp_msg*> first = held;
+  for (size_t i = 0; i < held.size(); i++) {
+    CHECK(pomp_prot_release_msg(prot, held[i]) == 0);
+  }
+  held.clear();
+  CHECK(decode(prot, stream, &off, held, 8, 1000) == 8);
+  CHECK(allocCount == allocs);
+  CHECK(reallocCount == 0);
+  for (size_t i = 0; i < held.size(); i++) {
+    CHECK(seqOf(held[i]) == 8 + i);
+    bool reused = false;
+    for (size_t j = 0; j < first.size(); j++) {
+      reused = reused || held[i] == first[j];
+    }
+    CHECK(reused);
+  }
+
+  // Beyond the pool : new messages, and the extra ones are freed on release
+  CHECK(decode(prot, stream, &off, held, 12, 1000) == 12);
+  CHECK(allocCount == allocs + 2 * 4);
+  size_t frees = freeCount;
+  for (size_t i = 0; i < held.size(); i++) {
+    pomp_prot_release_msg(prot, held[i]);
+  }
+  held.clear();
+  CHECK(freeCount == frees + 2 * 4);
+
+  // A message still referenced elsewhere keeps its buffer, the pool takes a new one
+  CHECK(decode(prot, stream, &off, held, 1, 1000) == 1);
+  struct pomp_buffer* shared = pomp_msg_get_buffer(held[0]);
+  pomp_buffer_ref(shared);
+  pomp_prot_release_msg(prot, held[0]);
+  held.clear();
+  CHECK(decode(prot, stream, &off, held, 1, 1000) == 1);
+  CHECK(pomp_msg_get_buffer(held[0]) != shared);
+  CHECK(seqOf(held[0]) == 21);
+  pomp_buffer_unref(shared);
+  pomp_prot_release_msg(prot, held[0]);
+  pomp_prot_destroy(prot);
+}
+
+/* Messages held in batches then released : allocations and throughput */
+static void stream(const std::vector<uint8_t>& data, uint32_t poolSize, bool threaded)
+{
+  struct pomp_prot* prot = pomp_prot_new();
+  std::deque<struct pomp_msg*> queue;
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::condition_variable drained;
+  bool done = false;
+  int released = 0;
+  bool ordered = true;
+
+  pomp_prot_set_pool(prot, poolSize, 0);
+  // Another thread releases, the decoder takes the messages back in bulk
+  std::thread consumer([&]() {
+    uint32_t expected = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!done || !queue.empty()) {
+      ready.wait(lock, [&]() { return done || !queue.empty(); });
+      while (!queue.empty()) {
+        struct pomp_msg* msg = queue.front();
+        queue.pop_front();
+        ordered = ordered && seqOf(msg) == expected++;
+        pomp_prot_release_msg(prot, msg);
+        released++;
+      }
+      drained.notify_one();
+    }
+  });
+
+  size_t allocs = allocCount;
+  double start = testSeconds();
+  std::vector<struct pomp_msg*> held;
+  size_t off = 0;
+  uint32_t expected = 0;
+  while (off < data.size()) {
+    held.clear();
+    decode(prot, data, &off, held, BATCH, 4096);
+    if (threaded) {
+      // Bounded queue, as between two stages of a pipeline
+      std::unique_lock<std::mutex> lock(mutex);
+      drained.wait(lock, [&]() { return queue.size() < 2 * BATCH; });
+      queue.insert(queue.end(), held.begin(), held.end());
+      ready.notify_one();
+    } else {
+      for (size_t i = 0; i < held.size(); i++) {
+        ordered = ordered && seqOf(held[i]) == expected++;
+        pomp_prot_release_msg(prot, held[i]);
+        released++;
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    ready.notify_one();
+  }
+  consumer.join();
+  double elapsed = testSeconds() - start;
+  size_t allocations = allocCount - allocs;
+
+  CHECK(released == STREAM_MESSAGES);
+  CHECK(ordered);
+  // Two allocations per message in flight at most
+  if (poolSize >= BATCH && !threaded) {
+    CHECK(allocations <= 2 * BATCH);
+  }
+  if (threaded) {
+    CHECK(allocations <= 2 * poolSize);
+  }
+  printf("pool of %u, batches of %d%s : %zu allocations for %d messages, %.1f M messages/s\n",
+    poolSize, BATCH, threaded ? ", released from another thread" : "", allocations, released,
+    released / elapsed / 1e6);
+  pomp_prot_destroy(prot);
+}
+
+int main()
+{
+  pool();
+  std::vector<uint8_t> data = encode(STREAM_MESSAGES);
+  stream(data, 1, false);
+  stream(data, BATCH, false);
+  stream(data, 4 * BATCH, true);
+  // Everything decoded went back to the heap
+  CHECK(allocCount == freeCount);
+  return TEST_END();
+}
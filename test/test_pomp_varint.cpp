@@ -0,0 +1,156 @@
+#include <libpomp.h>
+#include <pomp_priv.h>
+#include <string.h>
+#include <vector>
+#include "test.h"
+#include "AllocCounter.h"
+
+static const size_t BENCHMARK_VALUES = 1 << 20;
+static const int BENCHMARK_RUNS = 20;
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+/* Values of a given encoded size, 0 for a mix of every size */
+static std::vector<uint32_t> values(size_t count, int bytes)
+{
+  static const uint32_t limits[] = {1u << 7, 1u << 14, 1u << 21, 1u << 28};
+  std::vector<uint32_t> v(count);
+  for (size_t i = 0; i < count; i++) {
+    int n = bytes != 0 ? bytes : 1 + random32() % 5;
+    uint32_t low = n == 1 ? 0 : limits[n - 2];
+    uint32_t high = n == 5 ? 0xffffffff : limits[n - 1] - 1;
+    v[i] = low + random32() % (high - low);
+  }
+  return v;
+}
+
+/* One value at a time, as the message encoder writes integers */
+static std::vector<uint8_t> reference(const std::vector<uint32_t>& v)
+{
+  std::vector<uint8_t> out(v.size() * 5);
+  size_t n = 0;
+  for (size_t i = 0; i < v.size(); i++) {
+    n += pomp_varint_encode(out.data() + n, v[i]);
+  }
+  out.resize(n);
+  return out;
+}
+
+static bool roundTrip(const std::vector<uint32_t>& v)
+{
+  std::vector<uint8_t> expected = reference(v);
+  std::vector<uint8_t> encoded(v.size() * 5 + 1);
+  size_t len = pomp_varint_encode_u32_array(v.data(), v.size(), encoded.data());
+  if (len != expected.size() || memcmp(encoded.data(), expected.data(), len) != 0) {
+    return false;
+  }
+  // Exact size : the blocks must not read past the data
+  std::vector<uint8_t> exact(expected);
+  std::vector<uint32_t> decoded(v.size());
+  int res = pomp_varint_decode_u32_array(exact.data(), exact.size(), decoded.data(), decoded.size());
+  return res == (int)len && decoded == v;
+}
+
+static void unsignedArrays()
+{
+  // Every size, lengths around the 8 and 16 value blocks
+  size_t lengths[] = {0, 1, 7, 8, 9, 15, 16, 17, 31, 33, 100, 1000};
+  for (int bytes = 0; bytes <= 5; bytes++) {
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+      CHECK(roundTrip(values(lengths[l], bytes)));
+    }
+  }
+
+  // Runs of small values broken by large ones at every position
+  for (size_t at = 0; at < 40; at++) {
+    std::vector<uint32_t> v = values(40, 1);
+    v[at] = 0xffffffff;
+    CHECK(roundTrip(v));
+    v = values(40, 2);
+    v[at] = 5;
+    CHECK(roundTrip(v));
+  }
+
+  // Errors : truncated data, more than 32 bits
+  std::vector<uint32_t> v = values(64, 2);
+  std::vector<uint8_t> encoded = reference(v);
+  std::vector<uint32_t> decoded(v.size());
+  CHECK(pomp_varint_decode_u32_array(encoded.data(), encoded.size() - 1, decoded.data(), v.size()) == -EINVAL);
+  uint8_t tooLong[] = {0xff, 0xff, 0xff, 0xff, 0x1f};
+  CHECK(pomp_varint_decode_u32_array(tooLong, sizeof(tooLong), decoded.data(), 1) == -EINVAL);
+  uint8_t max[] = {0xff, 0xff, 0xff, 0xff, 0x0f};
+  CHECK(pomp_varint_decode_u32_array(max, sizeof(max), decoded.data(), 1) == 5 && decoded[0] == 0xffffffff);
+}
+
+static void signedArrays()
+{
+  std::vector<int32_t> v(1000);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = (int32_t)random32() >> (random32() % 32);
+  }
+  v[0] = INT32_MIN;
+  v[1] = INT32_MAX;
+  v[2] = -1;
+  v[3] = 0;
+
+  // Zigzag keeps small negative values short, in place as well
+  std::vector<uint32_t> zigzag(v.size());
+  pomp_varint_zigzag_encode_i32_array(v.data(), zigzag.data(), v.size());
+  CHECK(zigzag[2] == 1 && zigzag[3] == 0 && zigzag[0] == 0xffffffff && zigzag[1] == 0xfffffffe);
+  std::vector<int32_t> back(v.size());
+  pomp_varint_zigzag_decode_i32_array(zigzag.data(), back.data(), v.size());
+  CHECK(back == v);
+  pomp_varint_zigzag_decode_i32_array(zigzag.data(), (int32_t*)zigzag.data(), v.size());
+  CHECK(memcmp(zigzag.data(), v.data(), v.size() * 4) == 0);
+
+  for (size_t count = 0; count <= v.size(); count += count < 40 ? 1 : 241) {
+    std::vector<uint8_t> encoded(count * 5);
+    std::vector<int32_t> decoded(count);
+    size_t len = pomp_varint_encode_i32_array(v.data(), count, encoded.data());
+    CHECK(pomp_varint_decode_i32_array(encoded.data(), len, decoded.data(), count) == (int)len);
+    CHECK(std::vector<int32_t>(v.begin(), v.begin() + count) == decoded);
+  }
+}
+
+static void benchmark(const char* name, int bytes)
+{
+  std::vector<uint32_t> v = values(BENCHMARK_VALUES, bytes);
+  std::vector<uint8_t> encoded(v.size() * 5);
+  std::vector<uint32_t> decoded(v.size());
+  size_t len = 0;
+  size_t allocs = allocCount;
+
+  double start = testSeconds();
+  for (int run = 0; run < BENCHMARK_RUNS; run++) {
+    len = pomp_varint_encode_u32_array(v.data(), v.size(), encoded.data());
+  }
+  double encodeTime = testSeconds() - start;
+  start = testSeconds();
+  for (int run = 0; run < BENCHMARK_RUNS; run++) {
+    pomp_varint_decode_u32_array(encoded.data(), len, decoded.data(), decoded.size());
+  }
+  double decodeTime = testSeconds() - start;
+
+  CHECK(decoded == v);
+  CHECK(allocCount == allocs);
+  double total = (double)BENCHMARK_VALUES * BENCHMARK_RUNS;
+  printf("%s : encode %.0f M integers/s, decode %.0f M integers/s\n", name, total / encodeTime / 1e6, total / decodeTime / 1e6);
+}
+
+int main()
+{
+  unsignedArrays();
+  signedArrays();
+  benchmark("1 byte values", 1);
+  benchmark("2 byte values", 2);
+  benchmark("mixed sizes", 0);
+  return TEST_END();
+}
@@ -0,0 +1,218 @@
+#include <SequenceTracker.h>
+#include <vector>
+#include "test.h"
+
+static const uint32_t WINDOW = SequenceTracker::WINDOW;
+static const uint64_t PERIOD = 40000; /* [us] 25 Hz */
+static const uint32_t BENCHMARK_PACKETS = 10000000;
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+/* Numbers from first to last, every one received at a steady rate */
+static void run(SequenceTracker& t, uint32_t session, uint32_t first, uint32_t count, uint64_t* time)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    t.update(session, first + i, *time);
+    *time += PERIOD;
+  }
+}
+
+static void inOrder()
+{
+  SequenceTracker t;
+  uint64_t time = 1;
+  run(t, 7, 0, 10000, &time);
+  SequenceStats_t s = t.getStats();
+  CHECK(s.received == 10000 && s.lost == 0 && s.duplicates == 0 && s.reordered == 0 && s.late == 0);
+  CHECK(s.sessions == 1);
+  // Steady rate : no jitter
+  CHECK(s.jitter == 0);
+}
+
+static void loss()
+{
+  // Every 10th lost : counted once out of the window
+  SequenceTracker t;
+  uint64_t time = 1;
+  for (uint32_t seq = 0; seq < 10000; seq++) {
+    if (seq % 10 != 5) {
+      t.update(7, seq, time);
+    }
+    time += PERIOD;
+  }
+  CHECK(t.getStats().lost == (10000 - WINDOW) / 10);
+  run(t, 7, 10000, WINDOW, &time);
+  CHECK(t.getStats().lost == 1000);
+  CHECK(t.getStats().received == 9000 + WINDOW);
+
+  // A jump past the window counts everything in between
+  t.reset();
+  t.update(7, 0, 1);
+  t.update(7, 5000, 2);
+  run(t, 7, 5001, WINDOW, &time);
+  CHECK(t.getStats().lost == 4999);
+}
+
+static void wrap()
+{
+  // Across 2^32, with a gap on each side of the wrap
+  SequenceTracker t;
+  uint64_t time = 1;
+  uint32_t first = 0xffffff00;
+  for (uint32_t i = 0; i < 0x300; i++) {
+    uint32_t seq = first + i;
+    if (seq != 0xfffffffe && seq != 1) {
+      t.update(7, seq, time);
+    }
+    time += PERIOD;
+  }
+  SequenceStats_t s = t.getStats();
+  CHECK(s.lost == 2 && s.late == 0 && s.reordered == 0 && s.received == 0x300 - 2);
+  CHECK(s.sessions == 1);
+}
+
+static void reorder()
+{
+  // Pairs swapped, then one held back by depth numbers
+  SequenceTracker t;
+  uint64_t time = 1;
+  t.update(7, 0, time);
+  for (uint32_t seq = 1; seq < 1000; seq += 2) {
+    time += 2 * PERIOD;
+    t.update(7, seq + 1, time);
+    t.update(7, seq, time);
+  }
+  SequenceStats_t s = t.getStats();
+  CHECK(s.reordered == 500 && s.maxReorderDepth == 1 && s.duplicates == 0);
+  const uint32_t depth = 100;
+  for (uint32_t seq = 1002; seq <= 1001 + depth; seq++) {
+    t.update(7, seq, time);
+  }
+  t.update(7, 1001, time);
+  run(t, 7, 1002 + depth, WINDOW, &time);
+  s = t.getStats();
+  CHECK(s.reordered == 501 && s.maxReorderDepth == depth);
+  CHECK(s.lost == 0 && s.received == 1002 + depth + WINDOW);
+}
+
+static void duplicates()
+{
+  SequenceTracker t;
+  uint64_t time = 1;
+  run(t, 7, 0, 100, &time);
+  t.update(7, 99, time);
+  t.update(7, 50, time);
+  t.update(7, 50, time);
+  SequenceStats_t s = t.getStats();
+  CHECK(s.duplicates == 3 && s.received == 100 && s.reordered == 0);
+
+  // Out of the window : late, whether it was counted lost or not
+  run(t, 7, 100, 2 * WINDOW, &time);
+  t.update(7, 150, time);
+  s = t.getStats();
+  CHECK(s.late == 1 && s.duplicates == 3);
+  // Oldest number still in the window
+  t.update(7, 100 + 2 * WINDOW - WINDOW, time);
+  s = t.getStats();
+  CHECK(s.late == 1 && s.duplicates == 4 && s.lost == 0);
+}
+
+static void sessions()
+{
+  // Reboot : a new session from 0, nothing counted lost or late
+  SequenceTracker t;
+  uint64_t time = 1;
+  run(t, 7, 0, 5000, &time);
+  run(t, 8, 0, 1000, &time);
+  SequenceStats_t s = t.getStats();
+  CHECK(s.sessions == 2 && s.received == 6000 && s.lost == 0 && s.late == 0 && s.duplicates == 0);
+
+  // The same numbers again in the new session are not duplicates
+  run(t, 9, 0, 1000, &time);
+  s = t.getStats();
+  CHECK(s.sessions == 3 && s.received == 7000 && s.duplicates == 0);
+
+  // A session starting anywhere counts from there
+  run(t, 10, 123456789, 100, &time);
+  CHECK(t.getStats().lost == 0 && t.getStats().sessions == 4);
+}
+
+static void jitter()
+{
+  // 30 / 50 ms alternating around 40 ms : 10 ms deviation
+  SequenceTracker t;
+  uint64_t time = 1;
+  for (uint32_t seq = 0; seq < 1000; seq++) {
+    t.update(7, seq, time);
+    time += seq % 2 == 0 ? 30000 : 50000;
+  }
+  uint32_t j = t.getStats().jitter;
+  CHECK(j > 9000 && j < 11000);
+}
+
+/* Per packet cost on a lossy, reordered stream */
+static void benchmark()
+{
+  // Sent in order, 1 % lost, 5 % delivered up to 8 numbers late
+  std::vector<uint32_t> stream;
+  stream.reserve(BENCHMARK_PACKETS);
+  std::vector<uint32_t> held;
+  uint32_t lost = 0;
+  uint32_t seq;
+  for (seq = 0; stream.size() + held.size() < BENCHMARK_PACKETS; seq++) {
+    // The first one opens the session
+    uint32_t r = seq == 0 ? 99 : random32() % 100;
+    if (r == 0) {
+      lost++;
+      continue;
+    }
+    if (r < 6) {
+      held.push_back(seq);
+      continue;
+    }
+    stream.push_back(seq);
+    if (!held.empty() && seq - held.front() >= 1 + random32() % 8) {
+      stream.push_back(held.front());
+      held.erase(held.begin());
+    }
+  }
+  stream.insert(stream.end(), held.begin(), held.end());
+
+  SequenceTracker t;
+  double start = testSeconds();
+  for (size_t i = 0; i < stream.size(); i++) {
+    t.update(7, stream[i], i * PERIOD);
+  }
+  double elapsed = testSeconds() - start;
+  // Flush the window so every loss is accounted
+  uint64_t time = stream.size() * PERIOD;
+  run(t, 7, seq, WINDOW, &time);
+
+  SequenceStats_t s = t.getStats();
+  CHECK(s.received == stream.size() + WINDOW);
+  CHECK(s.duplicates == 0 && s.late == 0);
+  CHECK(s.lost == lost);
+  printf("%zu packets : %.1f ns/packet, %u lost, %u reordered, depth %u\n",
+    stream.size(), elapsed * 1e9 / stream.size(), s.lost, s.reordered, s.maxReorderDepth);
+}
+
+int main()
+{
+  inOrder();
+  loss();
+  wrap();
+  reorder();
+  duplicates();
+  sessions();
+  jitter();
+  benchmark();
+  return TEST_END();
+}
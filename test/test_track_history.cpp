@@ -0,0 +1,249 @@
+#include <TrackHistory.h>
+#include <libpomp.h>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include "test.h"
+
+static const double LAT0 = 45.6;
+static const double LON0 = 5.8;
+static const double M_PER_DEG = 111319.5;
+/* As in main.cpp */
+static const float TRACK_TOLERANCE = 5;
+static const size_t TRACK_FLUSH_SIZE = 200;
+/* A /log.csv export, TRACK_CSV=path runs the benchmark on another one */
+static const char RECORDED_TRACK[] = "data/track.csv";
+static const int BENCHMARK_PASSES = 200;
+
+typedef struct {
+  uint32_t iTOW;
+  double x;   /* [m] east of LAT0, LON0 */
+  double y;   /* [m] north */
+} Point_t;
+
+static GPSData_t fix(uint32_t iTOW, double x, double y)
+{
+  GPSData_t data = {};
+  data.iTOW = iTOW;
+  data.latitude = (LAT0 + y / M_PER_DEG) * 1e7;
+  data.longitude = (LON0 + x / (M_PER_DEG * cos(LAT0 * M_PI / 180))) * 1e7;
+  data.altitude = 1000000;
+  return data;
+}
+
+/* Oldest points, at most maxLen packed bytes, added to bytes */
+static std::vector<Point_t> unpack(TrackHistory& track, size_t maxLen = 1 << 16, size_t* bytes = NULL)
+{
+  static uint8_t packed[1 << 16];
+  size_t count;
+  size_t len = track.pack(packed, maxLen, &count);
+  std::vector<int32_t> values(count * TRACK_POINT_FIELDS);
+  std::vector<Point_t> points;
+  int32_t acc[4] = {0, 0, 0, 0};
+
+  pomp_varint_decode_i32_array(packed, len, values.data(), values.size());
+  for (size_t i = 0; i < count; i++) {
+    for (int f = 0; f < 4; f++) {
+      acc[f] += values[i * TRACK_POINT_FIELDS + f];
+    }
+    Point_t p = {(uint32_t)acc[0], (acc[2] / 1e7 - LON0) * M_PER_DEG * cos(LAT0 * M_PI / 180), (acc[1] / 1e7 - LAT0) * M_PER_DEG};
+    points.push_back(p);
+  }
+  track.consume(count);
+  if (bytes != NULL) {
+    *bytes += len;
+  }
+  return points;
+}
+
+/* Largest distance of the fixes to the kept polyline, each fix against the
+ * segment covering its time */
+static double maxDeviation(const std::vector<Point_t>& fixes, const std::vector<Point_t>& kept)
+{
+  double worst = 0;
+  size_t k = 0;
+
+  for (size_t i = 0; i < fixes.size(); i++) {
+    while (k + 2 < kept.size() && kept[k + 1].iTOW <= fixes[i].iTOW) {
+      k++;
+    }
+    const Point_t& a = kept[k];
+    const Point_t& b = kept[k + 1];
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double l = dx * dx + dy * dy;
+    double u = l > 0 ? ((fixes[i].x - a.x) * dx + (fixes[i].y - a.y) * dy) / l : 0;
+    u = u < 0 ? 0 : (u > 1 ? 1 : u);
+    double d = hypot(fixes[i].x - a.x - u * dx, fixes[i].y - a.y - u * dy);
+    worst = d > worst ? d : worst;
+  }
+  return worst;
+}
+
+static void outAndBack()
+{
+  // 1000 m east, back west 3 m further north, 25 Hz
+  TrackHistory track;
+  std::vector<Point_t> fixes;
+  uint32_t iTOW = 100000000;
+
+  track.setTolerance(5, 5);
+  for (int i = 0; i <= 1250; i++, iTOW += 40) {
+    Point_t p = {iTOW, i * 0.8, 0};
+    fixes.push_back(p);
+  }
+  for (int i = 1; i <= 1250; i++, iTOW += 40) {
+    Point_t p = {iTOW, 1000 - i * 0.8, 3};
+    fixes.push_back(p);
+  }
+  for (size_t i = 0; i < fixes.size(); i++) {
+    track.add(fix(fixes[i].iTOW, fixes[i].x, fixes[i].y));
+  }
+
+  std::vector<Point_t> kept = unpack(track);
+  double turnaround = 0;
+  for (size_t i = 0; i < kept.size(); i++) {
+    turnaround = kept[i].x > turnaround ? kept[i].x : turnaround;
+  }
+  CHECK(kept.size() >= 3);
+  CHECK(turnaround > 995);
+  CHECK(maxDeviation(fixes, kept) <= 5.1);
+  printf("out and back : %zu points kept, turnaround at %.1f m, max deviation %.2f m\n",
+    kept.size(), turnaround, maxDeviation(fixes, kept));
+}
+
+static void glider()
+{
+  // 10 min at 25 Hz : straight, thermal circles, gentle turns, 0.5 m noise
+  TrackHistory track;
+  std::vector<Point_t> fixes;
+  double x = 0;
+  double y = 0;
+  double heading = 0;
+  uint32_t seed = 1;
+
+  track.setTolerance(5, 5);
+  for (int i = 0; i < 25 * 600; i++) {
+    double t = i / 25.0;
+    if (t > 120 && t < 360) {
+      heading += 2 * M_PI / 20 / 25;
+    } else if (t >= 360) {
+      heading += 0.002 * sin(t / 10);
+    }
+    x += 12 * cos(heading) / 25;
+    y += 12 * sin(heading) / 25;
+    seed = seed * 1103515245 + 12345;
+    double nx = x + ((seed >> 16) % 1000 / 1000.0 - 0.5);
+    seed = seed * 1103515245 + 12345;
+    double ny = y + ((seed >> 16) % 1000 / 1000.0 - 0.5);
+    Point_t p = {(uint32_t)(100000000 + i * 40), nx, ny};
+    fixes.push_back(p);
+    track.add(fix(p.iTOW, p.x, p.y));
+  }
+
+  std::vector<Point_t> kept = unpack(track);
+  double deviation = maxDeviation(fixes, kept);
+  CHECK(kept.size() < fixes.size() / 50);
+  CHECK(deviation <= 5.1);
+  CHECK(track.size() == 0);
+  printf("glider : %zu of %zu fixes kept, max deviation %.2f m\n", kept.size(), fixes.size(), deviation);
+}
+
+/* PVT records of a /log.csv export, in GPSData_t units */
+static std::vector<GPSData_t> loadTrack(const char* path)
+{
+  std::vector<GPSData_t> fixes;
+  char line[256];
+  FILE* file = fopen(path, "r");
+
+  if (file == NULL) {
+    perror(path);
+    return fixes;
+  }
+  while (fgets(line, sizeof(line), file) != NULL) {
+    unsigned long long page, time;
+    unsigned long iTOW;
+    long lat, lon, height, velN, velE, velD;
+    int numSV;
+    if (sscanf(line, "%llu,pvt,%llu,%lu,%ld,%ld,%ld,%ld,%ld,%ld,%d,", &page, &time, &iTOW,
+          &lat, &lon, &height, &velN, &velE, &velD, &numSV) == 10) {
+      GPSData_t data = {};
+      data.time = time;
+      data.iTOW = iTOW;
+      data.latitude = lat;
+      data.longitude = lon;
+      data.altitude = height;
+      data.northSpeed = velN;
+      data.eastSpeed = velE;
+      data.downSpeed = velD;
+      data.numberSV = numSV;
+      fixes.push_back(data);
+    }
+  }
+  fclose(file);
+  return fixes;
+}
+
+static Point_t toPoint(const GPSData_t& data)
+{
+  Point_t p = {(uint32_t)data.iTOW, (data.longitude / 1e7 - LON0) * M_PER_DEG * cos(LAT0 * M_PI / 180),
+    (data.latitude / 1e7 - LAT0) * M_PER_DEG};
+  return p;
+}
+
+/* Fixes simplified per second and bytes sent per kept point, flushed in
+ * TRACK_FLUSH_SIZE messages as main.cpp does once back online */
+static void recorded()
+{
+  const char* path = getenv("TRACK_CSV") != NULL ? getenv("TRACK_CSV") : RECORDED_TRACK;
+  std::vector<GPSData_t> data = loadTrack(path);
+  CHECK(data.size() > 1000);
+  if (data.size() <= 1000) {
+    return;
+  }
+
+  TrackHistory track;
+  std::vector<Point_t> fixes;
+  std::vector<Point_t> kept;
+  size_t bytes = 0;
+  size_t messages = 0;
+  track.setTolerance(TRACK_TOLERANCE, TRACK_TOLERANCE);
+  for (size_t i = 0; i < data.size(); i++) {
+    fixes.push_back(toPoint(data[i]));
+    track.add(data[i]);
+    while (track.size() >= TRACK_HISTORY_SIZE / 2 || (i == data.size() - 1 && track.size() > 0)) {
+      std::vector<Point_t> points = unpack(track, TRACK_FLUSH_SIZE, &bytes);
+      kept.insert(kept.end(), points.begin(), points.end());
+      messages++;
+    }
+  }
+  CHECK(track.getOverwritten() == 0);
+  double deviation = maxDeviation(fixes, kept);
+  double perPoint = (double)bytes / kept.size();
+  CHECK(deviation <= TRACK_TOLERANCE + 0.1);
+  CHECK(perPoint < sizeof(TrackPoint_t));
+
+  double start = testSeconds();
+  for (int pass = 0; pass < BENCHMARK_PASSES; pass++) {
+    TrackHistory bench;
+    bench.setTolerance(TRACK_TOLERANCE, TRACK_TOLERANCE);
+    for (size_t i = 0; i < data.size(); i++) {
+      bench.add(data[i]);
+    }
+    CHECK(bench.size() > 0);
+  }
+  double elapsed = testSeconds() - start;
+
+  printf("%s : %zu of %zu fixes kept (%.1f %%), max deviation %.2f m, %.1f bytes per point in %zu messages "
+    "(%zu for NAV-PVT, %zu for TrackPoint_t), %.1fM fixes/s\n",
+    path, kept.size(), data.size(), 100.0 * kept.size() / data.size(), deviation, perPoint, messages,
+    (size_t)92, sizeof(TrackPoint_t), data.size() * BENCHMARK_PASSES / elapsed / 1e6);
+}
+
+int main()
+{
+  outAndBack();
+  glider();
+  recorded();
+  return TEST_END();
+}
@@ -0,0 +1,138 @@
+#include <WiFiManager.h>
+#include <DNSServer.h>
+#include <ESP8266WebServer.h>
+#include "test.h"
+
+static const unsigned long SAMPLE_MS = 40;    /* 25 Hz sensors */
+static const unsigned long PASS_MS = 1;       /* Rest of a loop pass */
+static const unsigned long BROWSE_MS = 10000;
+
+/* A phone on the portal : a DNS lookup and a page every REQUEST_MS */
+static const unsigned long REQUEST_MS = 50;
+static const char* const PAGES[] = {"/", "/wifi", "/wm.css", "/wm.js", "/i", "/0wifi", "/generate_204"};
+
+static WiFiManager wm;
+static unsigned long nextSample;
+static unsigned long worstLate;
+static unsigned long worstStall;
+static int samples;
+static int passes;
+static double hostTime;
+static double worstHost;
+
+/* One pass of the main loop : the portal, then the sensors when due */
+static bool pass()
+{
+  unsigned long before = millis();
+  double start = testSeconds();
+  bool closed = wm.process();
+  double host = testSeconds() - start;
+  hostTime += host;
+  worstHost = host > worstHost ? host : worstHost;
+  worstStall = millis() - before > worstStall ? millis() - before : worstStall;
+  passes++;
+
+  if (millis() >= nextSample) {
+    worstLate = millis() - nextSample > worstLate ? millis() - nextSample : worstLate;
+    samples++;
+    nextSample += SAMPLE_MS;
+  }
+  delay(PASS_MS);
+  return closed;
+}
+
+static void browse()
+{
+  int requested = 0;
+  unsigned long end = millis() + BROWSE_MS;
+  unsigned long nextRequest = millis();
+  while (millis() < end) {
+    if (millis() >= nextRequest) {
+      const char* page = PAGES[requested % (sizeof(PAGES) / sizeof(PAGES[0]))];
+      // OS connectivity checks ask for their own host
+      ESP8266WebServer::request(page, strcmp(page, "/generate_204") == 0 ? "connectivitycheck.gstatic.com" : "192.168.4.1");
+      DNSServer::pending++;
+      requested++;
+      nextRequest += REQUEST_MS;
+    }
+    CHECK(!pass());
+  }
+
+  // A burst is served one request per pass
+  for (int i = 0; i < 20; i++) {
+    ESP8266WebServer::request("/");
+    DNSServer::pending++;
+  }
+  requested += 20;
+  size_t served = ESP8266WebServer::responses.size();
+  pass();
+  CHECK(ESP8266WebServer::responses.size() == served + 1);
+  for (int i = 0; i < 19; i++) {
+    pass();
+  }
+
+  CHECK(ESP8266WebServer::pending.empty());
+  CHECK((int)ESP8266WebServer::responses.size() == requested);
+  CHECK(DNSServer::pending == 0 && DNSServer::answered == requested);
+  for (size_t i = 0; i < ESP8266WebServer::responses.size(); i++) {
+    const ESP8266WebServer::Response_t& r = ESP8266WebServer::responses[i];
+    CHECK(r.code == (r.uri == "/generate_204" ? 302 : 200));
+    if (r.uri == "/wm.css") {
+      CHECK(r.headers.find("Content-Encoding: gzip") != std::string::npos);
+      CHECK(r.body.size() == sizeof(WM_STYLE_GZ) && memcmp(r.body.data(), WM_STYLE_GZ, sizeof(WM_STYLE_GZ)) == 0);
+    }
+    if (r.uri == "/") {
+      // Pages are streamed : several writes, closed by the html end
+      CHECK(r.sends > 2);
+      CHECK(r.body.find(HTTP_END) == r.body.size() - strlen(HTTP_END));
+    }
+  }
+  // The background scan has been served by now
+  const ESP8266WebServer::Response_t& wifi = ESP8266WebServer::responses[1];
+  CHECK(wifi.body.find("Scanning") != std::string::npos);
+  const ESP8266WebServer::Response_t& later = ESP8266WebServer::responses[1 + 7 * 10];
+  CHECK(later.uri == "/wifi" && later.body.find(">home<") != std::string::npos);
+}
+
+static void save()
+{
+  // Credentials saved : the portal closes once connected, the loop goes on
+  ESP8266WebServer::request("/wifisave?s=home&p=secret");
+  unsigned long start = millis();
+  bool closed = false;
+  while (!closed && millis() - start < 30000) {
+    closed = pass();
+  }
+  CHECK(closed);
+  CHECK(!wm.isConfigPortalActive());
+  CHECK(WiFi.status() == WL_CONNECTED);
+  CHECK(WiFi.SSID() == "home" && WiFi.psk() == "secret");
+  // 2 s for the save page to get out, then scan, association and DHCP
+  unsigned long expected = 2000 + WiFi.scanMs + WiFi.associateMs + WiFi.dhcpMs;
+  CHECK(millis() - start >= expected && millis() - start <= expected + 3 * PASS_MS);
+  printf("connected %lu ms after the save\n", millis() - start);
+}
+
+int main()
+{
+  ESP8266WiFiClass::AccessPoint_t home = {"home", {0x10, 0x20, 0x30, 0x40, 0x50, 0x60}, 6, -55, ENC_TYPE_CCMP};
+  WiFi.aps.push_back(home);
+
+  unsigned long start = millis();
+  wm.setConfigPortalBlocking(false);
+  wm.startCustomConfigPortal();
+  CHECK(wm.isConfigPortalActive());
+  printf("portal start : %lu ms\n", millis() - start);
+
+  nextSample = millis();
+  browse();
+  save();
+
+  // No blocking call in the portal : every sample on time
+  CHECK(worstStall == 0);
+  CHECK(worstLate < PASS_MS);
+  CHECK(worstHost * 1000 < SAMPLE_MS);
+  printf("%d passes, %d samples, %zu requests : process() %.1f us mean, %.1f us worst, samples %lu ms late at worst\n",
+    passes, samples, ESP8266WebServer::responses.size(), hostTime * 1e6 / passes, worstHost * 1e6, worstLate);
+  return TEST_END();
+}
@@ -0,0 +1,113 @@
+#include <WiFiManager.h>
+#include "test.h"
+
+static const unsigned long PASS_MS = 1;
+
+static const ESP8266WiFiClass::AccessPoint_t HOME = {"home", {0x10, 0x20, 0x30, 0x40, 0x50, 0x60}, 6, -55, ENC_TYPE_CCMP};
+/* The same network after the router was replaced */
+static const ESP8266WiFiClass::AccessPoint_t MOVED = {"home", {0x10, 0x20, 0x30, 0x40, 0x50, 0x61}, 11, -60, ENC_TYPE_CCMP};
+
+/* Boot, then the main loop until the first packet can go : checkWifiStatus()
+ * reconnects and saves the cache once up */
+static unsigned long timeToFirstPacket(uint32_t reason)
+{
+  ESP.boot(reason);
+  WiFi.boot();
+  WiFiManager wm;
+  unsigned long start = millis();
+  CHECK(wm.reconnect());
+  while (WiFi.status() != WL_CONNECTED && millis() - start < 60000) {
+    wm.processReconnect();
+    delay(PASS_MS);
+  }
+  CHECK(WiFi.status() == WL_CONNECTED);
+  wm.saveConnectionCache();
+  return millis() - start;
+}
+
+static void setNetwork(const ESP8266WiFiClass::AccessPoint_t& ap)
+{
+  WiFi.aps.clear();
+  WiFi.aps.push_back(ap);
+}
+
+static void cache()
+{
+  unsigned long full = WiFi.scanMs + WiFi.associateMs + WiFi.dhcpMs;
+  unsigned long fast = WiFi.associateMs;
+  setNetwork(HOME);
+  WiFi.begin("home", "secret");
+  WiFi.dropLink();
+
+  // Nothing cached yet : scan and DHCP, then the tuple goes to flash
+  CHECK(timeToFirstPacket(REASON_DEFAULT_RST) <= full + PASS_MS);
+  CHECK(EEPROM.commits == 1);
+
+  // Power cycle : RTC memory is lost, the flash copy is used
+  CHECK(timeToFirstPacket(REASON_DEFAULT_RST) <= fast + PASS_MS);
+  CHECK(timeToFirstPacket(REASON_EXT_SYS_RST) <= fast + PASS_MS);
+  // Same tuple, flash is not written again
+  CHECK(EEPROM.commits == 1);
+
+  // Deep sleep wake : RTC memory first, even without the flash copy
+  std::vector<uint8_t> sector = EEPROM.sector;
+  EEPROM.sector.assign(sector.size(), 0xff);
+  CHECK(timeToFirstPacket(REASON_DEEP_SLEEP_AWAKE) <= fast + PASS_MS);
+  // Written back since it was missing
+  CHECK(EEPROM.commits == 2 && EEPROM.sector == sector);
+
+  // Scrambled RTC memory after a deep sleep : flash
+  for (int i = 0; i < 128; i++) {
+    ESP.rtcMemory[i] = rand();
+  }
+  CHECK(timeToFirstPacket(REASON_DEEP_SLEEP_AWAKE) <= fast + PASS_MS);
+
+  // Router replaced : the cached BSSID is tried for the fast connect timeout,
+  // cleared, then the usual way, and the new tuple is saved
+  setNetwork(MOVED);
+  CHECK(timeToFirstPacket(REASON_DEFAULT_RST) <= 2000 + full + 2 * PASS_MS);
+  CHECK(EEPROM.commits == 4);
+  CHECK(timeToFirstPacket(REASON_DEFAULT_RST) <= fast + PASS_MS);
+  CHECK(EEPROM.commits == 4);
+
+  // Reconnects while running do not write flash either
+  WiFiManager wm;
+  for (int i = 0; i < 100; i++) {
+    WiFi.dropLink();
+    wm.reconnect();
+    while (!wm.processReconnect()) {
+      delay(PASS_MS);
+    }
+    wm.saveConnectionCache();
+  }
+  CHECK(EEPROM.commits == 4);
+}
+
+/* Time to first packet, cached tuple against scan and DHCP */
+static void latencies()
+{
+  static const unsigned long SCAN_MS[] = {1000, 2500, 4000};
+  static const unsigned long DHCP_MS[] = {200, 1000, 3000};
+
+  setNetwork(HOME);
+  printf("scan ms  dhcp ms  cold boot ms  cached ms\n");
+  for (size_t s = 0; s < sizeof(SCAN_MS) / sizeof(SCAN_MS[0]); s++) {
+    for (size_t d = 0; d < sizeof(DHCP_MS) / sizeof(DHCP_MS[0]); d++) {
+      WiFi.scanMs = SCAN_MS[s];
+      WiFi.dhcpMs = DHCP_MS[d];
+      EEPROM.sector.assign(EEPROM.sector.size(), 0xff);
+      unsigned long full = timeToFirstPacket(REASON_DEFAULT_RST);
+      unsigned long cached = timeToFirstPacket(REASON_DEFAULT_RST);
+      CHECK(full > cached);
+      CHECK(cached <= WiFi.associateMs + PASS_MS);
+      printf("%7lu  %7lu  %12lu  %9lu\n", SCAN_MS[s], DHCP_MS[d], full, cached);
+    }
+  }
+}
+
+int main()
+{
+  cache();
+  latencies();
+  return TEST_END();
+}
@@ -0,0 +1,166 @@
+#include <WiFiManager.h>
+#include <DNSServer.h>
+#include <ESP8266WebServer.h>
+#include <map>
+#include <set>
+#include <string>
+#include "test.h"
+
+static const int PAGE_LOADS = 50;
+
+static uint32_t seed = 1;
+
+static uint32_t random32()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+/* count access points over count / 3 SSIDs, so most have duplicates */
+static void fillScan(int count)
+{
+  WiFi.aps.clear();
+  for (int i = 0; i < count; i++) {
+    ESP8266WiFiClass::AccessPoint_t ap;
+    char ssid[16];
+    snprintf(ssid, sizeof(ssid), "net%03d", (int)(random32() % (count / 3 + 1)));
+    ap.ssid = ssid;
+    memset(ap.bssid, i, sizeof(ap.bssid));
+    ap.channel = 1 + random32() % 13;
+    ap.rssi = -40 - (int32_t)(random32() % 59);
+    ap.encryption = random32() % 4 == 0 ? ENC_TYPE_NONE : ENC_TYPE_CCMP;
+    WiFi.aps.push_back(ap);
+  }
+}
+
+/* What the page has to list : the strongest entry of each SSID, found the
+ * quadratic way */
+static std::vector<ESP8266WiFiClass::AccessPoint_t> expected()
+{
+  std::vector<ESP8266WiFiClass::AccessPoint_t> kept;
+  for (size_t i = 0; i < WiFi.aps.size(); i++) {
+    bool strongest = true;
+    for (size_t j = 0; j < WiFi.aps.size(); j++) {
+      if (j != i && WiFi.aps[j].ssid == WiFi.aps[i].ssid
+          && (WiFi.aps[j].rssi > WiFi.aps[i].rssi || (WiFi.aps[j].rssi == WiFi.aps[i].rssi && j < i))) {
+        strongest = false;
+      }
+    }
+    if (strongest) {
+      kept.push_back(WiFi.aps[i]);
+    }
+  }
+  return kept;
+}
+
+static double load(WiFiManager& wm, const char* uri)
+{
+  size_t served = ESP8266WebServer::responses.size();
+  ESP8266WebServer::request(uri);
+  double start = testSeconds();
+  wm.process();
+  double elapsed = testSeconds() - start;
+  CHECK(ESP8266WebServer::responses.size() == served + 1);
+  return elapsed;
+}
+
+static void scan(int count)
+{
+  WiFiManager wm;
+  fillScan(count);
+  wm.setConfigPortalBlocking(false);
+  wm.setScanCacheTTL(10);
+  int scans = WiFi.scans;
+  wm.startConfigPortal("portal");
+  // Started with the portal, in the background
+  CHECK(WiFi.scans == scans + 1);
+
+  // Before the results : answered at once, no scan started again
+  load(wm, "/wifi");
+  CHECK(ESP8266WebServer::responses.back().body.find("Scanning") != std::string::npos);
+  CHECK(WiFi.scans == scans + 1);
+
+  // Picked up by the loop once done, then every page load within the TTL is
+  // served from the cache
+  delay(WiFi.scanMs);
+  wm.process();
+  double total = 0;
+  double worst = 0;
+  for (int i = 0; i < PAGE_LOADS; i++) {
+    double t = load(wm, "/wifi");
+    total += t;
+    worst = t > worst ? t : worst;
+    delay(100);
+  }
+  CHECK(WiFi.scans == scans + 1);
+
+  // Listed once per SSID with its strongest signal, in order of RSSI
+  const std::string& page = ESP8266WebServer::responses.back().body;
+  std::vector<ESP8266WiFiClass::AccessPoint_t> kept = expected();
+  std::vector<std::pair<std::string, int> > items;
+  for (size_t at = page.find("onclick='c(this)'>"); at != std::string::npos; at = page.find("onclick='c(this)'>", at + 1)) {
+    size_t name = at + strlen("onclick='c(this)'>");
+    size_t q = page.find("'>", page.find("class='q", name)) + 2;
+    items.push_back(std::make_pair(page.substr(name, page.find('<', name) - name), atoi(page.c_str() + q)));
+  }
+  CHECK(items.size() == kept.size());
+  std::map<std::string, int> strongest;
+  for (size_t i = 0; i < kept.size(); i++) {
+    strongest[kept[i].ssid.c_str()] = kept[i].rssi >= -50 ? 100 : 2 * (kept[i].rssi + 100);
+  }
+  std::set<std::string> seen;
+  for (size_t i = 0; i < items.size(); i++) {
+    CHECK(strongest.count(items[i].first) == 1 && strongest[items[i].first] == items[i].second);
+    CHECK(seen.insert(items[i].first).second);
+    CHECK(i == 0 || items[i].second <= items[i - 1].second);
+  }
+
+  // Past the TTL a page load starts a new scan and still shows the cache
+  delay(10000);
+  load(wm, "/wifi");
+  CHECK(WiFi.scans == scans + 2);
+  CHECK(ESP8266WebServer::responses.back().body.find("onclick=") != std::string::npos);
+
+  printf("%4d access points, %3zu SSIDs : /wifi %.0f us mean, %.0f us worst, %zu bytes\n",
+    count, items.size(), total * 1e6 / PAGE_LOADS, worst * 1e6, page.size());
+  ESP8266WebServer::responses.clear();
+}
+
+/* Scan results copied, sorted and deduplicated in one loop pass */
+static void update(int count)
+{
+  static const int RUNS = 20;
+  WiFiManager wm;
+  fillScan(count);
+  wm.setConfigPortalBlocking(false);
+  wm.startConfigPortal("portal");
+  double worst = 0;
+  for (int i = 0; i < RUNS; i++) {
+    delay(WiFi.scanMs);
+    double start = testSeconds();
+    wm.process();
+    double t = testSeconds() - start;
+    worst = t > worst ? t : worst;
+    // Next scan
+    delay(10000);
+    load(wm, "/wifi");
+  }
+  printf("%4d access points : scan results picked up in %.0f us worst\n", count, worst * 1e6);
+  ESP8266WebServer::responses.clear();
+}
+
+int main()
+{
+  // The core counts scan results in an int8_t : past 127 the figures only
+  // show how the handler scales
+  int counts[] = {20, 100, 300, 1000};
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+    scan(counts[i]);
+  }
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+    update(counts[i]);
+  }
+  return TEST_END();
+}
@@ -0,0 +1,134 @@
+#include <FecDecoder.h>
+#include <string.h>
+#include <libpomp.h>
+#include <pomp_priv.h>
+#include <Types.h>
+
+FecDecoder::FecDecoder(){
+  reset();
+}
+
+void FecDecoder::reset()
+{
+  memset(_slots, 0, sizeof(_slots));
+  memset(_groups, 0, sizeof(_groups));
+  _nextGroup = 0;
+  _started = false;
+  _session = 0;
+  _recovered = 0;
+}
+
+uint32_t FecDecoder::getRecovered()
+{
+  return _recovered;
+}
+
+size_t FecDecoder::receive(const void* data, size_t len, uint8_t* out)
+{
+  struct pomp_decoder dec = POMP_DECODER_INITIALIZER;
+  uint32_t msgid = 0;
+  uint32_t session = 0;
+  uint32_t seq = 0;
+  size_t res = 0;
+
+  if (pomp_decoder_init_with_data(&dec, data, len, &msgid) < 0
+      || pomp_decoder_read_u32(&dec, &session) < 0
+      || pomp_decoder_read_u32(&dec, &seq) < 0) {
+    goto out;
+  }
+  checkSession(session);
+
+  if (msgid == MSG_FEC) {
+    Group_t& group = _groups[_nextGroup];
+    const void* parity = NULL;
+    uint32_t parityLen = 0;
+
+    if (pomp_decoder_read_u32(&dec, &group.k) < 0
+        || pomp_decoder_read_u32(&dec, &group.lenXor) < 0
+        || pomp_decoder_read_cbuf(&dec, &parity, &parityLen) < 0
+        || parityLen > MAX_SIZE || group.k == 0 || group.k > HISTORY / 2) {
+      group.used = false;
+      goto out;
+    }
+    _nextGroup = (_nextGroup + 1) % GROUPS;
+    group.used = true;
+    group.firstSeq = seq;
+    group.len = parityLen;
+    memcpy(group.parity, parity, parityLen);
+    res = recover(group, out);
+  } else if (len <= MAX_SIZE) {
+    store(seq, data, len);
+    for (int i = 0; i < GROUPS; i++) {
+      Group_t& group = _groups[i];
+      if (group.used && seq - group.firstSeq < group.k) {
+        res = recover(group, out);
+        break;
+      }
+    }
+  }
+
+out:
+  pomp_decoder_clear(&dec);
+  return res;
+}
+
+void FecDecoder::checkSession(uint32_t session)
+{
+  // Device restarted, sequence numbers start over
+  if (!_started || session != _session) {
+    memset(_slots, 0, sizeof(_slots));
+    memset(_groups, 0, sizeof(_groups));
+    _started = true;
+    _session = session;
+  }
+}
+
+void FecDecoder::store(uint32_t seq, const void* data, size_t len)
+{
+  Slot_t& slot = _slots[seq % HISTORY];
+  slot.used = true;
+  slot.seq = seq;
+  slot.len = len;
+  memcpy(slot.data, data, len);
+}
+
+size_t FecDecoder::recover(Group_t& group, uint8_t* out)
+{
+  uint32_t missing = 0;
+  uint32_t missingCount = 0;
+
+  for (uint32_t i = 0; i < group.k; i++) {
+    const Slot_t& slot = _slots[(group.firstSeq + i) % HISTORY];
+    if (!slot.used || slot.seq != group.firstSeq + i) {
+      missing = group.firstSeq + i;
+      missingCount++;
+    }
+  }
+  if (missingCount != 1) {
+    // Complete, nothing to do, or too many losses to ever rebuild
+    if (missingCount == 0) {
+      group.used = false;
+    }
+    return 0;
+  }
+
+  uint32_t len = group.lenXor;
+  memcpy(out, group.parity, group.len);
+  for (uint32_t i = 0; i < group.k; i++) {
+    if (group.firstSeq + i == missing) {
+      continue;
+    }
+    const Slot_t& slot = _slots[(group.firstSeq + i) % HISTORY];
+    for (uint32_t j = 0; j < slot.len; j++) {
+      out[j] ^= slot.data[j];
+    }
+    len ^= slot.len;
+  }
+  group.used = false;
+  if (len == 0 || len > group.len) {
+    return 0;
+  }
+  store(missing, out, len);
+  _recovered++;
+  return len;
+}
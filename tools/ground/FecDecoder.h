@@ -0,0 +1,50 @@
+#ifndef FecDecoder_h
+#define FecDecoder_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Ground side counterpart of MessagesManager::setFEC. Feed it every received
+ * datagram, MSG_FEC ones included : once a group is missing exactly one
+ * message and its parity is known, the lost message is rebuilt as it was sent
+ * and can be handled like a received one. MSG_FEC messages are not numbered,
+ * do not give them to SequenceTracker. */
+class FecDecoder {
+public:
+  static const int MAX_SIZE = 256;  /* MessagesManager::FEC_MAX_SIZE */
+  static const int HISTORY = 64;    /* Messages kept, covers groups + reordering */
+  static const int GROUPS = 4;      /* Parity messages waiting for their group */
+
+  FecDecoder();
+  /* Returns the size of the message rebuilt into out (MAX_SIZE bytes), 0 if
+   * this datagram did not allow rebuilding one */
+  size_t receive(const void* data, size_t len, uint8_t* out);
+  uint32_t getRecovered();
+  void reset();
+private:
+  typedef struct {
+    bool used;
+    uint32_t seq;
+    uint16_t len;
+    uint8_t data[MAX_SIZE];
+  } Slot_t;
+  typedef struct {
+    bool used;
+    uint32_t firstSeq;
+    uint32_t k;
+    uint32_t lenXor;
+    uint16_t len;
+    uint8_t parity[MAX_SIZE];
+  } Group_t;
+  Slot_t _slots[HISTORY];
+  Group_t _groups[GROUPS];
+  int _nextGroup;
+  bool _started;
+  uint32_t _session;
+  uint32_t _recovered;
+  void checkSession(uint32_t session);
+  void store(uint32_t seq, const void* data, size_t len);
+  size_t recover(Group_t& group, uint8_t* out);
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include <SequenceTracker.h>
+#include <string.h>
+
+SequenceTracker::SequenceTracker(){
+  reset();
+}
+
+void SequenceTracker::reset()
+{
+  memset(_bitmap, 0, sizeof(_bitmap));
+  memset(&_stats, 0, sizeof(_stats));
+  _started = false;
+  _session = 0;
+  _highest = 0;
+  _lastArrival = 0;
+  _interval = -1;
+  _jitter = 0;
+}
+
+void SequenceTracker::update(uint32_t session, uint32_t seq, uint64_t arrival)
+{
+  if (!_started || session != _session) {
+    startSession(session, seq);
+  } else {
+    // Signed distance copes with the sequence number wrapping
+    int32_t diff = (int32_t)(seq - _highest);
+
+    if (diff > 0) {
+      advance(seq);
+    } else if ((uint32_t)-diff >= WINDOW) {
+      _stats.late++;
+      return;
+    } else if (testAndSet(seq)) {
+      _stats.duplicates++;
+      return;
+    } else {
+      _stats.reordered++;
+      if ((uint32_t)-diff > _stats.maxReorderDepth) {
+        _stats.maxReorderDepth = -diff;
+      }
+    }
+  }
+  _stats.received++;
+
+  // Smoothed like the RFC 3550 jitter, values kept x16 to stay in integers
+  if (_lastArrival != 0) {
+    int64_t interval = (int64_t)(arrival - _lastArrival) * 16;
+    if (_interval < 0) {
+      _interval = interval;
+    }
+    int64_t deviation = interval > _interval ? interval - _interval : _interval - interval;
+    _jitter += (deviation - _jitter) / 16;
+    _interval += (interval - _interval) / 16;
+  }
+  _lastArrival = arrival;
+}
+
+SequenceStats_t SequenceTracker::getStats()
+{
+  SequenceStats_t stats = _stats;
+  stats.jitter = (uint32_t)(_jitter / 16);
+  return stats;
+}
+
+void SequenceTracker::startSession(uint32_t session, uint32_t seq)
+{
+  // Numbers before the first one seen are not counted as lost
+  memset(_bitmap, 0xff, sizeof(_bitmap));
+  _started = true;
+  _session = session;
+  _highest = seq;
+  _lastArrival = 0;
+  _interval = -1;
+  _stats.sessions++;
+}
+
+void SequenceTracker::advance(uint32_t seq)
+{
+  uint32_t distance = seq - _highest;
+
+  if (distance >= WINDOW) {
+    // Whole window leaves, plus the numbers jumped over entirely
+    for (uint32_t i = 0; i < WORDS; i++) {
+      _stats.lost += 64 - __builtin_popcountll(_bitmap[i]);
+      _bitmap[i] = 0;
+    }
+    _stats.lost += distance - WINDOW;
+  } else {
+    // Slot of each new number still holds the one WINDOW before it
+    for (uint32_t i = 1; i <= distance; i++) {
+      uint32_t slot = (_highest + i) % WINDOW;
+      uint64_t mask = 1ULL << (slot % 64);
+      if (!(_bitmap[slot / 64] & mask)) {
+        _stats.lost++;
+      }
+      _bitmap[slot / 64] &= ~mask;
+    }
+  }
+  _highest = seq;
+  testAndSet(seq);
+}
+
+bool SequenceTracker::testAndSet(uint32_t seq)
+{
+  uint32_t slot = seq % WINDOW;
+  uint64_t mask = 1ULL << (slot % 64);
+  bool wasSet = (_bitmap[slot / 64] & mask) != 0;
+
+  _bitmap[slot / 64] |= mask;
+  return wasSet;
+}
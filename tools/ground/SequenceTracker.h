@@ -0,0 +1,46 @@
+#ifndef SequenceTracker_h
+#define SequenceTracker_h
+
+#include <stdint.h>
+
+/* Ground side accounting of the session/sequence numbers MessagesManager puts
+ * at the start of every message. Keep one tracker per device. Received
+ * sequence numbers are kept in a WINDOW bits sliding bitmap : a number is
+ * counted lost once it leaves the window without having been seen, so update()
+ * costs O(1) amortized. */
+typedef struct {
+  uint32_t received;
+  uint32_t lost;
+  uint32_t duplicates;
+  uint32_t reordered;      // arrived after a higher sequence number
+  uint32_t late;           // arrived after leaving the window, already lost
+  uint32_t maxReorderDepth;
+  uint32_t sessions;       // device restarts seen
+  uint32_t jitter;         // [us] mean deviation of the inter-arrival time
+} SequenceStats_t;
+
+class SequenceTracker {
+public:
+  static const uint32_t WINDOW = 256;
+
+  SequenceTracker();
+  /* arrival : receive time [us], only used for the jitter */
+  void update(uint32_t session, uint32_t seq, uint64_t arrival);
+  SequenceStats_t getStats();
+  void reset();
+private:
+  static const uint32_t WORDS = WINDOW / 64;
+  uint64_t _bitmap[WORDS];
+  bool _started;
+  uint32_t _session;
+  uint32_t _highest;
+  uint64_t _lastArrival;
+  int64_t _interval;       // [us/16] smoothed inter-arrival time
+  int64_t _jitter;         // [us/16]
+  SequenceStats_t _stats;
+  void startSession(uint32_t session, uint32_t seq);
+  void advance(uint32_t seq);
+  bool testAndSet(uint32_t seq);
+};
+
+#endif